@@ -0,0 +1,124 @@
+#include <time.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "auction.h"
+
+/**
+ * Uncross a call auction with a large number of collected orders.
+ *
+ *   bench_auction [orders] [ticks] [iterations]
+ *
+ * Half the orders are buys and half sells, spread over the ticks that
+ * cross. Each iteration builds the curves with an entry for every order,
+ * then finds the equilibrium. The order book adds an entry for every
+ * price level instead, so this is its worst case, every order at a price
+ * of its own; bench_orderbook times the book itself, fills included.
+ * Results are printed as JSON.
+ */
+namespace
+{
+  struct Level
+  {
+    long tick ;
+    long qty ;
+  };
+
+  bool descending( const Level &left, const Level &right )
+  {
+    return left.tick > right.tick ;
+  }
+
+  bool ascending( const Level &left, const Level &right )
+  {
+    return left.tick < right.tick ;
+  }
+
+  long long now()
+  {
+    timespec time ;
+    clock_gettime( CLOCK_MONOTONIC, &time ) ;
+    return time.tv_sec * 1000000000LL + time.tv_nsec ;
+  }
+
+  long long median( std::vector< long long > samples )
+  {
+    std::sort( samples.begin(), samples.end() ) ;
+    return samples[ samples.size() / 2 ] ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  long orders = argc > 1 ? atol( argv[1] ) : 1000000 ;
+  long ticks = argc > 2 ? atol( argv[2] ) : 1000 ;
+  long iterations = argc > 3 ? atol( argv[3] ) : 20 ;
+
+  srand( 42 ) ;
+  std::vector< Level > buys( orders / 2 ) ;
+  std::vector< Level > sells( orders - orders / 2 ) ;
+  for( size_t i = 0 ; i < buys.size() ; ++i )
+  {
+    buys[i].tick = rand() % ticks ;
+    buys[i].qty = 1 + rand() % 100 ;
+  }
+  for( size_t i = 0 ; i < sells.size() ; ++i )
+  {
+    sells[i].tick = rand() % ticks ;
+    sells[i].qty = 1 + rand() % 100 ;
+  }
+  // In book order: best buy first, best sell first.
+  std::stable_sort( buys.begin(), buys.end(), descending ) ;
+  std::stable_sort( sells.begin(), sells.end(), ascending ) ;
+
+  ESM::Auction auction ;
+  ESM::AuctionResult result ;
+  std::vector< long long > buildTimes ;
+  std::vector< long long > uncrossTimes ;
+
+  for( long i = 0 ; i < iterations ; ++i )
+  {
+    long long start = now() ;
+    auction.reset( sells.front().tick, buys.front().tick ) ;
+    for( std::vector< Level >::const_iterator iBuy = buys.begin() ;
+         iBuy != buys.end() ;
+         ++iBuy )
+    {
+      auction.addBuy( iBuy->tick, iBuy->qty ) ;
+    }
+    for( std::vector< Level >::const_iterator iSell = sells.begin() ;
+         iSell != sells.end() ;
+         ++iSell )
+    {
+      auction.addSell( iSell->tick, iSell->qty ) ;
+    }
+    long long built = now() ;
+    result = auction.uncross( ticks / 2 ) ;
+    long long done = now() ;
+
+    buildTimes.push_back( built - start ) ;
+    uncrossTimes.push_back( done - built ) ;
+  }
+
+  long long buildNs = median( buildTimes ) ;
+  long long uncrossNs = median( uncrossTimes ) ;
+
+  std::cout << "{\n"
+            << "  \"benchmark\": \"auction_uncross\",\n"
+            << "  \"orders\": " << orders << ",\n"
+            << "  \"ticks\": " << ticks << ",\n"
+            << "  \"iterations\": " << iterations << ",\n"
+            << "  \"curve_build_ns_median\": " << buildNs << ",\n"
+            << "  \"uncross_ns_median\": " << uncrossNs << ",\n"
+            << "  \"orders_per_second\": "
+            << ( buildNs + uncrossNs > 0
+                 ? orders * 1000000000LL / ( buildNs + uncrossNs ) : 0 ) << ",\n"
+            << "  \"equilibrium_tick\": " << result.tick << ",\n"
+            << "  \"volume\": " << result.volume << ",\n"
+            << "  \"imbalance\": " << result.imbalance << "\n"
+            << "}" << std::endl ;
+  return 0 ;
+}
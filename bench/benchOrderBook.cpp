@@ -0,0 +1,457 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "executionSinks.h"
+#include "market.h"
+
+/**
+ * Drive the order book & the market with synthetic flow.
+ *
+ *   bench_orderbook [orders] [symbols] [cascade depth]
+ *
+ * Scenarios, each timing every call on its own:
+ * * passive_add : orders that do not cross, building a deep book
+ * * cancel : half of those orders, in random order
+ * * aggressive_sweep : orders taking several levels of the deep book
+ * * stop_cascade : an order triggering a chain of stop orders, each one
+ *   trading at the next level & triggering the next
+ * * call_collect : crossing orders collected by a book in a call auction
+ * * call_indicative : the indicative price of that call, worked out once
+ *   as the market picture does
+ * * call_uncross : the end of that call, executing the crossing orders
+ * * symbol_create : the first order of every symbol, creating its book
+ * * symbol_add : a second order for every symbol
+ *
+ * Orders are built before the clock starts and replies go to a null
+ * sink, so only the engine is measured, allocations included. Results are
+ * printed as JSON with the throughput, latency percentiles, heap
+ * allocations per operation & the resident memory after each scenario.
+ */
+namespace
+{
+  long long allocations = 0 ;
+
+  /**
+   * Every form of operator new & delete comes here, so that the counter
+   * sees all of them and each delete matches its new.
+   */
+  void *allocate( size_t size )
+  {
+    __sync_fetch_and_add( &allocations, 1 ) ;
+    return malloc( size ? size : 1 ) ;
+  }
+}
+
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#else
+#define BENCH_THROW_BAD_ALLOC throw( std::bad_alloc )
+#endif
+
+void *operator new( size_t size ) BENCH_THROW_BAD_ALLOC
+{
+  void *memory = allocate( size ) ;
+  if( memory == 0 )
+  {
+    throw std::bad_alloc() ;
+  }
+  return memory ;
+}
+
+void *operator new[]( size_t size ) BENCH_THROW_BAD_ALLOC
+{
+  return operator new( size ) ;
+}
+
+void *operator new( size_t size, const std::nothrow_t & ) throw()
+{
+  return allocate( size ) ;
+}
+
+void *operator new[]( size_t size, const std::nothrow_t & ) throw()
+{
+  return allocate( size ) ;
+}
+
+void operator delete( void *memory ) throw()
+{
+  free( memory ) ;
+}
+
+void operator delete[]( void *memory ) throw()
+{
+  free( memory ) ;
+}
+
+void operator delete( void *memory, const std::nothrow_t & ) throw()
+{
+  free( memory ) ;
+}
+
+void operator delete[]( void *memory, const std::nothrow_t & ) throw()
+{
+  free( memory ) ;
+}
+
+#if __cplusplus >= 201402L
+void operator delete( void *memory, size_t ) throw()
+{
+  free( memory ) ;
+}
+
+void operator delete[]( void *memory, size_t ) throw()
+{
+  free( memory ) ;
+}
+#endif
+
+namespace
+{
+  long long now()
+  {
+    timespec time ;
+    clock_gettime( CLOCK_MONOTONIC, &time ) ;
+    return time.tv_sec * 1000000000LL + time.tv_nsec ;
+  }
+
+  long residentKb()
+  {
+    long pages = 0 ;
+    long resident = 0 ;
+    FILE *statm = fopen( "/proc/self/statm", "r" ) ;
+    if( statm != 0 )
+    {
+      if( fscanf( statm, "%ld %ld", &pages, &resident ) != 2 )
+      {
+        resident = 0 ;
+      }
+      fclose( statm ) ;
+    }
+    return resident * ( sysconf( _SC_PAGESIZE ) / 1024 ) ;
+  }
+
+  /**
+   * The timings of one scenario.
+   */
+  class Scenario
+  {
+    public :
+      explicit Scenario( const std::string &name )
+        : _name( name ),
+          _allocated( 0 ),
+          _allocations( 0 ),
+          _start( 0 )
+      {
+      }
+
+      /**
+       * @brief Time an operation, from here to stop().
+       */
+      void start()
+      {
+        _allocations = allocations ;
+        _start = now() ;
+      }
+
+      void stop()
+      {
+        _latencies.push_back( now() - _start ) ;
+        _allocated += allocations - _allocations ;
+      }
+
+      void print( bool isLast )
+      {
+        long operations = _latencies.size() ;
+        std::sort( _latencies.begin(), _latencies.end() ) ;
+
+        long long total = 0 ;
+        for( std::vector< long long >::const_iterator iLatency = _latencies.begin() ;
+             iLatency != _latencies.end() ;
+             ++iLatency )
+        {
+          total += *iLatency ;
+        }
+
+        std::cout << "    {\n"
+                  << "      \"scenario\": \"" << _name << "\",\n"
+                  << "      \"operations\": " << operations << ",\n"
+                  << "      \"operations_per_second\": "
+                  << ( total > 0 ? operations * 1000000000LL / total : 0 ) << ",\n"
+                  << "      \"p50_ns\": " << percentile( 0.5 ) << ",\n"
+                  << "      \"p99_ns\": " << percentile( 0.99 ) << ",\n"
+                  << "      \"p99_9_ns\": " << percentile( 0.999 ) << ",\n"
+                  << "      \"max_ns\": "
+                  << ( operations > 0 ? _latencies.back() : 0 ) << ",\n"
+                  << "      \"allocations_per_operation\": "
+                  << ( operations > 0 ? double( _allocated ) / operations : 0 ) << ",\n"
+                  << "      \"rss_kb\": " << residentKb() << "\n"
+                  << "    }" << ( isLast ? "" : "," ) << std::endl ;
+      }
+
+    private :
+      std::string _name ;
+      std::vector< long long > _latencies ;
+      long long _allocated ;
+      long long _allocations ;
+      long long _start ;
+
+      long long percentile( double fraction ) const
+      {
+        if( _latencies.empty() )
+        {
+          return 0 ;
+        }
+        size_t index = static_cast< size_t >( fraction * _latencies.size() ) ;
+        return _latencies[ std::min( index, _latencies.size() - 1 ) ] ;
+      }
+  };
+
+  ESM::NewOrderPtr makeOrder( const std::string &securityId,
+                              ESM::Side side,
+                              ESM::OrderType orderType,
+                              long qty,
+                              long price )
+  {
+    ESM::NewOrderPtr order( new ESM::NewOrder( securityId, "bench", "BENCH",
+                                               side, orderType, qty ) ) ;
+    if( orderType == ESM::OrderType_LIMIT )
+    {
+      order->setPrice( price ) ;
+    }
+    return order ;
+  }
+
+  std::string toSecurityId( long symbol )
+  {
+    std::ostringstream securityId ;
+    securityId << 100000 + symbol ;
+    return securityId.str() ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  long orders = argc > 1 ? atol( argv[1] ) : 1000000 ;
+  long symbols = argc > 2 ? atol( argv[2] ) : 100000 ;
+  long depth = argc > 3 ? atol( argv[3] ) : 20 ;
+
+  const long MidPrice = 100000 ;
+  const long Levels = 1000 ;
+
+  srand( 42 ) ;
+  ESM::NullExecutionSink sink ;
+  ESM::PriceBand priceBand ;
+
+  std::cout << "{\n"
+            << "  \"benchmark\": \"orderbook\",\n"
+            << "  \"orders\": " << orders << ",\n"
+            << "  \"symbols\": " << symbols << ",\n"
+            << "  \"cascade_depth\": " << depth << ",\n"
+            << "  \"results\": [\n" ;
+
+  // One deep book of buys below the mid price.
+  std::vector< ESM::OrderPtr > restingOrders ;
+  restingOrders.reserve( orders ) ;
+  for( long i = 0 ; i < orders ; ++i )
+  {
+    restingOrders.push_back( makeOrder( "1", ESM::Side_BUY, ESM::OrderType_LIMIT,
+                                        1 + rand() % 100,
+                                        MidPrice - 1 - rand() % Levels ) ) ;
+  }
+
+  ESM::OrderBook orderBook( sink, restingOrders.front(), priceBand,
+                            ESM::TradingPhase_CONTINUOUS ) ;
+  {
+    Scenario scenario( "passive_add" ) ;
+    for( long i = 0 ; i < orders ; ++i )
+    {
+      scenario.start() ;
+      orderBook.insert( restingOrders[i] ) ;
+      scenario.stop() ;
+    }
+    scenario.print( false ) ;
+  }
+
+  {
+    std::vector< ESM::OrderPtr > cancels ;
+    cancels.reserve( orders / 2 ) ;
+    for( long i = 0 ; i < orders / 2 ; ++i )
+    {
+      const ESM::OrderPtr &order = restingOrders[i] ;
+      cancels.push_back( ESM::CancelOrderPtr(
+          new ESM::CancelOrder( order->getOrderId(), order->getClientOrderId(),
+                                order->getSecurityId(), "cancel",
+                                order->getSenderId(), order->getSide(),
+                                order->getOrderType(), order->getOrderQty() ) ) ) ;
+    }
+    // Fisher-Yates, on the rand() seeded above.
+    for( size_t i = cancels.size() ; i > 1 ; --i )
+    {
+      std::swap( cancels[ i - 1 ], cancels[ rand() % i ] ) ;
+    }
+
+    Scenario scenario( "cancel" ) ;
+    for( std::vector< ESM::OrderPtr >::const_iterator iOrder = cancels.begin() ;
+         iOrder != cancels.end() ;
+         ++iOrder )
+    {
+      scenario.start() ;
+      orderBook.cancel( *iOrder ) ;
+      scenario.stop() ;
+    }
+    scenario.print( false ) ;
+  }
+
+  {
+    // Each sell takes about ten orders, over one or more levels.
+    long sweeps = std::max( 1L, orders / 100 ) ;
+    std::vector< ESM::OrderPtr > sells ;
+    for( long i = 0 ; i < sweeps ; ++i )
+    {
+      sells.push_back( makeOrder( "1", ESM::Side_SELL, ESM::OrderType_LIMIT,
+                                  500, MidPrice - Levels ) ) ;
+    }
+
+    Scenario scenario( "aggressive_sweep" ) ;
+    for( long i = 0 ; i < sweeps ; ++i )
+    {
+      scenario.start() ;
+      orderBook.insert( sells[i] ) ;
+      scenario.stop() ;
+    }
+    scenario.print( false ) ;
+  }
+
+  {
+    // Every round has its own book: sells one tick apart, a stop buy at
+    // each of them, and a buy taking the first sell.
+    long rounds = std::max( 1L, std::min( orders / depth, 1000L ) ) ;
+    Scenario scenario( "stop_cascade" ) ;
+    for( long round = 0 ; round < rounds ; ++round )
+    {
+      std::string securityId = toSecurityId( round ) ;
+      ESM::OrderPtr first = makeOrder( securityId, ESM::Side_SELL,
+                                       ESM::OrderType_LIMIT, 1, MidPrice ) ;
+      ESM::PriceBand cascadeBand ;
+      ESM::OrderBook cascadeBook( sink, first, cascadeBand,
+                                  ESM::TradingPhase_CONTINUOUS ) ;
+      for( long level = 0 ; level <= depth ; ++level )
+      {
+        cascadeBook.insert( makeOrder( securityId, ESM::Side_SELL,
+                                       ESM::OrderType_LIMIT, 1,
+                                       MidPrice + level ) ) ;
+      }
+      for( long level = 0 ; level < depth ; ++level )
+      {
+        ESM::OrderPtr stop = makeOrder( securityId, ESM::Side_BUY,
+                                        ESM::OrderType_STOP, 1, 0 ) ;
+        stop->setStopPrice( MidPrice + level ) ;
+        cascadeBook.insert( stop ) ;
+      }
+      ESM::OrderPtr trigger = makeOrder( securityId, ESM::Side_BUY,
+                                         ESM::OrderType_LIMIT, 1, MidPrice ) ;
+
+      scenario.start() ;
+      cascadeBook.insert( trigger ) ;
+      scenario.stop() ;
+    }
+    scenario.print( false ) ;
+  }
+
+  {
+    // Buys & sells over the same levels, so that the whole range crosses.
+    long collected = std::max( 2L, orders / 10 ) ;
+    std::vector< ESM::OrderPtr > callOrders ;
+    callOrders.reserve( collected ) ;
+    for( long i = 0 ; i < collected ; ++i )
+    {
+      callOrders.push_back( makeOrder( "2", i % 2 ? ESM::Side_SELL : ESM::Side_BUY,
+                                       ESM::OrderType_LIMIT, 1 + rand() % 100,
+                                       MidPrice - Levels / 2 + rand() % Levels ) ) ;
+    }
+
+    ESM::PriceBand callBand ;
+    ESM::OrderBook callBook( sink, callOrders.front(), callBand,
+                             ESM::TradingPhase_CALL_AUCTION ) ;
+    {
+      Scenario scenario( "call_collect" ) ;
+      for( long i = 0 ; i < collected ; ++i )
+      {
+        scenario.start() ;
+        callBook.insert( callOrders[i] ) ;
+        scenario.stop() ;
+      }
+      scenario.print( false ) ;
+    }
+
+    {
+      Scenario scenario( "call_indicative" ) ;
+      scenario.start() ;
+      callBook.refreshIndicative() ;
+      scenario.stop() ;
+      scenario.print( false ) ;
+    }
+
+    {
+      Scenario scenario( "call_uncross" ) ;
+      scenario.start() ;
+      callBook.setTradingPhase( ESM::TradingPhase_CONTINUOUS ) ;
+      scenario.stop() ;
+      scenario.print( false ) ;
+    }
+  }
+
+  // Left to _exit, as the threads of the market never end.
+  ESM::Market market( sink ) ;
+  std::vector< ESM::NewOrderPtr > firstOrders ;
+  std::vector< ESM::NewOrderPtr > secondOrders ;
+  firstOrders.reserve( symbols ) ;
+  secondOrders.reserve( symbols ) ;
+  for( long symbol = 0 ; symbol < symbols ; ++symbol )
+  {
+    std::string securityId = toSecurityId( symbol ) ;
+    firstOrders.push_back( makeOrder( securityId, ESM::Side_BUY,
+                                      ESM::OrderType_LIMIT, 10, MidPrice ) ) ;
+    secondOrders.push_back( makeOrder( securityId, ESM::Side_SELL,
+                                       ESM::OrderType_LIMIT, 10, MidPrice + 1 ) ) ;
+  }
+
+  {
+    Scenario scenario( "symbol_create" ) ;
+    for( long symbol = 0 ; symbol < symbols ; ++symbol )
+    {
+      scenario.start() ;
+      market.insert( firstOrders[symbol] ) ;
+      scenario.stop() ;
+    }
+    scenario.print( false ) ;
+  }
+
+  {
+    Scenario scenario( "symbol_add" ) ;
+    for( long symbol = 0 ; symbol < symbols ; ++symbol )
+    {
+      scenario.start() ;
+      market.insert( secondOrders[symbol] ) ;
+      scenario.stop() ;
+    }
+    scenario.print( true ) ;
+  }
+
+  rusage usage ;
+  getrusage( RUSAGE_SELF, &usage ) ;
+  std::cout << "  ],\n"
+            << "  \"max_rss_kb\": " << usage.ru_maxrss << "\n"
+            << "}" << std::endl ;
+
+  _exit( 0 ) ;
+}
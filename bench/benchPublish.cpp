@@ -0,0 +1,206 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+
+#include "executionSinks.h"
+#include "market.h"
+#include "marketDataWire.h"
+
+/**
+ * Publish the market picture of a market whose every book changed at once,
+ * as at the open, from 1 thread up to many.
+ *
+ *   bench_publish [symbols] [max threads]
+ *
+ * For each number of threads a new market gets an order in every symbol
+ * before it has a publisher, then a publisher encoding each record both in
+ * the binary wire format & as FIX text, as the UDP and FIX publishers do.
+ * Timed is the span from the first record sent to the last. The sequence
+ * numbers of every partition are checked to grow by one. Results are
+ * printed as JSON with the throughput & the speedup over 1 thread.
+ */
+namespace
+{
+  const int Depths = 5 ;
+
+  long long now()
+  {
+    timespec time ;
+    clock_gettime( CLOCK_MONOTONIC, &time ) ;
+    return time.tv_sec * 1000000000LL + time.tv_nsec ;
+  }
+
+  /**
+   * Encodes what it is sent & counts it.
+   */
+  class EncodingPublisher : public ESM::MarketDataPublisher
+  {
+    public :
+      EncodingPublisher()
+        : _records( 0 ),
+          _bytes( 0 ),
+          _outOfOrder( 0 ),
+          _first( 0 ),
+          _last( 0 )
+      {
+        for( int i = 0 ; i < ESM::Market::MarketDataPartitions ; ++i )
+        {
+          _sequenceNos[i] = 0 ;
+        }
+      }
+
+      void send( const ESM::MarketPicture &message )
+      {
+        long long first = 0 ;
+        _first.compare_exchange_strong( first, now() ) ;
+
+        // Only the thread of the partition sends it.
+        short &sequenceNo = _sequenceNos[ message.getSlotNo() ] ;
+        if( message.getSequenceNo() != static_cast< short >( sequenceNo + 1 ) )
+        {
+          ++_outOfOrder ;
+        }
+        sequenceNo = message.getSequenceNo() ;
+
+        char buffer[ ESM::Wire::MarketPicture::MaxLength ] ;
+        ESM::Wire::MarketPicture wire ;
+        wire.wrapForEncode( buffer ).encode( message ) ;
+        long bytes = wire.getEncodedLength() ;
+
+        char text[ 1024 ] ;
+        for( int i = 0 ; i < message.getNoOfRecs() ; ++i )
+        {
+          const ESM::MarketPicture::Record &record = message.getRecordAt( i ) ;
+          int length = snprintf( text, sizeof( text ),
+                                 "35=W\0011=%ld\00148=%ld\001268=%d\001",
+                                 static_cast< long >( record.getScripCode() ),
+                                 static_cast< long >( record.getScripCode() ),
+                                 2 * Depths ) ;
+          for( int j = 0 ; j < Depths ; ++j )
+          {
+            const ESM::MarketPicture::Record::Depth &depth = record.getDepthAt( j ) ;
+            length += snprintf( text + length, sizeof( text ) - length,
+                                "269=0\001270=%.2f\001271=%ld\001"
+                                "269=1\001270=%.2f\001271=%ld\001",
+                                depth.getBestBuyPrice() / 100.0,
+                                static_cast< long >( depth.getTotalBuyQty() ),
+                                depth.getBestSellPrice() / 100.0,
+                                static_cast< long >( depth.getTotalSellQty() ) ) ;
+          }
+          bytes += length ;
+        }
+
+        _bytes += bytes ;
+        _last = now() ;
+        _records += message.getNoOfRecs() ;
+      }
+
+      long getRecords() const { return _records ; }
+      long long getBytes() const { return _bytes ; }
+      long getOutOfOrder() const { return _outOfOrder ; }
+      long long getElapsed() const { return _last - _first ; }
+
+    private :
+      boost::atomic< long > _records ;
+      boost::atomic< long long > _bytes ;
+      boost::atomic< long > _outOfOrder ;
+      boost::atomic< long long > _first ;
+      boost::atomic< long long > _last ;
+      short _sequenceNos[ ESM::Market::MarketDataPartitions ] ;
+  };
+
+  std::string toSecurityId( long symbol )
+  {
+    std::ostringstream securityId ;
+    securityId << 100000 + symbol ;
+    return securityId.str() ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  long symbols = argc > 1 ? atol( argv[1] ) : 20000 ;
+  int maxThreads = argc > 2
+    ? atoi( argv[2] )
+    : std::max( 1u, boost::thread::hardware_concurrency() ) ;
+  maxThreads = std::min( maxThreads,
+                         static_cast< int >( ESM::Market::MaxMarketDataThreads ) ) ;
+
+  const long MidPrice = 100000 ;
+  ESM::NullExecutionSink sink ;
+
+  std::vector< int > threadCounts ;
+  for( int threads = 1 ; threads < maxThreads ; threads *= 2 )
+  {
+    threadCounts.push_back( threads ) ;
+  }
+  threadCounts.push_back( maxThreads ) ;
+
+  std::cout << "{\n"
+            << "  \"benchmark\": \"publish\",\n"
+            << "  \"symbols\": " << symbols << ",\n"
+            << "  \"partitions\": " << ESM::Market::MarketDataPartitions << ",\n"
+            << "  \"results\": [\n" ;
+
+  double singleThreaded = 0 ;
+  for( size_t run = 0 ; run < threadCounts.size() ; ++run )
+  {
+    int threads = threadCounts[ run ] ;
+
+    // Left to _exit, as the threads of the market never end.
+    ESM::Market *market = new ESM::Market( sink ) ;
+    for( long symbol = 0 ; symbol < symbols ; ++symbol )
+    {
+      ESM::NewOrderPtr order( new ESM::NewOrder( toSecurityId( symbol ),
+                                                 "bench", "BENCH",
+                                                 ESM::Side_BUY,
+                                                 ESM::OrderType_LIMIT, 10 ) ) ;
+      order->setPrice( MidPrice - symbol % 100 ) ;
+      market->insert( order ) ;
+    }
+
+    EncodingPublisher *publisher = new EncodingPublisher ;
+    market->setMarketDataThreads( threads ) ;
+    market->setMarketDataPublisher( publisher ) ;
+    while( publisher->getRecords() < symbols )
+    {
+      boost::this_thread::sleep( boost::posix_time::milliseconds( 1 ) ) ;
+    }
+
+    long long elapsed = std::max( 1LL, publisher->getElapsed() ) ;
+    double recordsPerSecond = symbols * 1000000000.0 / elapsed ;
+    if( run == 0 )
+    {
+      singleThreaded = recordsPerSecond ;
+    }
+
+    std::cout << "    {\n"
+              << "      \"threads\": " << threads << ",\n"
+              << "      \"records\": " << publisher->getRecords() << ",\n"
+              << "      \"elapsed_ns\": " << elapsed << ",\n"
+              << "      \"records_per_second\": "
+              << static_cast< long long >( recordsPerSecond ) << ",\n"
+              << "      \"speedup\": " << recordsPerSecond / singleThreaded << ",\n"
+              << "      \"bytes\": " << publisher->getBytes() << ",\n"
+              << "      \"out_of_order\": " << publisher->getOutOfOrder() << "\n"
+              << "    }" << ( run + 1 == threadCounts.size() ? "" : "," )
+              << std::endl ;
+  }
+
+  rusage usage ;
+  getrusage( RUSAGE_SELF, &usage ) ;
+  std::cout << "  ],\n"
+            << "  \"max_rss_kb\": " << usage.ru_maxrss << "\n"
+            << "}" << std::endl ;
+
+  _exit( 0 ) ;
+}
@@ -0,0 +1,540 @@
+#include "binaryLog.h"
+#include "errorlog.h"
+#include "exceptions.h"
+#include "spscRing.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/thread.hpp>
+
+namespace UT
+{
+  /**
+   * The ring of a thread. Once its thread ends, the log thread deletes it
+   * after writing out what is left.
+   */
+  struct ThreadLog
+  {
+    SpscRing< LogRecord, 4096 > ring ;
+    boost::atomic< long long > dropped ;
+    boost::atomic< bool > retired ;
+    long long reported ;   // drops written out, log thread only
+    unsigned long id ;
+  };
+
+  namespace
+  {
+    /**
+     * The file starts with the magic. Then come records, each starting
+     * with its kind:
+     * * F, a format: the format id (uint64), the length (uint32) & text
+     * * E, an entry: the thread (uint32) and the LogRecord, its data cut to
+     *   size
+     * * D, drops: the thread (uint32) & the statements dropped (int64)
+     * Numbers are in host order.
+     */
+    const char Magic[] = "UTLOG001" ;
+    const char Kind_FORMAT = 'F' ;
+    const char Kind_ENTRY = 'E' ;
+    const char Kind_DROPS = 'D' ;
+    const size_t EntryHeaderSize = offsetof( LogRecord, data ) ;
+
+    const char *LevelNames[] = { "", "FATAL", "ERROR", "WARN", "INFO", "DEBUG" } ;
+
+    struct LogState
+    {
+      boost::mutex threadsMutex ;
+      std::vector< ThreadLog * > threads ;
+      unsigned long nextThreadId ;
+
+      /**
+       * The file, and the formats already written to it, are the log
+       * thread's while it holds the mutex.
+       */
+      boost::mutex fileMutex ;
+      FILE *file ;
+      std::set< const char * > writtenFormats ;
+    };
+
+    /**
+     * Never deleted, as the log thread outlives the static objects.
+     */
+    LogState *state = 0 ;
+
+    boost::once_flag startOnce = BOOST_ONCE_INIT ;
+    boost::atomic< long long > cycles( 0 ) ;
+    boost::atomic< bool > started( false ) ;
+
+    void retire( ThreadLog *threadLog )
+    {
+      threadLog->retired.store( true, boost::memory_order_release ) ;
+    }
+
+    boost::thread_specific_ptr< ThreadLog > threadLog( &retire ) ;
+
+    void write( const void *data, size_t size )
+    {
+      fwrite( data, size, 1, state->file ) ;
+    }
+
+    void writeEntry( const ThreadLog &thread, const LogRecord &record )
+    {
+      if( state->writtenFormats.insert( record.format ).second )
+      {
+        uint64_t formatId = reinterpret_cast< uintptr_t >( record.format ) ;
+        uint32_t length = strlen( record.format ) ;
+        write( &Kind_FORMAT, 1 ) ;
+        write( &formatId, sizeof( formatId ) ) ;
+        write( &length, sizeof( length ) ) ;
+        write( record.format, length ) ;
+      }
+
+      uint32_t id = thread.id ;
+      write( &Kind_ENTRY, 1 ) ;
+      write( &id, sizeof( id ) ) ;
+      write( &record, EntryHeaderSize + record.size ) ;
+    }
+
+    void writeDrops( const ThreadLog &thread, long long dropped )
+    {
+      if( state->file != 0 )
+      {
+        uint32_t id = thread.id ;
+        int64_t count = dropped ;
+        write( &Kind_DROPS, 1 ) ;
+        write( &id, sizeof( id ) ) ;
+        write( &count, sizeof( count ) ) ;
+      }
+      else
+      {
+        std::cerr << dropped << " log statements of thread " << thread.id
+                  << " dropped" << std::endl ;
+      }
+    }
+
+    /**
+     * @return Whether there was anything to write.
+     */
+    bool drain( ThreadLog &thread )
+    {
+      bool wrote = false ;
+      const LogRecord *record ;
+      while( ( record = thread.ring.front() ) != 0 )
+      {
+        if( state->file != 0 )
+        {
+          writeEntry( thread, *record ) ;
+        }
+        else
+        {
+          BinaryLog::print( record->level == DEBUG_LEVEL ? std::cout : std::cerr,
+                            *record ) ;
+        }
+        thread.ring.pop() ;
+        wrote = true ;
+      }
+
+      long long dropped = thread.dropped.load( boost::memory_order_relaxed ) ;
+      if( dropped > thread.reported )
+      {
+        writeDrops( thread, dropped - thread.reported ) ;
+        thread.reported = dropped ;
+        wrote = true ;
+      }
+      return wrote ;
+    }
+
+    void run()
+    {
+      std::vector< ThreadLog * > snapshot ;
+      while( true )
+      {
+        {
+          boost::mutex::scoped_lock lock( state->threadsMutex ) ;
+          snapshot = state->threads ;
+        }
+
+        bool wrote = false ;
+        {
+          boost::mutex::scoped_lock lock( state->fileMutex ) ;
+          for( std::vector< ThreadLog * >::const_iterator iThread = snapshot.begin() ;
+               iThread != snapshot.end() ;
+               ++iThread )
+          {
+            // Checked first, so nothing is logged after the last drain.
+            bool retired = ( *iThread )->retired.load( boost::memory_order_acquire ) ;
+            wrote |= drain( **iThread ) ;
+            if( retired )
+            {
+              boost::mutex::scoped_lock threadsLock( state->threadsMutex ) ;
+              std::vector< ThreadLog * > &threads = state->threads ;
+              threads.erase( std::find( threads.begin(), threads.end(), *iThread ) ) ;
+              delete *iThread ;
+            }
+          }
+
+          if( wrote )
+          {
+            if( state->file != 0 )
+            {
+              fflush( state->file ) ;
+            }
+            std::cout.flush() ;
+          }
+        }
+
+        cycles.fetch_add( 1, boost::memory_order_release ) ;
+        if( !wrote )
+        {
+          boost::this_thread::sleep( boost::posix_time::milliseconds( 1 ) ) ;
+        }
+      }
+    }
+
+    void start()
+    {
+      state = new LogState() ;
+      state->nextThreadId = 0 ;
+      state->file = 0 ;
+      boost::thread logThread( &run ) ;
+      started.store( true, boost::memory_order_release ) ;
+    }
+
+    ThreadLog &getThreadLog()
+    {
+      ThreadLog *log = threadLog.get() ;
+      if( log == 0 )
+      {
+        boost::call_once( &start, startOnce ) ;
+
+        log = new ThreadLog() ;
+        log->ring.init() ;
+        log->dropped.store( 0, boost::memory_order_relaxed ) ;
+        log->retired.store( false, boost::memory_order_relaxed ) ;
+        log->reported = 0 ;
+        {
+          boost::mutex::scoped_lock lock( state->threadsMutex ) ;
+          log->id = state->nextThreadId++ ;
+          state->threads.push_back( log ) ;
+        }
+        threadLog.reset( log ) ;
+      }
+      return *log ;
+    }
+
+    struct LogValue
+    {
+      char type ;
+      int64_t integer ;
+      uint64_t unsignedInteger ;
+      double real ;
+      std::string text ;
+    };
+
+    /**
+     * @brief Read the argument of a record at an offset, and move past it.
+     *
+     * @return false past the last argument.
+     */
+    bool readArgument( const LogRecord &record, size_t &offset, LogValue &value )
+    {
+      if( offset >= record.size )
+      {
+        return false ;
+      }
+      const char *data = record.data + offset + 1 ;
+      value.type = record.data[ offset ] ;
+      switch( value.type )
+      {
+        case LogArgument_INTEGER :
+          memcpy( &value.integer, data, sizeof( value.integer ) ) ;
+          offset += 1 + sizeof( value.integer ) ;
+          break ;
+        case LogArgument_UNSIGNED :
+          memcpy( &value.unsignedInteger, data, sizeof( value.unsignedInteger ) ) ;
+          offset += 1 + sizeof( value.unsignedInteger ) ;
+          break ;
+        case LogArgument_DOUBLE :
+          memcpy( &value.real, data, sizeof( value.real ) ) ;
+          offset += 1 + sizeof( value.real ) ;
+          break ;
+        case LogArgument_STRING :
+          {
+            uint16_t length ;
+            memcpy( &length, data, sizeof( length ) ) ;
+            if( offset + 1 + sizeof( length ) + length > record.size )
+            {
+              return false ;
+            }
+            value.text.assign( data + sizeof( length ), length ) ;
+            offset += 1 + sizeof( length ) + length ;
+          }
+          break ;
+        default :
+          return false ;
+      }
+      return offset <= record.size ;
+    }
+
+    template< class Output >
+      void feed( Output &out, const LogValue &value )
+      {
+        switch( value.type )
+        {
+          case LogArgument_INTEGER :
+            out % value.integer ;
+            break ;
+          case LogArgument_UNSIGNED :
+            out % value.unsignedInteger ;
+            break ;
+          case LogArgument_DOUBLE :
+            out % value.real ;
+            break ;
+          default :
+            out % value.text ;
+        }
+      }
+
+    /**
+     * Concatenates the arguments of a debug statement, as the macros
+     * streamed them.
+     */
+    struct Concatenation
+    {
+      std::ostream &out ;
+
+      explicit Concatenation( std::ostream &stream ) : out( stream ) {}
+
+      template< class T >
+        Concatenation &operator%( const T &value )
+        {
+          out << value ;
+          return *this ;
+        }
+    };
+
+    template< class T >
+      bool read( FILE *input, T &value )
+      {
+        return fread( &value, sizeof( value ), 1, input ) == 1 ;
+      }
+  }
+
+  LogWriter::LogWriter( int level, int number, const char *format )
+    : _threadLog( getThreadLog() ),
+      _record( _threadLog.ring.claim() )
+  {
+    if( _record == 0 )
+    {
+      _threadLog.dropped.store(
+          _threadLog.dropped.load( boost::memory_order_relaxed ) + 1,
+          boost::memory_order_relaxed ) ;
+      return ;
+    }
+
+    timespec now ;
+    clock_gettime( CLOCK_REALTIME, &now ) ;
+    _record->timestamp = now.tv_sec * 1000000000LL + now.tv_nsec ;
+    _record->format = format ;
+    _record->number = number ;
+    _record->level = level ;
+    _record->arguments = 0 ;
+    _record->size = 0 ;
+  }
+
+  LogWriter::~LogWriter()
+  {
+    if( _record != 0 )
+    {
+      _threadLog.ring.publish() ;
+    }
+  }
+
+  LogWriter &LogWriter::addString( const char *value, size_t length )
+  {
+    if( _record == 0 || _record->size + 1 + sizeof( uint16_t ) > LogDataSize )
+    {
+      return *this ;
+    }
+    length = std::min( length, LogDataSize - _record->size - 1 - sizeof( uint16_t ) ) ;
+    uint16_t size = length ;
+
+    char *data = _record->data + _record->size ;
+    data[ 0 ] = LogArgument_STRING ;
+    memcpy( data + 1, &size, sizeof( size ) ) ;
+    memcpy( data + 1 + sizeof( size ), value, length ) ;
+    _record->size += 1 + sizeof( size ) + length ;
+    ++_record->arguments ;
+    return *this ;
+  }
+
+  void BinaryLog::open( const std::string &fileName )
+  {
+    FILE *newFile = fopen( fileName.c_str(), "wb" ) ;
+    if( newFile == 0 )
+    {
+      throw FileNotFound( fileName ) ;
+    }
+    fwrite( Magic, sizeof( Magic ) - 1, 1, newFile ) ;
+
+    boost::call_once( &start, startOnce ) ;
+    boost::mutex::scoped_lock lock( state->fileMutex ) ;
+    if( state->file != 0 )
+    {
+      fclose( state->file ) ;
+    }
+    state->file = newFile ;
+    state->writtenFormats.clear() ;
+  }
+
+  void BinaryLog::flush()
+  {
+    if( !started.load( boost::memory_order_acquire ) )
+    {
+      return ;
+    }
+    // The cycle under way may have passed this thread's ring already.
+    long long until = cycles.load( boost::memory_order_acquire ) + 2 ;
+    while( cycles.load( boost::memory_order_acquire ) < until )
+    {
+      boost::this_thread::sleep( boost::posix_time::microseconds( 100 ) ) ;
+    }
+  }
+
+  void BinaryLog::print( std::ostream &out, const LogRecord &record )
+  {
+    time_t seconds = record.timestamp / 1000000000LL ;
+    tm utc ;
+    gmtime_r( &seconds, &utc ) ;
+    char timestamp[ 32 ] ;
+    size_t length = strftime( timestamp, sizeof( timestamp ), "%Y%m%d-%H:%M:%S", &utc ) ;
+    snprintf( timestamp + length, sizeof( timestamp ) - length, ".%06lld",
+              record.timestamp % 1000000000LL / 1000 ) ;
+
+    int level = record.level ;
+    if( level < FATAL_LEVEL || level > DEBUG_LEVEL )
+    {
+      level = 0 ;
+    }
+
+    LogValue value ;
+    size_t offset = 0 ;
+    if( level == DEBUG_LEVEL )
+    {
+      out << timestamp << " DEBUG: " << record.format ;
+      Concatenation concatenation( out ) ;
+      while( readArgument( record, offset, value ) )
+      {
+        feed( concatenation, value ) ;
+      }
+    }
+    else
+    {
+      out << timestamp << " : " << LevelNames[ level ] << ": "
+          << record.number << ": " ;
+      if( record.arguments == 0 )
+      {
+        out << record.format ;
+      }
+      else
+      {
+        boost::format format( record.format ) ;
+        format.exceptions( boost::io::no_error_bits ) ;
+        while( readArgument( record, offset, value ) )
+        {
+          feed( format, value ) ;
+        }
+        out << format ;
+      }
+    }
+    out << '\n' ;
+  }
+
+  long BinaryLog::decode( const std::string &fileName, std::ostream &out )
+  {
+    FILE *input = fopen( fileName.c_str(), "rb" ) ;
+    if( input == 0 )
+    {
+      throw FileNotFound( fileName ) ;
+    }
+
+    char magic[ sizeof( Magic ) - 1 ] ;
+    if( fread( magic, sizeof( magic ), 1, input ) != 1
+        || memcmp( magic, Magic, sizeof( magic ) ) != 0 )
+    {
+      fclose( input ) ;
+      throw ConfigError( fileName + " is not a binary log" ) ;
+    }
+
+    std::map< uint64_t, std::string > formats ;
+    long entries = 0 ;
+    bool damaged = false ;
+    char kind ;
+    while( !damaged && read( input, kind ) )
+    {
+      uint32_t thread ;
+      if( kind == Kind_FORMAT )
+      {
+        uint64_t formatId ;
+        uint32_t length ;
+        if( !read( input, formatId ) || !read( input, length ) )
+        {
+          damaged = true ;
+          continue ;
+        }
+        std::string text( length, '\0' ) ;
+        if( length > 0 && fread( &text[ 0 ], length, 1, input ) != 1 )
+        {
+          damaged = true ;
+          continue ;
+        }
+        formats[ formatId ] = text ;
+      }
+      else if( kind == Kind_ENTRY )
+      {
+        LogRecord record ;
+        if( !read( input, thread )
+            || fread( &record, EntryHeaderSize, 1, input ) != 1
+            || record.size > LogDataSize
+            || ( record.size > 0 && fread( record.data, record.size, 1, input ) != 1 ) )
+        {
+          damaged = true ;
+          continue ;
+        }
+        std::map< uint64_t, std::string >::const_iterator iFormat =
+          formats.find( reinterpret_cast< uintptr_t >( record.format ) ) ;
+        record.format = iFormat == formats.end() ? "?" : iFormat->second.c_str() ;
+        print( out, record ) ;
+        ++entries ;
+      }
+      else if( kind == Kind_DROPS )
+      {
+        int64_t dropped ;
+        if( !read( input, thread ) || !read( input, dropped ) )
+        {
+          damaged = true ;
+          continue ;
+        }
+        out << dropped << " log statements of thread " << thread
+            << " dropped\n" ;
+      }
+      else
+      {
+        damaged = true ;
+      }
+    }
+
+    fclose( input ) ;
+    if( damaged )
+    {
+      out << "... " << fileName << " is cut short or damaged here\n" ;
+    }
+    return entries ;
+  }
+}
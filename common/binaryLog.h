@@ -0,0 +1,177 @@
+#ifndef UT_BINARY_LOG_H
+#define UT_BINARY_LOG_H
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace UT
+{
+  /**
+   * The type of an argument of a log record, ahead of its value.
+   */
+  enum LogArgument
+  {
+    LogArgument_INTEGER = 'i',   // int64_t
+    LogArgument_UNSIGNED = 'u',  // uint64_t
+    LogArgument_DOUBLE = 'd',    // double
+    LogArgument_STRING = 's'     // uint16_t length, then the characters
+  };
+
+  struct ThreadLog ;
+
+  const unsigned long LogRecordSize = 256 ;
+  const unsigned long LogDataSize = LogRecordSize - 24 ;
+
+  /**
+   * A log statement as the calling thread leaves it: the time, the format
+   * and the raw arguments. Formatting is left to the log thread or to the
+   * decoder.
+   */
+  struct LogRecord
+  {
+    long long timestamp ;     // ns since the epoch
+    const char *format ;      // the text of the message, also its id
+    int32_t number ;          // of the message, 0 for debug
+    char level ;              // FATAL_LEVEL .. DEBUG_LEVEL
+    unsigned char arguments ;
+    uint16_t size ;           // of data in use
+    char data[ LogDataSize ] ;
+  };
+
+  /**
+   * \class LogWriter
+   *
+   * Fills a record of the ring of the calling thread, which the log thread
+   * picks up once the writer is destroyed. When the ring is full the
+   * statement is dropped and counted, the caller never waits; so are the
+   * arguments past the end of the record.
+   *
+   * Numbers and strings are copied as they are. Other types are formatted
+   * with their operator<< on the spot, which costs as much as it used to.
+   *
+   */
+  class LogWriter
+  {
+    public :
+      LogWriter( int level, int number, const char *format ) ;
+      ~LogWriter() ;
+
+      LogWriter &operator<<( int value ) { return addInteger( value ) ; }
+      LogWriter &operator<<( long value ) { return addInteger( value ) ; }
+      LogWriter &operator<<( long long value ) { return addInteger( value ) ; }
+      LogWriter &operator<<( short value ) { return addInteger( value ) ; }
+      LogWriter &operator<<( bool value ) { return addInteger( value ) ; }
+      LogWriter &operator<<( unsigned int value ) { return addUnsigned( value ) ; }
+      LogWriter &operator<<( unsigned long value ) { return addUnsigned( value ) ; }
+      LogWriter &operator<<( unsigned long long value ) { return addUnsigned( value ) ; }
+      LogWriter &operator<<( unsigned short value ) { return addUnsigned( value ) ; }
+      LogWriter &operator<<( double value ) { return addDouble( value ) ; }
+      LogWriter &operator<<( float value ) { return addDouble( value ) ; }
+      LogWriter &operator<<( char value ) { return addString( &value, 1 ) ; }
+      LogWriter &operator<<( const char *value )
+      {
+        return value == 0 ? addString( "(null)", 6 ) : addString( value, strlen( value ) ) ;
+      }
+      LogWriter &operator<<( const std::string &value )
+      {
+        return addString( value.data(), value.size() ) ;
+      }
+
+      template< class T >
+        LogWriter &operator<<( const T &value )
+        {
+          if( _record == 0 )
+          {
+            return *this ;
+          }
+          std::ostringstream text ;
+          text << value ;
+          return *this << text.str() ;
+        }
+
+    private :
+      ThreadLog &_threadLog ;
+      LogRecord *_record ;
+
+      LogWriter( const LogWriter & ) ;
+      LogWriter &operator=( const LogWriter & ) ;
+
+      LogWriter &addInteger( int64_t value )
+      {
+        return add( LogArgument_INTEGER, &value, sizeof( value ) ) ;
+      }
+
+      LogWriter &addUnsigned( uint64_t value )
+      {
+        return add( LogArgument_UNSIGNED, &value, sizeof( value ) ) ;
+      }
+
+      LogWriter &addDouble( double value )
+      {
+        return add( LogArgument_DOUBLE, &value, sizeof( value ) ) ;
+      }
+
+      LogWriter &add( LogArgument type, const void *value, size_t size )
+      {
+        if( _record != 0 && _record->size + 1 + size <= LogDataSize )
+        {
+          _record->data[ _record->size ] = type ;
+          memcpy( _record->data + _record->size + 1, value, size ) ;
+          _record->size += 1 + size ;
+          ++_record->arguments ;
+        }
+        return *this ;
+      }
+
+      LogWriter &addString( const char *value, size_t length ) ;
+  };
+
+  /**
+   * \class BinaryLog
+   *
+   * Every thread logs into a lock-free ring of its own. A log thread,
+   * started with the first statement, drains the rings: either into a
+   * binary file for umatch_logdecode, once open() is called, or formatted
+   * to stderr, debug statements to stdout, as the macros used to print.
+   *
+   * Statements of different threads may be written out of order by up to
+   * a millisecond; each carries its own time.
+   *
+   */
+  class BinaryLog
+  {
+    public :
+      /**
+       * @brief Write the log in binary to a file from now on.
+       *
+       * @param The file, truncated.
+       */
+      static void open( const std::string &fileName ) ;
+
+      /**
+       * @brief Wait until the statements logged so far are written out.
+       */
+      static void flush() ;
+
+      /**
+       * @brief Print a record as text.
+       *
+       * @param The record, with its format pointing to the text of the
+       * message.
+       */
+      static void print( std::ostream &out, const LogRecord &record ) ;
+
+      /**
+       * @brief Print a binary log as text.
+       *
+       * @return The number of statements printed.
+       */
+      static long decode( const std::string &fileName, std::ostream &out ) ;
+  };
+}
+
+#endif // UT_BINARY_LOG_H
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "exceptions.h"
+#include "fixCapture.h"
+#include "fixTags.h"
+
+/**
+ * Print the FIX messages captured by UT::FixCapture, one table of tags,
+ * field names, values and their meaning per message, as the engine used to
+ * print them itself in debug builds. The names come from the data
+ * dictionary the decoder was built with, configs/FIX_umatch.xml.
+ *
+ *   umatch_capdecode [--raw] capture files...
+ */
+namespace
+{
+  struct TagLess
+  {
+    bool operator()( const UT::FixTagName &name, int tag ) const
+    {
+      return name.tag < tag ;
+    }
+  };
+
+  struct ValueLess
+  {
+    bool operator()( const UT::FixValueName &name,
+                     const std::pair< int, std::string > &value ) const
+    {
+      return name.tag < value.first
+        || ( name.tag == value.first && name.value < value.second ) ;
+    }
+  };
+
+  const char *getName( int tag )
+  {
+    const UT::FixTagName *end = UT::FixTagNames
+      + sizeof( UT::FixTagNames ) / sizeof( UT::FixTagNames[ 0 ] ) ;
+    const UT::FixTagName *name = std::lower_bound( UT::FixTagNames, end, tag, TagLess() ) ;
+    return name != end && name->tag == tag ? name->name : 0 ;
+  }
+
+  const char *getDescription( int tag, const std::string &value )
+  {
+    const UT::FixValueName *end = UT::FixValueNames
+      + sizeof( UT::FixValueNames ) / sizeof( UT::FixValueNames[ 0 ] ) ;
+    const UT::FixValueName *name = std::lower_bound(
+        UT::FixValueNames, end, std::make_pair( tag, value ), ValueLess() ) ;
+    return name != end && name->tag == tag && name->value == value
+      ? name->description : 0 ;
+  }
+
+  std::string toText( int64_t timestamp )
+  {
+    time_t seconds = timestamp / 1000000000LL ;
+    tm utc ;
+    gmtime_r( &seconds, &utc ) ;
+    char text[ 32 ] ;
+    size_t length = strftime( text, sizeof( text ), "%Y%m%d-%H:%M:%S", &utc ) ;
+    snprintf( text + length, sizeof( text ) - length, ".%09lld",
+              static_cast< long long >( timestamp % 1000000000LL ) ) ;
+    return text ;
+  }
+
+  void print( const UT::CaptureRecord &record, const std::string &message )
+  {
+    std::cout << std::endl << toText( record.timestamp ) << " "
+              << ( record.direction == UT::CaptureDirection_INBOUND
+                   ? "INBOUND" : "OUTBOUND" )
+              << std::endl ;
+
+    std::cout << std::left << std::setw( 7 ) << "Tag"
+              << std::setw( 32 ) << "Field Name"
+              << std::setw( 25 ) << "Value"
+              << "Description" << std::endl ;
+
+    size_t begin = 0 ;
+    while( begin < message.size() )
+    {
+      size_t end = message.find( '\001', begin ) ;
+      if( end == std::string::npos )
+      {
+        end = message.size() ;
+      }
+      std::string field = message.substr( begin, end - begin ) ;
+      begin = end + 1 ;
+
+      size_t equals = field.find( '=' ) ;
+      std::string tag = field.substr( 0, equals ) ;
+      std::string value = equals == std::string::npos
+        ? "ERROR - Value Not Assigned" : field.substr( equals + 1 ) ;
+      int number = atoi( tag.c_str() ) ;
+      const char *name = getName( number ) ;
+      const char *description = getDescription( number, value ) ;
+
+      std::cout << std::setw( 7 ) << tag
+                << std::setw( 32 ) << ( name ? name : tag.c_str() )
+                << std::setw( 25 ) << value
+                << ( description ? description : "" ) << std::endl ;
+    }
+  }
+
+  void printRaw( const UT::CaptureRecord &record, std::string message )
+  {
+    std::replace( message.begin(), message.end(), '\001', '|' ) ;
+    std::cout << toText( record.timestamp ) << " " << record.direction
+              << " " << message << std::endl ;
+  }
+
+  /**
+   * @return The number of messages printed.
+   */
+  long decode( const std::string &fileName, bool raw )
+  {
+    FILE *input = fopen( fileName.c_str(), "rb" ) ;
+    if( input == 0 )
+    {
+      throw UT::FileNotFound( fileName ) ;
+    }
+
+    char magic[ sizeof( UT::CaptureMagic ) - 1 ] ;
+    if( fread( magic, sizeof( magic ), 1, input ) != 1
+        || memcmp( magic, UT::CaptureMagic, sizeof( magic ) ) != 0 )
+    {
+      fclose( input ) ;
+      throw UT::ConfigError( fileName + " is not a FIX capture" ) ;
+    }
+
+    long messages = 0 ;
+    bool damaged = false ;
+    UT::CaptureRecord record ;
+    std::string message ;
+    while( fread( &record, sizeof( record ), 1, input ) == 1 )
+    {
+      // The unused end of a file still mapped, or of a crashed engine.
+      if( record.timestamp == 0 && record.length == 0 )
+      {
+        break ;
+      }
+
+      size_t padded = ( record.length + 7 ) & ~7u ;
+      message.resize( padded ) ;
+      if( padded > 0 && fread( &message[ 0 ], padded, 1, input ) != 1 )
+      {
+        damaged = true ;
+        break ;
+      }
+      message.resize( record.length ) ;
+
+      if( raw )
+      {
+        printRaw( record, message ) ;
+      }
+      else
+      {
+        print( record, message ) ;
+      }
+      ++messages ;
+    }
+
+    fclose( input ) ;
+    if( damaged )
+    {
+      std::cout << "... " << fileName << " is cut short here" << std::endl ;
+    }
+    return messages ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  bool raw = argc > 1 && strcmp( argv[ 1 ], "--raw" ) == 0 ;
+  int first = raw ? 2 : 1 ;
+  if( argc <= first )
+  {
+    std::cout << "Usage : umatch_capdecode [--raw] capture files..."
+              << std::endl ;
+    return 1 ;
+  }
+
+  try
+  {
+    for( int file = first ; file < argc ; ++file )
+    {
+      decode( argv[ file ], raw ) ;
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cout.flush() ;
+    std::cerr << "stopping due to error " << e.what() << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
@@ -0,0 +1,105 @@
+#ifndef UT_DIRTY_QUEUE_H
+#define UT_DIRTY_QUEUE_H
+
+#include <algorithm>
+#include <vector>
+#include <boost/atomic.hpp>
+
+namespace UT
+{
+  /**
+   * \class DirtyQueue
+   *
+   * The items which changed since a consumer last looked, each one queued
+   * once however often it changes meanwhile, so that the consumer visits
+   * only those and not every item there is.
+   *
+   * Items derive from DirtyQueue< T >::Node and are linked through it, so
+   * queueing allocates nothing and takes no lock. Any thread may push, one
+   * thread takes. Items must outlive the queue.
+   *
+   * An item pushed after it changed is never missed: either the consumer
+   * taking it sees the change, or the item is queued again.
+   *
+   * An item can be on several queues, each told apart by a tag type of
+   * its own.
+   *
+   */
+  template< class T, class Tag = void >
+  class DirtyQueue
+  {
+    public :
+      class Node
+      {
+        public :
+          Node() : _queued( false ), _nextQueued( 0 ) {}
+
+        private :
+          friend class DirtyQueue ;
+          boost::atomic< bool > _queued ;
+          T *_nextQueued ;
+      };
+
+      DirtyQueue() : _head( 0 ) {}
+
+      /**
+       * @brief Queue an item after publishing its change, unless it is
+       * queued already.
+       */
+      void push( T *item )
+      {
+        Node *node = item ;
+
+        // Orders the change before the test, against the fence in take().
+        boost::atomic_thread_fence( boost::memory_order_seq_cst ) ;
+        if( node->_queued.load( boost::memory_order_relaxed )
+            || node->_queued.exchange( true, boost::memory_order_acquire ) )
+        {
+          return ;
+        }
+
+        T *head = _head.load( boost::memory_order_relaxed ) ;
+        do
+        {
+          node->_nextQueued = head ;
+        }
+        while( !_head.compare_exchange_weak( head, item,
+                                             boost::memory_order_release,
+                                             boost::memory_order_relaxed ) ) ;
+      }
+
+      /**
+       * @brief Take every item queued, oldest first. They are pushed again
+       * by their next change, so read them after this returns.
+       *
+       * @param The items are appended here.
+       */
+      void take( std::vector< T * > &items )
+      {
+        size_t first = items.size() ;
+        for( T *item = _head.exchange( 0, boost::memory_order_acquire ) ;
+             item != 0 ;
+             item = static_cast< Node * >( item )->_nextQueued )
+        {
+          items.push_back( item ) ;
+        }
+        std::reverse( items.begin() + first, items.end() ) ;
+
+        // Links are read before any item can be queued again.
+        for( size_t i = first ; i < items.size() ; ++i )
+        {
+          static_cast< Node * >( items[ i ] )->_queued.store(
+              false, boost::memory_order_relaxed ) ;
+        }
+        boost::atomic_thread_fence( boost::memory_order_seq_cst ) ;
+      }
+
+    private :
+      boost::atomic< T * > _head ;
+
+      DirtyQueue( const DirtyQueue & ) ;
+      DirtyQueue &operator=( const DirtyQueue & ) ;
+  };
+}
+
+#endif // UT_DIRTY_QUEUE_H
@@ -1,5 +1,7 @@
 #include "errorlog.h"
+#include "latency.h"
 #include <stdint.h>
+#include <iomanip>
 
 int getDebugLevel()
 {
@@ -25,3 +27,33 @@ int getDebugLevel()
   return logLevel;
 }
 
+
+void startLogTime(const std::string& state,
+    struct timeval& timeValue,
+    long long& t1,
+    long orderId)
+{
+  gettimeofday(&timeValue, NULL);
+  t1 = UT::Latency::now();
+}
+
+// A state named after a latency stage is counted in its histogram, any
+// other is printed.
+void endLogTime( const std::string& state,
+    struct timeval timeValue,
+    long long t1,
+    long orderId)
+{
+  long long elapsed = UT::Latency::now() - t1;
+  UT::LatencyStage stage;
+  if (UT::Latency::toStage(state, stage)) {
+    UT::Latency::record(stage, elapsed);
+  }
+  else {
+    std::cerr << timeValue.tv_sec << "."
+              << std::setw(6) << std::setfill('0') << timeValue.tv_usec
+              << std::setfill(' ')
+              << " : " << state << " of order " << orderId
+              << " took " << elapsed / 1000 << " us" << std::endl;
+  }
+}
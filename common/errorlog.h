@@ -8,12 +8,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <iostream>
-#include <boost/format.hpp>
 #ifndef _MSC_VER
   #include <sys/time.h>
 #endif
 
 #include "../config.h"
+#include "binaryLog.h"
 
 #define DEFINE_MSG_HEADER(err_mnemonic)                                        \
   namespace ut {                                                               \
@@ -45,12 +45,15 @@
 // 2 = + Error (ERROR)  //
 // 3 = + Warning (WARN) //
 // 4 = + Info (INFO)    //
+// 5 = DEBUG, on unless //
+//     NDEBUG           //
 //////////////////////////
 
 #define FATAL_LEVEL 1
 #define ERROR_LEVEL 2
 #define WARN_LEVEL  3
 #define INFO_LEVEL  4
+#define DEBUG_LEVEL 5
 
 //////////////////////////////////////////
 // get debug level from the environment //
@@ -58,8 +61,6 @@
 
 int getDebugLevel() ;
 
-std::string getCurrentTime() ;
-
 void startLogTime(const std::string& state,
     struct timeval& timeValue,
     long long& t1,
@@ -70,59 +71,72 @@ void endLogTime( const std::string& state,
     long long t1,
     long orderId);
 
+// A statement is left, unformatted, in the ring of the calling thread and
+// written out by the log thread, see binaryLog.h. FATAL waits for it.
+
 #define __BEGIN_MSG__(level,err_mnemonic)                                      \
-  std::cerr << getCurrentTime() << " : "                                       \
-  << #level << ": "                                                            \
-  << ut::message::__ERRNUM_ ## err_mnemonic                                    \
-  << ": ";
+  UT::LogWriter __logWriter(level ## _LEVEL,                                   \
+                            ut::message::__ERRNUM_ ## err_mnemonic,            \
+                            ut::message::__ERRTXT_ ## err_mnemonic.c_str());   \
+  __logWriter
+
+#define __END_MSG__(level)                                                     \
+  if (level ## _LEVEL == FATAL_LEVEL) {                                        \
+    UT::BinaryLog::flush();                                                    \
+  }
 
 #define MSG_LEVEL_0(level,err_mnemonic) {                                      \
     if (getDebugLevel() >= level ## _LEVEL) {                                  \
-      __BEGIN_MSG__(level,err_mnemonic);                                       \
-      std::cerr << ut::message::__ERRTXT_ ## err_mnemonic                      \
-                << std::endl;                                                  \
+      {                                                                        \
+        __BEGIN_MSG__(level,err_mnemonic);                                     \
+      }                                                                        \
+      __END_MSG__(level)                                                       \
     }                                                                          \
   }
 
 #define MSG_LEVEL_1(level,err_mnemonic,param1) {                               \
     if (getDebugLevel() >= level ## _LEVEL) {                                  \
-      __BEGIN_MSG__(level,err_mnemonic);                                       \
-      std::cerr << boost::format(ut::message::__ERRTXT_ ## err_mnemonic)       \
-        % param1                                                               \
-                << std::endl;                                                  \
+      {                                                                        \
+        __BEGIN_MSG__(level,err_mnemonic)                                      \
+          << param1;                                                           \
+      }                                                                        \
+      __END_MSG__(level)                                                       \
     }                                                                          \
   }
 
 #define MSG_LEVEL_2(level,err_mnemonic,param1,param2) {                        \
-                          if (getDebugLevel() >=level ## _LEVEL) {             \
-      __BEGIN_MSG__(level,err_mnemonic);                                       \
-      std::cerr << boost::format(ut::message::__ERRTXT_ ## err_mnemonic)       \
-        % param1                                                               \
-        % param2                                                               \
-                << std::endl;                                                  \
+    if (getDebugLevel() >= level ## _LEVEL) {                                  \
+      {                                                                        \
+        __BEGIN_MSG__(level,err_mnemonic)                                      \
+          << param1                                                            \
+          << param2;                                                           \
+      }                                                                        \
+      __END_MSG__(level)                                                       \
     }                                                                          \
   }
 
 #define MSG_LEVEL_3(level,err_mnemonic,param1,param2,param3) {                 \
     if (getDebugLevel() >= level ## _LEVEL) {                                  \
-      __BEGIN_MSG__(level,err_mnemonic);                                       \
-      std::cerr << boost::format(ut::message::__ERRTXT_ ## err_mnemonic)       \
-        % param1                                                               \
-        % param2                                                               \
-        % param3                                                               \
-                << std::endl;                                                  \
+      {                                                                        \
+        __BEGIN_MSG__(level,err_mnemonic)                                      \
+          << param1                                                            \
+          << param2                                                            \
+          << param3;                                                           \
+      }                                                                        \
+      __END_MSG__(level)                                                       \
     }                                                                          \
   }
 
 #define MSG_LEVEL_4(level,err_mnemonic,param1,param2,param3,param4) {          \
     if (getDebugLevel() >= level ## _LEVEL) {                                  \
-      __BEGIN_MSG__(level,err_mnemonic);                                       \
-      std::cerr << boost::format(ut::message::__ERRTXT_ ## err_mnemonic)       \
-        % param1                                                               \
-        % param2                                                               \
-        % param3                                                               \
-        % param4                                                               \
-                << std::endl;                                                  \
+      {                                                                        \
+        __BEGIN_MSG__(level,err_mnemonic)                                      \
+          << param1                                                            \
+          << param2                                                            \
+          << param3                                                            \
+          << param4;                                                           \
+      }                                                                        \
+      __END_MSG__(level)                                                       \
     }                                                                          \
   }
 
@@ -156,54 +170,27 @@ void endLogTime( const std::string& state,
 #define FATAL_3(err_mnemonic,param1,param2,param3)                             \
   MSG_LEVEL_3(FATAL,err_mnemonic,param1,param2,param3)
 
-#define TS_LENGTH 26
-
-#ifdef LOG_TIMESTAMP
-#define _PRINT_TIMESTAMP                                                       \
- {                                                                             \
- char timestamp[TS_LENGTH];                                                    \
- time_t curTime = time(0);                                                     \
- ctime_r(&curTime, &(timestamp[0]));                                           \
- timestamp[TS_LENGTH - 2] = 0;                                                 \
- memmove(&(timestamp[0]), &(timestamp[0]) + 4, TS_LENGTH - 4);                 \
- std::cout << timestamp << " ";                                                \
- }
-#else
-#define _PRINT_TIMESTAMP {}
-#endif
+#define __LOG_STRING(value) #value
+#define __LOG_LINE(line) __LOG_STRING(line)
+
+// The file & line of a debug statement make its format.
+#define __BEGIN_DEBUG__                                                        \
+  UT::LogWriter __logWriter(DEBUG_LEVEL, 0,                                    \
+                            "(" __FILE__ ":" __LOG_LINE(__LINE__) "): ");      \
+  __logWriter
 
 #ifndef NDEBUG
 #define DEBUG_1(arg1) {                                                        \
-    _PRINT_TIMESTAMP;                                                          \
-    std::cout << "DEBUG: "                                                     \
-              << "(" << __FILE__ << ":" << __LINE__ << "): "                   \
-              << arg1                                                          \
-              << std::endl;                                                    \
-    fflush(stdout);                                                            \
+    __BEGIN_DEBUG__ << arg1;                                                   \
 }
 #define DEBUG_2(arg1, arg2) {                                                  \
-    _PRINT_TIMESTAMP;                                                          \
-    std::cout << "DEBUG: "                                                     \
-              << "(" << __FILE__ << ":" << __LINE__ << "): "                   \
-              << arg1 << arg2                                                  \
-              << std::endl;                                                    \
-    fflush(stdout);                                                            \
+    __BEGIN_DEBUG__ << arg1 << arg2;                                           \
 }
 #define DEBUG_3(arg1, arg2, arg3) {                                            \
-    _PRINT_TIMESTAMP;                                                          \
-    std::cout << "DEBUG: "                                                     \
-              << "(" << __FILE__ << ":" << __LINE__ << "): "                   \
-              << arg1 << arg2 << arg3                                          \
-              << std::endl;                                                    \
-    fflush(stdout);                                                            \
+    __BEGIN_DEBUG__ << arg1 << arg2 << arg3;                                   \
 }
 #define DEBUG_4(arg1, arg2, arg3, arg4) {                                      \
-    _PRINT_TIMESTAMP;                                                          \
-    std::cout << "DEBUG: "                                                     \
-              << "(" << __FILE__ << ":" << __LINE__ << "): "                   \
-              << arg1 << arg2 << arg3 << arg4                                  \
-              << std::endl;                                                    \
-    fflush(stdout);                                                            \
+    __BEGIN_DEBUG__ << arg1 << arg2 << arg3 << arg4;                           \
 }
 
 #else
@@ -200,6 +200,29 @@ namespace UT
      }
  };
 
+  /**
+   * Exception thrown when a shared memory segment cannot be created or
+   * mapped.
+   */
+  class SharedMemoryError : public Exception
+  {
+    public :
+      SharedMemoryError( const std::string &what )
+        : Exception( "Shared Memory Error", what )
+      {}
+  };
+
+  /**
+   * Exception thrown when a capture file cannot be created or mapped.
+   */
+  class CaptureError : public Exception
+  {
+    public :
+      CaptureError( const std::string &what )
+        : Exception( "Capture Error", what )
+      {}
+  };
+
   /**
    * Exception if we are unable to convert a fix field.
    */
@@ -0,0 +1,184 @@
+#include "fixCapture.h"
+#include "exceptions.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace UT
+{
+  namespace
+  {
+    const size_t MagicSize = sizeof( CaptureMagic ) - 1 ;
+
+    size_t align( size_t size )
+    {
+      return ( size + 7 ) & ~static_cast< size_t >( 7 ) ;
+    }
+
+    int64_t now()
+    {
+      timespec time ;
+      clock_gettime( CLOCK_REALTIME, &time ) ;
+      return time.tv_sec * 1000000000LL + time.tv_nsec ;
+    }
+  }
+
+  FixCapture::FixCapture( const std::string &name, size_t fileSize )
+    : _name( name ),
+      _fileSize( align( fileSize ) ),
+      _nextIndex( 0 ),
+      _file( 0 ),
+      _dropped( 0 )
+  {
+    if( _fileSize <= MagicSize + sizeof( CaptureRecord ) )
+    {
+      throw CaptureError( _name + " : file size too small" ) ;
+    }
+    _file.store( openFile() ) ;
+  }
+
+  FixCapture::~FixCapture()
+  {
+    File *file = _file.load() ;
+    if( file != 0 )
+    {
+      closeFile( file ) ;
+    }
+    for( std::vector< File * >::iterator iFile = _files.begin() ;
+         iFile != _files.end() ;
+         ++iFile )
+    {
+      delete *iFile ;
+    }
+  }
+
+  void FixCapture::append( CaptureDirection direction,
+                           const std::string &message )
+  {
+    size_t size = sizeof( CaptureRecord ) + align( message.size() ) ;
+    if( size > _fileSize - MagicSize )
+    {
+      _dropped.fetch_add( 1, boost::memory_order_relaxed ) ;
+      return ;
+    }
+
+    for( ;; )
+    {
+      File *file = _file.load() ;
+      if( file == 0 )
+      {
+        _dropped.fetch_add( 1, boost::memory_order_relaxed ) ;
+        return ;
+      }
+
+      // Once counted as a writer, the file stays mapped until we are done,
+      // unless it was rolled over in between.
+      file->writers.fetch_add( 1 ) ;
+      if( _file.load() != file )
+      {
+        file->writers.fetch_sub( 1 ) ;
+        continue ;
+      }
+
+      size_t offset = file->offset.fetch_add( size, boost::memory_order_relaxed ) ;
+      if( offset + size <= file->size )
+      {
+        CaptureRecord *record =
+          reinterpret_cast< CaptureRecord * >( file->base + offset ) ;
+        record->timestamp = now() ;
+        record->length = message.size() ;
+        record->direction = direction ;
+        memcpy( record + 1, message.data(), message.size() ) ;
+        file->writers.fetch_sub( 1, boost::memory_order_release ) ;
+        return ;
+      }
+
+      file->writers.fetch_sub( 1 ) ;
+      roll( file ) ;
+    }
+  }
+
+  FixCapture::File *FixCapture::openFile()
+  {
+    std::string name = _name + "." + boost::lexical_cast< std::string >( _nextIndex ) ;
+    int fd = open( name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644 ) ;
+    if( fd < 0 )
+    {
+      throw CaptureError( name + " : " + strerror( errno ) ) ;
+    }
+
+    if( ftruncate( fd, _fileSize ) != 0 )
+    {
+      close( fd ) ;
+      throw CaptureError( name + " : " + strerror( errno ) ) ;
+    }
+
+    void *base = mmap( 0, _fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) ;
+    close( fd ) ;
+
+    if( base == MAP_FAILED )
+    {
+      throw CaptureError( name + " : " + strerror( errno ) ) ;
+    }
+    memcpy( base, CaptureMagic, MagicSize ) ;
+
+    File *file = new File ;
+    file->base = static_cast< char * >( base ) ;
+    file->size = _fileSize ;
+    file->offset.store( MagicSize ) ;
+    file->writers.store( 0 ) ;
+    file->name = name ;
+    _files.push_back( file ) ;
+    ++_nextIndex ;
+    return file ;
+  }
+
+  void FixCapture::closeFile( File *file )
+  {
+    // Reservations which did not fit leave the offset past the last
+    // record; the decoder stops at the zeros behind it.
+    size_t used = std::min( file->offset.load(), file->size ) ;
+    munmap( file->base, file->size ) ;
+    file->base = 0 ;
+    if( truncate( file->name.c_str(), used ) != 0 )
+    {
+      std::cout << "Cannot truncate " << file->name << " : "
+                << strerror( errno ) << std::endl ;
+    }
+  }
+
+  void FixCapture::roll( File *full )
+  {
+    boost::mutex::scoped_lock lock( _mutexOnRoll ) ;
+    if( _file.load() != full )
+    {
+      return ;
+    }
+
+    File *next = 0 ;
+    try
+    {
+      next = openFile() ;
+    }
+    catch( CaptureError &e )
+    {
+      std::cout << "Capture stopped : " << e.what() << std::endl ;
+    }
+    _file.store( next ) ;
+
+    while( full->writers.load() != 0 )
+    {
+      boost::this_thread::yield() ;
+    }
+    closeFile( full ) ;
+  }
+}
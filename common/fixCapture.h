@@ -0,0 +1,98 @@
+#ifndef UT_FIX_CAPTURE_H
+#define UT_FIX_CAPTURE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace UT
+{
+  /**
+   * The header of a captured message, followed by its bytes. Records start
+   * on 8 byte boundaries.
+   */
+  struct CaptureRecord
+  {
+    int64_t timestamp ;   // ns since the epoch
+    uint32_t length ;     // of the message
+    char direction ;      // CaptureDirection
+    char pad[ 3 ] ;
+  };
+
+  enum CaptureDirection
+  {
+    CaptureDirection_INBOUND = 'I',
+    CaptureDirection_OUTBOUND = 'O'
+  };
+
+  const char CaptureMagic[] = "UTFIXCAP" ;
+
+  /**
+   * \class FixCapture
+   *
+   * Raw FIX messages and the time they were seen, appended to memory mapped
+   * files: name.0, name.1... each of a fixed size. Appending copies the
+   * message into the mapping, nothing more; the kernel writes it out.
+   * umatch_capdecode prints the files.
+   *
+   * Any thread may append. A writer reserves its record with an atomic
+   * add; the one finding the file full maps the next, and the full one is
+   * unmapped & truncated to what it holds once its last writer is done.
+   * If the next file cannot be created, capturing stops.
+   *
+   */
+  class FixCapture : private boost::noncopyable
+  {
+    public :
+      /**
+       * @param The name of the files, without the index.
+       * @param The size of each file in bytes.
+       */
+      FixCapture( const std::string &name, size_t fileSize ) ;
+
+      ~FixCapture() ;
+
+      void append( CaptureDirection direction, const std::string &message ) ;
+
+      /**
+       * @brief Messages too long for a file, which were not captured.
+       */
+      long getDropped() const { return _dropped.load( boost::memory_order_relaxed ) ; }
+
+    private :
+      struct File
+      {
+        char *base ;
+        size_t size ;
+        boost::atomic< size_t > offset ;
+        boost::atomic< long > writers ;
+        std::string name ;
+      };
+
+      /**
+       * Every file mapped so far. A writer may still look at the counters
+       * of a file after it is closed, so they are only deleted with us.
+       */
+      std::vector< File * > _files ;
+
+      std::string _name ;
+      size_t _fileSize ;
+      long _nextIndex ;
+      boost::atomic< File * > _file ;
+      boost::atomic< long > _dropped ;
+
+      /**
+       * Held to map the next file.
+       */
+      boost::mutex _mutexOnRoll ;
+
+      File *openFile() ;
+      void closeFile( File *file ) ;
+      void roll( File *full ) ;
+  };
+}
+
+#endif // UT_FIX_CAPTURE_H
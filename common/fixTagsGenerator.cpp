@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+/**
+ * Generate the tag tables of umatch_capdecode from a QuickFIX data
+ * dictionary: the name of every field and the description of every value
+ * it enumerates, as sorted arrays compiled into the decoder.
+ *
+ *   umatch_fixtags FIX_umatch.xml fixTags.h
+ */
+namespace
+{
+  struct Value
+  {
+    int tag ;
+    std::string value ;
+    std::string description ;
+
+    bool operator<( const Value &other ) const
+    {
+      return tag < other.tag || ( tag == other.tag && value < other.value ) ;
+    }
+  };
+
+  struct Field
+  {
+    int tag ;
+    std::string name ;
+
+    bool operator<( const Field &other ) const
+    {
+      return tag < other.tag ;
+    }
+  };
+
+  std::string getProperty( xmlNode *node, const char *name )
+  {
+    xmlChar *property = xmlGetProp( node, reinterpret_cast< const xmlChar * >( name ) ) ;
+    if( property == 0 )
+    {
+      return "" ;
+    }
+    std::string value( reinterpret_cast< const char * >( property ) ) ;
+    xmlFree( property ) ;
+    return value ;
+  }
+
+  bool isElement( xmlNode *node, const char *name )
+  {
+    return node->type == XML_ELEMENT_NODE
+      && xmlStrcmp( node->name, reinterpret_cast< const xmlChar * >( name ) ) == 0 ;
+  }
+
+  std::string quote( const std::string &text )
+  {
+    std::string quoted( "\"" ) ;
+    for( std::string::const_iterator c = text.begin() ; c != text.end() ; ++c )
+    {
+      if( *c == '"' || *c == '\\' )
+      {
+        quoted += '\\' ;
+      }
+      quoted += *c ;
+    }
+    return quoted + "\"" ;
+  }
+
+  void readFields( xmlNode *fields,
+                   std::vector< Field > &names,
+                   std::vector< Value > &values )
+  {
+    for( xmlNode *node = fields->children ; node != 0 ; node = node->next )
+    {
+      if( !isElement( node, "field" ) )
+      {
+        continue ;
+      }
+
+      Field field ;
+      field.tag = atoi( getProperty( node, "number" ).c_str() ) ;
+      field.name = getProperty( node, "name" ) ;
+      names.push_back( field ) ;
+
+      for( xmlNode *child = node->children ; child != 0 ; child = child->next )
+      {
+        if( isElement( child, "value" ) )
+        {
+          Value value ;
+          value.tag = field.tag ;
+          value.value = getProperty( child, "enum" ) ;
+          value.description = getProperty( child, "description" ) ;
+          values.push_back( value ) ;
+        }
+      }
+    }
+  }
+
+  void write( std::ostream &out,
+              const std::string &dictionary,
+              const std::vector< Field > &names,
+              const std::vector< Value > &values )
+  {
+    out << "// Generated by umatch_fixtags from " << dictionary << ", do not edit.\n"
+        << "#ifndef UT_FIX_TAGS_H\n"
+        << "#define UT_FIX_TAGS_H\n\n"
+        << "namespace UT\n{\n"
+        << "  struct FixTagName\n  {\n"
+        << "    int tag ;\n    const char *name ;\n  };\n\n"
+        << "  struct FixValueName\n  {\n"
+        << "    int tag ;\n    const char *value ;\n    const char *description ;\n  };\n\n"
+        << "  // By tag.\n"
+        << "  const FixTagName FixTagNames[] =\n  {\n" ;
+    for( std::vector< Field >::const_iterator iField = names.begin() ;
+         iField != names.end() ;
+         ++iField )
+    {
+      out << "    { " << iField->tag << ", " << quote( iField->name ) << " },\n" ;
+    }
+    out << "  };\n\n"
+        << "  // By tag, then value.\n"
+        << "  const FixValueName FixValueNames[] =\n  {\n" ;
+    for( std::vector< Value >::const_iterator iValue = values.begin() ;
+         iValue != values.end() ;
+         ++iValue )
+    {
+      out << "    { " << iValue->tag << ", " << quote( iValue->value ) << ", "
+          << quote( iValue->description ) << " },\n" ;
+    }
+    out << "  };\n"
+        << "}\n\n"
+        << "#endif // UT_FIX_TAGS_H\n" ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  if( argc != 3 )
+  {
+    std::cout << "Usage : umatch_fixtags dictionary header" << std::endl ;
+    return 1 ;
+  }
+
+  xmlDoc *document = xmlReadFile( argv[ 1 ], 0, 0 ) ;
+  if( document == 0 )
+  {
+    std::cerr << "Cannot parse " << argv[ 1 ] << std::endl ;
+    return 1 ;
+  }
+
+  std::vector< Field > names ;
+  std::vector< Value > values ;
+  xmlNode *root = xmlDocGetRootElement( document ) ;
+  for( xmlNode *node = root ? root->children : 0 ; node != 0 ; node = node->next )
+  {
+    if( isElement( node, "fields" ) )
+    {
+      readFields( node, names, values ) ;
+    }
+  }
+  xmlFreeDoc( document ) ;
+  xmlCleanupParser() ;
+
+  if( names.empty() )
+  {
+    std::cerr << "No fields in " << argv[ 1 ] << std::endl ;
+    return 1 ;
+  }
+
+  std::stable_sort( names.begin(), names.end() ) ;
+  std::stable_sort( values.begin(), values.end() ) ;
+
+  std::ofstream header( argv[ 2 ] ) ;
+  write( header, argv[ 1 ], names, values ) ;
+  if( !header )
+  {
+    std::cerr << "Cannot write " << argv[ 2 ] << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
@@ -0,0 +1,221 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <boost/thread.hpp>
+
+namespace UT
+{
+  namespace
+  {
+    const char *StageNames[ LatencyStage_COUNT ] =
+    {
+      "receive",
+      "crack",
+      "route",
+      "match",
+      "encode",
+      "send"
+    };
+
+    struct ThreadLatency
+    {
+      LatencyHistogram histograms[ LatencyStage_COUNT ] ;
+      long long starts[ LatencyStage_COUNT ] ;
+    };
+
+    boost::mutex threadsMutex ;
+    std::vector< ThreadLatency * > threads ;
+
+    /**
+     * The counts of the threads that have ended.
+     */
+    ThreadLatency retired ;
+
+    void retire( ThreadLatency *threadLatency )
+    {
+      boost::mutex::scoped_lock lock( threadsMutex ) ;
+      for( int stage = 0 ; stage < LatencyStage_COUNT ; ++stage )
+      {
+        retired.histograms[ stage ].add( threadLatency->histograms[ stage ] ) ;
+      }
+      threads.erase( std::find( threads.begin(), threads.end(), threadLatency ) ) ;
+      delete threadLatency ;
+    }
+
+    boost::thread_specific_ptr< ThreadLatency > threadLatency( &retire ) ;
+
+    ThreadLatency &getThreadLatency()
+    {
+      ThreadLatency *latency = threadLatency.get() ;
+      if( latency == 0 )
+      {
+        latency = new ThreadLatency() ;
+        {
+          boost::mutex::scoped_lock lock( threadsMutex ) ;
+          threads.push_back( latency ) ;
+        }
+        threadLatency.reset( latency ) ;
+      }
+      return *latency ;
+    }
+
+    void runDumps( long seconds )
+    {
+      while( true )
+      {
+        boost::this_thread::sleep( boost::posix_time::seconds( seconds ) ) ;
+        Latency::dump( std::cout ) ;
+      }
+    }
+  }
+
+  LatencyHistogram::LatencyHistogram()
+  {
+    for( int index = 0 ; index < Counts ; ++index )
+    {
+      _counts[ index ].store( 0, boost::memory_order_relaxed ) ;
+    }
+    _total.store( 0, boost::memory_order_relaxed ) ;
+    _max.store( 0, boost::memory_order_relaxed ) ;
+  }
+
+  void LatencyHistogram::add( const LatencyHistogram &histogram )
+  {
+    for( int index = 0 ; index < Counts ; ++index )
+    {
+      _counts[ index ].fetch_add(
+          histogram._counts[ index ].load( boost::memory_order_relaxed ),
+          boost::memory_order_relaxed ) ;
+    }
+    _total.fetch_add( histogram.getCount(), boost::memory_order_relaxed ) ;
+    if( histogram.getMax() > getMax() )
+    {
+      _max.store( histogram.getMax(), boost::memory_order_relaxed ) ;
+    }
+  }
+
+  long long LatencyHistogram::getValueAtPercentile( double percentile ) const
+  {
+    // The counts of another thread may be ahead of its total, so the
+    // buckets are summed rather than trusted to reach the total.
+    long long counts[ Counts ] ;
+    long long total = 0 ;
+    for( int index = 0 ; index < Counts ; ++index )
+    {
+      counts[ index ] = _counts[ index ].load( boost::memory_order_relaxed ) ;
+      total += counts[ index ] ;
+    }
+    if( total == 0 )
+    {
+      return 0 ;
+    }
+
+    long long wanted = static_cast< long long >( total * percentile / 100 ) ;
+    if( wanted < 1 )
+    {
+      wanted = 1 ;
+    }
+
+    long long seen = 0 ;
+    for( int index = 0 ; index < Counts ; ++index )
+    {
+      seen += counts[ index ] ;
+      if( seen >= wanted )
+      {
+        long long value = toHighestValue( index ) ;
+        return value < getMax() ? value : getMax() ;
+      }
+    }
+    return getMax() ;
+  }
+
+  long long LatencyHistogram::toHighestValue( int index )
+  {
+    if( index < SubBuckets )
+    {
+      return index ;
+    }
+    int shift = index / HalfSubBuckets - 1 ;
+    long long subBucket = index % HalfSubBuckets + HalfSubBuckets ;
+    return ( ( subBucket + 1 ) << shift ) - 1 ;
+  }
+
+  void Latency::start( LatencyStage stage )
+  {
+    getThreadLatency().starts[ stage ] = now() ;
+  }
+
+  void Latency::stop( LatencyStage stage )
+  {
+    ThreadLatency &latency = getThreadLatency() ;
+    if( latency.starts[ stage ] != 0 )
+    {
+      latency.histograms[ stage ].record( now() - latency.starts[ stage ] ) ;
+      latency.starts[ stage ] = 0 ;
+    }
+  }
+
+  void Latency::record( LatencyStage stage, long long ns )
+  {
+    getThreadLatency().histograms[ stage ].record( ns ) ;
+  }
+
+  bool Latency::toStage( const std::string &name, LatencyStage &stage )
+  {
+    for( int index = 0 ; index < LatencyStage_COUNT ; ++index )
+    {
+      if( name == StageNames[ index ] )
+      {
+        stage = static_cast< LatencyStage >( index ) ;
+        return true ;
+      }
+    }
+    return false ;
+  }
+
+  const char *Latency::toString( LatencyStage stage )
+  {
+    return StageNames[ stage ] ;
+  }
+
+  void Latency::dump( std::ostream &out )
+  {
+    boost::mutex::scoped_lock lock( threadsMutex ) ;
+
+    out << std::left << std::setw( 10 ) << "stage (us)" << std::right
+        << std::setw( 12 ) << "count"
+        << std::setw( 10 ) << "p50"
+        << std::setw( 10 ) << "p99"
+        << std::setw( 10 ) << "p99.9"
+        << std::setw( 10 ) << "max" << std::endl ;
+
+    out << std::fixed << std::setprecision( 1 ) ;
+    for( int stage = 0 ; stage < LatencyStage_COUNT ; ++stage )
+    {
+      LatencyHistogram merged ;
+      merged.add( retired.histograms[ stage ] ) ;
+      for( std::vector< ThreadLatency * >::const_iterator iThread = threads.begin() ;
+           iThread != threads.end() ;
+           ++iThread )
+      {
+        merged.add( ( *iThread )->histograms[ stage ] ) ;
+      }
+
+      out << std::left << std::setw( 10 ) << StageNames[ stage ] << std::right
+          << std::setw( 12 ) << merged.getCount()
+          << std::setw( 10 ) << merged.getValueAtPercentile( 50 ) / 1000.0
+          << std::setw( 10 ) << merged.getValueAtPercentile( 99 ) / 1000.0
+          << std::setw( 10 ) << merged.getValueAtPercentile( 99.9 ) / 1000.0
+          << std::setw( 10 ) << merged.getMax() / 1000.0 << std::endl ;
+    }
+    out.unsetf( std::ios_base::floatfield ) ;
+  }
+
+  void Latency::startDumping( long seconds )
+  {
+    boost::thread dumpThread( &runDumps, seconds ) ;
+  }
+}
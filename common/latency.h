@@ -0,0 +1,215 @@
+#ifndef UT_LATENCY_H
+#define UT_LATENCY_H
+
+#include <time.h>
+#include <ostream>
+#include <string>
+#include <boost/atomic.hpp>
+
+namespace UT
+{
+  /**
+   * The stages an order goes through, each timed on its own. The stages of
+   * a message are nested: receive covers the whole message, match covers
+   * the replies it makes.
+   */
+  enum LatencyStage
+  {
+    LatencyStage_RECEIVE,  // the application handling an inbound message
+    LatencyStage_CRACK,    // the message, parsed & risk checked, up to the market
+    LatencyStage_ROUTE,    // the market finding the order book
+    LatencyStage_MATCH,    // the order book, under its lock
+    LatencyStage_ENCODE,   // building a reply
+    LatencyStage_SEND,     // handing the reply to its session
+    LatencyStage_COUNT
+  };
+
+  /**
+   * \class LatencyHistogram
+   *
+   * Counts of latencies in nanoseconds, HDR style: exact below 32 ns, then
+   * 16 buckets per power of 2, so every value is known to within 1/16th.
+   *
+   * Only its own thread records into a histogram. Counters are atomic but
+   * are only loaded & stored, without a locked instruction, so that other
+   * threads can merge them while it runs.
+   *
+   */
+  class LatencyHistogram
+  {
+    public :
+      LatencyHistogram() ;
+
+      /**
+       * @brief Count a latency. Owner thread only.
+       */
+      void record( long long ns )
+      {
+        if( ns < 0 )
+        {
+          ns = 0 ;
+        }
+        increment( _counts[ toIndex( ns ) ] ) ;
+        increment( _total ) ;
+        if( ns > _max.load( boost::memory_order_relaxed ) )
+        {
+          _max.store( ns, boost::memory_order_relaxed ) ;
+        }
+      }
+
+      /**
+       * @brief Add the counts of another histogram, e.g. of another thread.
+       */
+      void add( const LatencyHistogram &histogram ) ;
+
+      long long getCount() const
+      {
+        return _total.load( boost::memory_order_relaxed ) ;
+      }
+
+      long long getMax() const
+      {
+        return _max.load( boost::memory_order_relaxed ) ;
+      }
+
+      /**
+       * @brief The highest latency of the bucket holding a percentile.
+       *
+       * @param The percentile, e.g. 99.9.
+       */
+      long long getValueAtPercentile( double percentile ) const ;
+
+    private :
+      enum
+      {
+        SubBucketBits = 5,
+        SubBuckets = 1 << SubBucketBits,
+        HalfSubBuckets = SubBuckets / 2,
+        Counts = ( 66 - SubBucketBits ) * HalfSubBuckets
+      };
+
+      typedef boost::atomic< long long > Counter ;
+
+      Counter _counts[ Counts ] ;
+      Counter _total ;
+      Counter _max ;
+
+      static void increment( Counter &counter )
+      {
+        counter.store( counter.load( boost::memory_order_relaxed ) + 1,
+                       boost::memory_order_relaxed ) ;
+      }
+
+      static int toIndex( long long ns )
+      {
+        if( ns < SubBuckets )
+        {
+          return static_cast< int >( ns ) ;
+        }
+        int magnitude = 63 - __builtin_clzll( ns ) ;
+        int shift = magnitude - ( SubBucketBits - 1 ) ;
+        return shift * HalfSubBuckets + static_cast< int >( ns >> shift ) ;
+      }
+
+      static long long toHighestValue( int index ) ;
+  };
+
+  /**
+   * \class Latency
+   *
+   * A set of histograms per thread, one per stage, and the time each stage
+   * of the thread was started. A thread gets its set the first time it
+   * stamps a stage; when it ends, its counts are kept for the dumps.
+   *
+   * Use the LATENCY_START & LATENCY_STOP macros, which cost nothing unless
+   * built with LATENCY_HISTOGRAMS.
+   *
+   */
+  class Latency
+  {
+    public :
+      /**
+       * @brief The clock stages are stamped with, in nanoseconds.
+       */
+      static long long now()
+      {
+        timespec time ;
+        clock_gettime( CLOCK_MONOTONIC, &time ) ;
+        return time.tv_sec * 1000000000LL + time.tv_nsec ;
+      }
+
+      static void start( LatencyStage stage ) ;
+
+      /**
+       * @brief Count the time since the stage was started. Does nothing
+       * if it is not running, e.g. stopped already.
+       */
+      static void stop( LatencyStage stage ) ;
+
+      /**
+       * @brief Count a latency measured by the caller.
+       */
+      static void record( LatencyStage stage, long long ns ) ;
+
+      /**
+       * @brief Find a stage by its name, as printed by dump().
+       *
+       * @return false if there is no such stage.
+       */
+      static bool toStage( const std::string &name, LatencyStage &stage ) ;
+
+      static const char *toString( LatencyStage stage ) ;
+
+      /**
+       * @brief Merge the histograms of all the threads & print the count
+       * and the percentiles of every stage, in microseconds.
+       */
+      static void dump( std::ostream &out ) ;
+
+      /**
+       * @brief Dump to stdout every few seconds, from a thread of its own.
+       */
+      static void startDumping( long seconds ) ;
+  };
+
+  /**
+   * \class LatencyStamp
+   *
+   * Starts a stage and stops it when it goes out of scope, unless it was
+   * stopped before, so that early returns & exceptions are timed too.
+   *
+   */
+  class LatencyStamp
+  {
+    public :
+      explicit LatencyStamp( LatencyStage stage ) : _stage( stage )
+      {
+        Latency::start( stage ) ;
+      }
+
+      ~LatencyStamp() { Latency::stop( _stage ) ; }
+
+    private :
+      LatencyStage _stage ;
+
+      LatencyStamp( const LatencyStamp & ) ;
+      LatencyStamp &operator=( const LatencyStamp & ) ;
+  };
+}
+
+/**
+ * LATENCY_SCOPE starts a stage which LATENCY_STOP may stop early, else the
+ * end of the scope does.
+ */
+#ifdef LATENCY_HISTOGRAMS
+#define LATENCY_START( stage ) UT::Latency::start( UT::LatencyStage_ ## stage )
+#define LATENCY_STOP( stage ) UT::Latency::stop( UT::LatencyStage_ ## stage )
+#define LATENCY_SCOPE( stage ) \
+  UT::LatencyStamp latencyStamp ## stage( UT::LatencyStage_ ## stage )
+#else
+#define LATENCY_START( stage )
+#define LATENCY_STOP( stage )
+#define LATENCY_SCOPE( stage )
+#endif
+
+#endif // UT_LATENCY_H
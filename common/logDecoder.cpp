@@ -0,0 +1,32 @@
+#include <iostream>
+
+#include "binaryLog.h"
+
+/**
+ * Print the binary logs written by UT::BinaryLog as text.
+ *
+ *   umatch_logdecode log files...
+ */
+int main( int argc, char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage : umatch_logdecode log files..." << std::endl ;
+    return 1 ;
+  }
+
+  try
+  {
+    for( int file = 1 ; file < argc ; ++file )
+    {
+      UT::BinaryLog::decode( argv[ file ], std::cout ) ;
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cout.flush() ;
+    std::cerr << "stopping due to error " << e.what() << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
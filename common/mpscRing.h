@@ -0,0 +1,130 @@
+#ifndef UT_MPSC_RING_H
+#define UT_MPSC_RING_H
+
+#include <stdint.h>
+#include <boost/atomic.hpp>
+
+#include "spscRing.h"
+
+namespace UT
+{
+  /**
+   * \class MpscRing
+   *
+   * A bounded multiple producer / single consumer ring of fixed size
+   * records, preallocated so that a record costs no allocation.
+   *
+   * Producers take a slot with one compare & swap and never wait: claim()
+   * fails when the ring is full. Every slot carries a sequence number
+   * telling whether it is free, filled or being filled, so the consumer
+   * sees the records in the order their slots were claimed and stops at
+   * one still being filled. Capacity must be a power of 2.
+   *
+   */
+  template< class T, unsigned long Capacity >
+  class MpscRing
+  {
+    public :
+      MpscRing() : _head( 0 )
+      {
+        _tail.store( 0, boost::memory_order_relaxed ) ;
+        for( uint64_t i = 0 ; i < Capacity ; ++i )
+        {
+          _slots[i].sequence.store( i, boost::memory_order_relaxed ) ;
+        }
+      }
+
+      /**
+       * @brief Get a slot for a record. Any thread.
+       *
+       * @param Set to the ticket to be passed to publish().
+       *
+       * @return The slot to be filled, or 0 if the ring is full.
+       */
+      T *claim( uint64_t &ticket )
+      {
+        uint64_t tail = _tail.load( boost::memory_order_relaxed ) ;
+        for( ; ; )
+        {
+          Slot &slot = _slots[ tail & ( Capacity - 1 ) ] ;
+          int64_t lag = static_cast< int64_t >(
+              slot.sequence.load( boost::memory_order_acquire ) - tail ) ;
+          if( lag < 0 )
+          {
+            return 0 ;
+          }
+          if( lag == 0 )
+          {
+            if( _tail.compare_exchange_weak( tail, tail + 1,
+                                             boost::memory_order_relaxed ) )
+            {
+              ticket = tail ;
+              return &slot.record ;
+            }
+          }
+          else
+          {
+            tail = _tail.load( boost::memory_order_relaxed ) ;
+          }
+        }
+      }
+
+      /**
+       * @brief Make the slot of a ticket visible to the consumer.
+       */
+      void publish( uint64_t ticket )
+      {
+        _slots[ ticket & ( Capacity - 1 ) ].sequence.store(
+            ticket + 1, boost::memory_order_release ) ;
+      }
+
+      /**
+       * @brief Get the oldest record without removing it. Consumer side only.
+       *
+       * @return The record, or 0 if there is none or it is still being
+       *         filled.
+       */
+      const T *front()
+      {
+        Slot &slot = _slots[ _head & ( Capacity - 1 ) ] ;
+        if( slot.sequence.load( boost::memory_order_acquire ) != _head + 1 )
+        {
+          return 0 ;
+        }
+        return &slot.record ;
+      }
+
+      /**
+       * @brief Release the record returned by front().
+       */
+      void pop()
+      {
+        _slots[ _head & ( Capacity - 1 ) ].sequence.store(
+            _head + Capacity, boost::memory_order_release ) ;
+        ++_head ;
+      }
+
+    private :
+      struct Slot
+      {
+        boost::atomic< uint64_t > sequence ;
+        T record ;
+      };
+
+      /**
+       * Written by the producers.
+       */
+      boost::atomic< uint64_t > _tail ;
+      char _padTail[ CACHE_LINE_SIZE - sizeof( uint64_t ) ] ;
+
+      /**
+       * Only the consumer touches it.
+       */
+      uint64_t _head ;
+      char _padHead[ CACHE_LINE_SIZE - sizeof( uint64_t ) ] ;
+
+      Slot _slots[ Capacity ] ;
+  };
+}
+
+#endif // UT_MPSC_RING_H
@@ -0,0 +1,83 @@
+#ifndef UT_SEQ_LOCK_H
+#define UT_SEQ_LOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <boost/atomic.hpp>
+
+namespace UT
+{
+  /**
+   * \class SeqLock
+   *
+   * A value written by one thread at a time and read by any number of
+   * threads, none of which ever waits for the writer or slows it down.
+   *
+   * The sequence is odd while a write is under way. A reader copies the
+   * value and tries again if the sequence was odd or moved meanwhile, so it
+   * only ever keeps a whole value. The value is copied as bytes and must
+   * hold no pointers it owns.
+   *
+   */
+  template< class T >
+  class SeqLock
+  {
+    public :
+      SeqLock() : _sequence( 0 ) {}
+
+      /**
+       * @brief Publish a new value. Writers must not overlap, the caller
+       * holds whatever lock orders them.
+       */
+      void write( const T &value )
+      {
+        const uint64_t sequence = _sequence.load( boost::memory_order_relaxed ) ;
+        _sequence.store( sequence + 1, boost::memory_order_relaxed ) ;
+        boost::atomic_thread_fence( boost::memory_order_release ) ;
+        memcpy( &_value, &value, sizeof( T ) ) ;
+        _sequence.store( sequence + 2, boost::memory_order_release ) ;
+      }
+
+      /**
+       * @brief Copy the last value published.
+       *
+       * @return Its version, which grows with every write. 0 if nothing was
+       * written yet.
+       */
+      uint64_t read( T &value ) const
+      {
+        for( ;; )
+        {
+          const uint64_t before = _sequence.load( boost::memory_order_acquire ) ;
+          if( before & 1 )
+          {
+            continue ;
+          }
+          memcpy( &value, &_value, sizeof( T ) ) ;
+          boost::atomic_thread_fence( boost::memory_order_acquire ) ;
+          if( _sequence.load( boost::memory_order_relaxed ) == before )
+          {
+            return before / 2 ;
+          }
+        }
+      }
+
+      /**
+       * @brief The version read() would return now, to skip reading a value
+       * already seen.
+       */
+      uint64_t getVersion() const
+      {
+        return _sequence.load( boost::memory_order_acquire ) / 2 ;
+      }
+
+    private :
+      boost::atomic< uint64_t > _sequence ;
+      T _value ;
+
+      SeqLock( const SeqLock & ) ;
+      SeqLock &operator=( const SeqLock & ) ;
+  };
+}
+
+#endif // UT_SEQ_LOCK_H
@@ -0,0 +1,60 @@
+#include "sharedMemory.h"
+#include "exceptions.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UT
+{
+  SharedMemory::SharedMemory( const std::string &name,
+                              size_t size,
+                              bool create )
+    : _name( name ),
+      _size( size ),
+      _address( 0 )
+  {
+    int flags = create ? ( O_CREAT | O_RDWR ) : O_RDWR ;
+    int fd = shm_open( _name.c_str(), flags, 0660 ) ;
+    if( fd < 0 )
+    {
+      throw SharedMemoryError( _name + " : " + strerror( errno ) ) ;
+    }
+
+    if( create && ftruncate( fd, _size ) != 0 )
+    {
+      close( fd ) ;
+      throw SharedMemoryError( _name + " : " + strerror( errno ) ) ;
+    }
+
+    _address = mmap( 0, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) ;
+    close( fd ) ;
+
+    if( _address == MAP_FAILED )
+    {
+      _address = 0 ;
+      throw SharedMemoryError( _name + " : " + strerror( errno ) ) ;
+    }
+
+    if( create )
+    {
+      memset( _address, 0, _size ) ;
+    }
+  }
+
+  SharedMemory::~SharedMemory()
+  {
+    if( _address != 0 )
+    {
+      munmap( _address, _size ) ;
+    }
+  }
+
+  void SharedMemory::unlink()
+  {
+    shm_unlink( _name.c_str() ) ;
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef UT_SHARED_MEMORY_H
+#define UT_SHARED_MEMORY_H
+
+#include <string>
+#include <boost/noncopyable.hpp>
+
+namespace UT
+{
+  /**
+   * \class SharedMemory
+   *
+   * A named POSIX shared memory segment (/dev/shm) mapped into this process.
+   * The segment stays mapped as long as this object lives.
+   *
+   */
+  class SharedMemory : private boost::noncopyable
+  {
+    public :
+      /**
+       * @brief Create or open the segment and map it.
+       *
+       * @param The name of the segment, e.g. "/umatch.client1.req".
+       *
+       * @param The size of the segment in bytes.
+       *
+       * @param If true, the segment is created if it does not exist and
+       *        zeroed. Otherwise it must already exist.
+       */
+      SharedMemory( const std::string &name, size_t size, bool create ) ;
+
+      ~SharedMemory() ;
+
+      void *getAddress() const { return _address ; }
+      size_t getSize() const { return _size ; }
+      const std::string &getName() const { return _name ; }
+
+      /**
+       * @brief Remove the name from /dev/shm. Mappings stay valid.
+       */
+      void unlink() ;
+
+    private :
+      std::string _name ;
+      size_t _size ;
+      void *_address ;
+  };
+}
+
+#endif // UT_SHARED_MEMORY_H
@@ -0,0 +1,132 @@
+#ifndef UT_SPSC_RING_H
+#define UT_SPSC_RING_H
+
+#include <stdint.h>
+#include <boost/atomic.hpp>
+
+namespace UT
+{
+  /**
+   * Size of a cache line. Indices written by different threads are kept on
+   * different cache lines so that the producer and consumer do not keep
+   * invalidating each other.
+   */
+  const unsigned long CACHE_LINE_SIZE = 64 ;
+
+  /**
+   * \class SpscRing
+   *
+   * A bounded single producer / single consumer ring of fixed size records.
+   *
+   * The ring holds no pointers, so it can be placed in a shared memory
+   * segment and used between two processes. Capacity must be a power of 2.
+   *
+   */
+  template< class T, unsigned long Capacity >
+  class SpscRing
+  {
+    public :
+      /**
+       * @brief Reset the ring. Only call this when neither side is using it.
+       */
+      void init()
+      {
+        _head.store( 0, boost::memory_order_relaxed ) ;
+        _tail.store( 0, boost::memory_order_relaxed ) ;
+        _cachedHead = 0 ;
+        _cachedTail = 0 ;
+      }
+
+      /**
+       * @brief Get the slot for the next record. Producer side only.
+       *
+       * @return The slot to be filled, or 0 if the ring is full.
+       */
+      T *claim()
+      {
+        const uint64_t tail = _tail.load( boost::memory_order_relaxed ) ;
+        if( tail - _cachedHead >= Capacity )
+        {
+          _cachedHead = _head.load( boost::memory_order_acquire ) ;
+          if( tail - _cachedHead >= Capacity )
+          {
+            return 0 ;
+          }
+        }
+        return &_records[ tail & ( Capacity - 1 ) ] ;
+      }
+
+      /**
+       * @brief Make the slot returned by claim() visible to the consumer.
+       */
+      void publish()
+      {
+        _tail.store( _tail.load( boost::memory_order_relaxed ) + 1,
+                     boost::memory_order_release ) ;
+      }
+
+      /**
+       * @brief Copy a record into the ring. Producer side only.
+       *
+       * @return False if the ring is full.
+       */
+      bool push( const T &record )
+      {
+        T *slot = claim() ;
+        if( slot == 0 )
+        {
+          return false ;
+        }
+        *slot = record ;
+        publish() ;
+        return true ;
+      }
+
+      /**
+       * @brief Get the oldest record without removing it. Consumer side only.
+       *
+       * @return The record, or 0 if the ring is empty.
+       */
+      const T *front()
+      {
+        const uint64_t head = _head.load( boost::memory_order_relaxed ) ;
+        if( head == _cachedTail )
+        {
+          _cachedTail = _tail.load( boost::memory_order_acquire ) ;
+          if( head == _cachedTail )
+          {
+            return 0 ;
+          }
+        }
+        return &_records[ head & ( Capacity - 1 ) ] ;
+      }
+
+      /**
+       * @brief Release the record returned by front().
+       */
+      void pop()
+      {
+        _head.store( _head.load( boost::memory_order_relaxed ) + 1,
+                     boost::memory_order_release ) ;
+      }
+
+    private :
+      /**
+       * Written by the consumer.
+       */
+      boost::atomic< uint64_t > _head ;
+      uint64_t _cachedTail ;
+      char _padHead[ CACHE_LINE_SIZE - 2 * sizeof( uint64_t ) ] ;
+
+      /**
+       * Written by the producer.
+       */
+      boost::atomic< uint64_t > _tail ;
+      uint64_t _cachedHead ;
+      char _padTail[ CACHE_LINE_SIZE - 2 * sizeof( uint64_t ) ] ;
+
+      T _records[ Capacity ] ;
+  };
+}
+
+#endif // UT_SPSC_RING_H
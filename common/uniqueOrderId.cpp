@@ -1,32 +1,160 @@
 #include "uniqueOrderId.h"
-#include <sstream>
+#include "convertor.h"
+#include "exceptions.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/thread/tss.hpp>
 
 namespace UT {
 
-  long UniqueOrderId::_orderId;
+  namespace
+  {
+    struct Block
+    {
+      OrderId next ;
+      OrderId end ;
+    };
+
+    boost::thread_specific_ptr< Block > threadBlock ;
+
+    /**
+     * The first id of the next block to hand out, and the ids up to which
+     * the file allows it. Without a file, every id is allowed.
+     */
+    boost::atomic< OrderId > nextBlock( 0 ) ;
+    boost::atomic< OrderId > reserved( std::numeric_limits< OrderId >::max() ) ;
+
+    std::string idFileName ;
+    boost::mutex mutexOnFile ;
+    boost::once_flag startOnce = BOOST_ONCE_INIT ;
+
+    OrderId getMicroseconds()
+    {
+      boost::posix_time::ptime epoch( boost::gregorian::date( 1970, 1, 1 ) ) ;
+      return ( boost::posix_time::microsec_clock::universal_time() - epoch )
+        .total_microseconds() ;
+    }
+
+    void start()
+    {
+      if( nextBlock.load() == 0 )
+      {
+        nextBlock.store( getMicroseconds() ) ;
+      }
+    }
+
+    /**
+     * Replaces the file in one go, so that a crash leaves the old mark or
+     * the new one.
+     */
+    bool save( OrderId mark )
+    {
+      std::string temporary = idFileName + ".tmp" ;
+      int fd = open( temporary.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 ) ;
+      if( fd < 0 )
+      {
+        return false ;
+      }
+      std::string text = UnsignedIntConvertor::convert( mark ) + "\n" ;
+      bool written = write( fd, text.data(), text.size() )
+                       == static_cast< ssize_t >( text.size() )
+                     && fsync( fd ) == 0 ;
+      close( fd ) ;
+      return written && rename( temporary.c_str(), idFileName.c_str() ) == 0 ;
+    }
+
+    void reserve( OrderId end )
+    {
+      boost::mutex::scoped_lock lock( mutexOnFile ) ;
+      if( end <= reserved.load() )
+      {
+        return ;
+      }
+      OrderId mark = end + UniqueOrderId::ReservedIds ;
+      if( !save( mark ) )
+      {
+        std::cout << "Cannot save the order ids to " << idFileName << " : "
+                  << strerror( errno ) << std::endl ;
+      }
+      reserved.store( mark ) ;
+    }
+  }
 
-  std::string UniqueOrderId::get()
+  OrderId UniqueOrderId::get()
   {
-    if ( _orderId == 0 )
+    Block *block = threadBlock.get() ;
+    if( block == 0 )
     {
-      boost::posix_time::ptime currTime =
-        boost::posix_time::microsec_clock::local_time();
-      boost::posix_time::ptime epoch =
-        boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1));
-      _orderId = (currTime - epoch).total_milliseconds();
+      boost::call_once( startOnce, &start ) ;
+      block = new Block() ;
+      threadBlock.reset( block ) ;
     }
-    else
-      ++_orderId;
 
-    return makeString();
+    if( block->next == block->end )
+    {
+      block->next = nextBlock.fetch_add( BlockSize ) ;
+      block->end = block->next + BlockSize ;
+      if( block->end > reserved.load() )
+      {
+        reserve( block->end ) ;
+      }
+    }
+    return block->next++ ;
+  }
+
+  void UniqueOrderId::load( const std::string &fileName )
+  {
+    OrderId mark = 0 ;
+    std::ifstream file( fileName.c_str() ) ;
+    if( file && !( file >> mark ) )
+    {
+      throw ConfigError( fileName + " does not hold an order id" ) ;
+    }
+    file.close() ;
+
+    idFileName = fileName ;
+    nextBlock.store( mark != 0 ? mark : getMicroseconds() ) ;
+    reserved.store( 0 ) ;
+    boost::call_once( startOnce, &start ) ;
+
+    mark = nextBlock.load() + ReservedIds ;
+    if( !save( mark ) )
+    {
+      throw ConfigError( "Cannot write " + fileName + " : " + strerror( errno ) ) ;
+    }
+    reserved.store( mark ) ;
   }
 
-  std::string UniqueOrderId::makeString()
+  std::string UniqueOrderId::toString( OrderId orderId )
   {
-    std::stringstream ss;
-    ss << std::setw(10)
-       << std::setfill('0')
-       << _orderId;
-    return ss.str();
+    if( orderId == 0 )
+    {
+      return "NONE" ;
+    }
+    char buffer[ std::numeric_limits< OrderId >::digits10 + 3 ] ;
+    const char *start = UnsignedIntConvertor::integer_to_string< OrderId >(
+        buffer, sizeof( buffer ), orderId ) ;
+    return std::string( start, buffer + sizeof( buffer ) - 1 - start ) ;
+  }
+
+  OrderId UniqueOrderId::fromString( const std::string &orderId )
+  {
+    uint64_t result = 0 ;
+    if( !UnsignedIntConvertor::convert( orderId, result ) )
+    {
+      return 0 ;
+    }
+    return result ;
   }
 }
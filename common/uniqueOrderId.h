@@ -1,29 +1,54 @@
 #ifndef UNIQUE_ORDER_ID_H
 #define UNIQUE_ORDER_ID_H
 
-#include <boost/date_time/posix_time/posix_time.hpp>
+#include <stdint.h>
+#include <string>
 
 namespace UT {
 
+  /**
+   * The id the engine gives an order. 0 is no order.
+   */
+  typedef uint64_t OrderId ;
 
 /**
  *
  * \class UniqueOrderId
  *
- * Generates a sequential unique ID (number)
+ * Generates unique order ids, numbers, from any thread without a lock.
+ *
+ * Every thread takes a block of BlockSize ids at a time from a shared
+ * counter and hands them out in turn, so ids grow within a thread but not
+ * across threads.
+ *
+ * With load(), the highest id that may have been handed out is kept in a
+ * file, ReservedIds ahead of time, and the ids carry on from there after a
+ * restart. Without it they start from the time in microseconds.
  *
  */
   class UniqueOrderId
   {
   public:
-    static std::string get();
+    static const OrderId BlockSize = 4096 ;
+    static const OrderId ReservedIds = BlockSize * 1024 ;
+
+    static OrderId get();
+
+    /**
+     * @brief Carry on from the ids saved in a file, created if missing,
+     * and save them there from now on. Call before the first get().
+     */
+    static void load( const std::string &fileName ) ;
 
-    static void set(long orderId)
-      { _orderId = orderId; }
+    /**
+     * @brief The id as sent to clients, NONE for no order.
+     */
+    static std::string toString( OrderId orderId ) ;
 
-  private:
-    static std::string makeString();
-    static long        _orderId;
+    /**
+     * @brief The id sent by a client, 0 if it is not one of ours.
+     */
+    static OrderId fromString( const std::string &orderId ) ;
   };
 }
 
@@ -0,0 +1,676 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+/**
+ * Generate flyweight codecs for binary wire messages from a schema, see
+ * configs/marketDataWire.xml. A codec wraps a buffer and reads or writes
+ * each field in place, in the byte order of the schema, with UT::WireOrder.
+ * Composites and messages also get an encode() from any struct with the
+ * same getters, e.g. those made by the UT_CREATE_ macros.
+ *
+ *   umatch_wiregen schema.xml header.h
+ */
+namespace
+{
+  struct Field
+  {
+    std::string name ;
+    std::string type ;      // C++ type, or composite of an array or group
+    size_t size ;           // of one element
+    size_t offset ;
+    int sinceVersion ;
+    size_t length ;         // elements of an array, 0 for a plain field
+  };
+
+  struct Composite
+  {
+    std::string name ;
+    std::vector< Field > fields ;
+    size_t size ;
+    bool versioned ;
+  };
+
+  struct Group
+  {
+    std::string name ;
+    std::string type ;
+    std::string countField ;
+    int max ;
+  };
+
+  struct Message
+  {
+    std::string name ;
+    int id ;
+    std::vector< Field > fields ;
+    size_t blockLength ;
+    std::string lengthField ;
+    std::string typeField ;
+    std::string versionField ;
+    std::vector< Group > groups ;
+  };
+
+  struct Schema
+  {
+    std::vector< std::string > namespaces ;
+    int version ;
+    bool littleEndian ;
+    std::vector< Composite > composites ;
+    std::vector< Message > messages ;
+  };
+
+  std::string getProperty( xmlNode *node, const char *name )
+  {
+    xmlChar *property = xmlGetProp( node, reinterpret_cast< const xmlChar * >( name ) ) ;
+    if( property == 0 )
+    {
+      return "" ;
+    }
+    std::string value( reinterpret_cast< const char * >( property ) ) ;
+    xmlFree( property ) ;
+    return value ;
+  }
+
+  std::string getRequired( xmlNode *node, const char *name )
+  {
+    std::string value = getProperty( node, name ) ;
+    if( value.empty() )
+    {
+      throw std::runtime_error( std::string( "<" )
+          + reinterpret_cast< const char * >( node->name )
+          + "> without " + name ) ;
+    }
+    return value ;
+  }
+
+  bool isElement( xmlNode *node, const char *name )
+  {
+    return node->type == XML_ELEMENT_NODE
+      && xmlStrcmp( node->name, reinterpret_cast< const xmlChar * >( name ) ) == 0 ;
+  }
+
+  /**
+   * The C++ type & size of a primitive type, false if it is not one.
+   */
+  bool getPrimitive( const std::string &type, std::string &cppType, size_t &size )
+  {
+    static const char *names[] = { "char", "int8", "uint8", "int16", "uint16",
+                                   "int32", "uint32", "int64", "uint64" } ;
+    static const char *cppTypes[] = { "char", "int8_t", "uint8_t", "int16_t", "uint16_t",
+                                      "int32_t", "uint32_t", "int64_t", "uint64_t" } ;
+    static const size_t sizes[] = { 1, 1, 1, 2, 2, 4, 4, 8, 8 } ;
+
+    for( size_t i = 0 ; i < sizeof( names ) / sizeof( names[ 0 ] ) ; ++i )
+    {
+      if( type == names[ i ] )
+      {
+        cppType = cppTypes[ i ] ;
+        size = sizes[ i ] ;
+        return true ;
+      }
+    }
+    return false ;
+  }
+
+  const Composite &findComposite( const Schema &schema, const std::string &name )
+  {
+    for( size_t i = 0 ; i < schema.composites.size() ; ++i )
+    {
+      if( schema.composites[ i ].name == name )
+      {
+        return schema.composites[ i ] ;
+      }
+    }
+    throw std::runtime_error( "Unknown composite " + name ) ;
+  }
+
+  /**
+   * The fields & arrays of a composite or of the block of a message, laid
+   * out one after the other without padding.
+   */
+  size_t readFields( xmlNode *parent,
+                     const Schema &schema,
+                     const std::string &owner,
+                     std::vector< Field > &fields )
+  {
+    size_t offset = 0 ;
+    int lastVersion = 1 ;
+    for( xmlNode *node = parent->children ; node != 0 ; node = node->next )
+    {
+      Field field ;
+      field.offset = offset ;
+      field.sinceVersion = 1 ;
+      field.length = 0 ;
+
+      if( isElement( node, "field" ) )
+      {
+        field.name = getRequired( node, "name" ) ;
+        std::string type = getRequired( node, "type" ) ;
+        if( !getPrimitive( type, field.type, field.size ) )
+        {
+          throw std::runtime_error( owner + "." + field.name
+              + " has an unknown type " + type ) ;
+        }
+        std::string since = getProperty( node, "sinceVersion" ) ;
+        if( !since.empty() )
+        {
+          field.sinceVersion = atoi( since.c_str() ) ;
+        }
+      }
+      else if( isElement( node, "array" ) )
+      {
+        field.name = getRequired( node, "name" ) ;
+        const Composite &composite = findComposite( schema, getRequired( node, "type" ) ) ;
+        if( composite.versioned )
+        {
+          throw std::runtime_error( owner + "." + field.name
+              + " repeats " + composite.name + ", which has versioned fields" ) ;
+        }
+        field.type = composite.name ;
+        field.size = composite.size ;
+        field.length = atoi( getRequired( node, "length" ).c_str() ) ;
+      }
+      else
+      {
+        continue ;
+      }
+
+      if( field.sinceVersion < lastVersion )
+      {
+        throw std::runtime_error( owner + "." + field.name
+            + " comes after fields of a later version" ) ;
+      }
+      lastVersion = field.sinceVersion ;
+      offset += field.size * ( field.length ? field.length : 1 ) ;
+      fields.push_back( field ) ;
+    }
+    return offset ;
+  }
+
+  void readSchema( xmlNode *root, Schema &schema )
+  {
+    std::string name = getRequired( root, "namespace" ) ;
+    for( size_t begin = 0 ; begin < name.size() ; )
+    {
+      size_t end = name.find( "::", begin ) ;
+      if( end == std::string::npos )
+      {
+        end = name.size() ;
+      }
+      schema.namespaces.push_back( name.substr( begin, end - begin ) ) ;
+      begin = end + 2 ;
+    }
+    schema.version = atoi( getRequired( root, "version" ).c_str() ) ;
+    schema.littleEndian = getRequired( root, "byteOrder" ) == "littleEndian" ;
+
+    for( xmlNode *node = root->children ; node != 0 ; node = node->next )
+    {
+      if( isElement( node, "composite" ) )
+      {
+        Composite composite ;
+        composite.name = getRequired( node, "name" ) ;
+        composite.size = readFields( node, schema, composite.name, composite.fields ) ;
+        composite.versioned = !composite.fields.empty()
+          && composite.fields.back().sinceVersion > 1 ;
+        schema.composites.push_back( composite ) ;
+      }
+      else if( isElement( node, "message" ) )
+      {
+        Message message ;
+        message.name = getRequired( node, "name" ) ;
+        message.id = atoi( getRequired( node, "id" ).c_str() ) ;
+        message.lengthField = getRequired( node, "lengthField" ) ;
+        message.typeField = getRequired( node, "typeField" ) ;
+        message.versionField = getRequired( node, "versionField" ) ;
+        message.blockLength = readFields( node, schema, message.name, message.fields ) ;
+
+        for( size_t i = 0 ; i < message.fields.size() ; ++i )
+        {
+          if( message.fields[ i ].sinceVersion > 1 )
+          {
+            throw std::runtime_error( message.name + "." + message.fields[ i ].name
+                + " is versioned, only fields repeated by a group can be" ) ;
+          }
+        }
+
+        for( xmlNode *child = node->children ; child != 0 ; child = child->next )
+        {
+          if( isElement( child, "group" ) )
+          {
+            Group group ;
+            group.name = getRequired( child, "name" ) ;
+            group.type = findComposite( schema, getRequired( child, "type" ) ).name ;
+            group.countField = getRequired( child, "countField" ) ;
+            group.max = atoi( getRequired( child, "max" ).c_str() ) ;
+            message.groups.push_back( group ) ;
+          }
+        }
+        if( message.groups.size() > 1 )
+        {
+          throw std::runtime_error( message.name + " has more than one group" ) ;
+        }
+        schema.messages.push_back( message ) ;
+      }
+    }
+  }
+
+  void writeAccessors( std::ostream &out,
+                       const std::string &className,
+                       const std::vector< Field > &fields,
+                       const std::string &base )
+  {
+    for( size_t i = 0 ; i < fields.size() ; ++i )
+    {
+      const Field &field = fields[ i ] ;
+      std::ostringstream at ;
+      at << base << " + " << field.offset ;
+
+      if( field.length > 0 )
+      {
+        out << "      " << field.type << " get" << field.name << "At( int position ) const\n"
+            << "      {\n"
+            << "        return " << field.type << "( " << at.str()
+            << " + position * " << field.type << "::Size, _version ) ;\n"
+            << "      }\n\n" ;
+        continue ;
+      }
+
+      out << "      " << field.type << " get" << field.name << "() const\n"
+          << "      {\n" ;
+      if( field.sinceVersion > 1 )
+      {
+        out << "        if( _version < " << field.sinceVersion << " )\n"
+            << "        {\n"
+            << "          return 0 ;\n"
+            << "        }\n" ;
+      }
+      out << "        return Order::get< " << field.type << " >( " << at.str() << " ) ;\n"
+          << "      }\n\n"
+          << "      " << className << " &set" << field.name << "( " << field.type << " value )\n"
+          << "      {\n"
+          << "        Order::put< " << field.type << " >( " << at.str() << ", value ) ;\n"
+          << "        return *this ;\n"
+          << "      }\n\n" ;
+    }
+  }
+
+  /**
+   * Copy the fields from a struct with the same getters, leaving out those
+   * the codec keeps itself.
+   */
+  void writeEncode( std::ostream &out,
+                    const std::string &className,
+                    const std::vector< Field > &fields,
+                    const std::vector< std::string > &skipped )
+  {
+    out << "      template< class Source >\n"
+        << "      " << className << " &encode( const Source &source )\n"
+        << "      {\n" ;
+    for( size_t i = 0 ; i < fields.size() ; ++i )
+    {
+      const Field &field = fields[ i ] ;
+      if( std::find( skipped.begin(), skipped.end(), field.name ) != skipped.end() )
+      {
+        continue ;
+      }
+      if( field.length > 0 )
+      {
+        out << "        for( int i = 0 ; i < " << field.name << "Length ; ++i )\n"
+            << "        {\n"
+            << "          get" << field.name << "At( i ).encode( source.get"
+            << field.name << "At( i ) ) ;\n"
+            << "        }\n" ;
+      }
+      else
+      {
+        out << "        set" << field.name << "( source.get" << field.name << "() ) ;\n" ;
+      }
+    }
+  }
+
+  void writeComposite( std::ostream &out, const Composite &composite )
+  {
+    const std::string &name = composite.name ;
+    out << "  /**\n"
+        << "   * \\class " << name << "\n"
+        << "   *\n"
+        << "   * " << composite.size << " bytes in the current version.\n"
+        << "   *\n"
+        << "   */\n"
+        << "  class " << name << "\n"
+        << "  {\n"
+        << "    public :\n"
+        << "      enum { Size = " << composite.size ;
+    for( size_t i = 0 ; i < composite.fields.size() ; ++i )
+    {
+      if( composite.fields[ i ].length > 0 )
+      {
+        out << ", " << composite.fields[ i ].name << "Length = "
+            << composite.fields[ i ].length ;
+      }
+    }
+    out << " } ;\n\n"
+        << "      " << name << "() : _buffer( 0 ), _version( SchemaVersion ) {}\n\n"
+        << "      " << name << "( char *buffer, int version )\n"
+        << "        : _buffer( buffer ), _version( version )\n"
+        << "      {}\n\n"
+        << "      /**\n"
+        << "       * @brief The size encoded by a version of the schema.\n"
+        << "       */\n"
+        << "      static size_t getSize( int version )\n"
+        << "      {\n" ;
+    for( size_t i = composite.fields.size() ; i > 0 ; --i )
+    {
+      const Field &field = composite.fields[ i - 1 ] ;
+      if( field.sinceVersion > 1
+          && ( i == composite.fields.size()
+               || composite.fields[ i ].sinceVersion != field.sinceVersion ) )
+      {
+        out << "        if( version >= " << field.sinceVersion << " )\n"
+            << "        {\n"
+            << "          return " << field.offset + field.size << " ;\n"
+            << "        }\n" ;
+      }
+    }
+    size_t baseSize = composite.size ;
+    for( size_t i = 0 ; i < composite.fields.size() ; ++i )
+    {
+      if( composite.fields[ i ].sinceVersion > 1 )
+      {
+        baseSize = composite.fields[ i ].offset ;
+        break ;
+      }
+    }
+    out << "        return " << baseSize << " ;\n"
+        << "      }\n\n" ;
+
+    writeAccessors( out, name, composite.fields, "_buffer" ) ;
+    writeEncode( out, name, composite.fields, std::vector< std::string >() ) ;
+    out << "        return *this ;\n"
+        << "      }\n\n"
+        << "    private :\n"
+        << "      char *_buffer ;\n"
+        << "      int _version ;\n"
+        << "  };\n\n" ;
+  }
+
+  /**
+   * The member holding something about a field, _record for Record.
+   */
+  std::string getMember( const std::string &name )
+  {
+    return "_" + std::string( 1, static_cast< char >( tolower( name[ 0 ] ) ) )
+      + name.substr( 1 ) ;
+  }
+
+  const Field &findField( const Message &message, const std::string &name )
+  {
+    for( size_t i = 0 ; i < message.fields.size() ; ++i )
+    {
+      if( message.fields[ i ].name == name )
+      {
+        return message.fields[ i ] ;
+      }
+    }
+    throw std::runtime_error( message.name + " has no field " + name ) ;
+  }
+
+  void writeMessage( std::ostream &out, const Message &message )
+  {
+    const std::string &name = message.name ;
+    const Field &length = findField( message, message.lengthField ) ;
+    findField( message, message.typeField ) ;
+    findField( message, message.versionField ) ;
+    size_t lengthEnd = length.offset + length.size ;
+
+    std::vector< std::string > skipped ;
+    skipped.push_back( message.lengthField ) ;
+    skipped.push_back( message.typeField ) ;
+    skipped.push_back( message.versionField ) ;
+
+    const Group *group = message.groups.empty() ? 0 : &message.groups[ 0 ] ;
+    if( group != 0 )
+    {
+      findField( message, group->countField ) ;
+      skipped.push_back( group->countField ) ;
+    }
+
+    out << "  /**\n"
+        << "   * \\class " << name << "\n"
+        << "   *\n"
+        << "   * Message " << message.id << ". Encode into a buffer of MaxLength bytes\n"
+        << "   * with wrapForEncode(), the fields & " << ( group ? group->name + "s" : "" ) << " after it,\n"
+        << "   * then send getEncodedLength() bytes. Decode with wrapForDecode().\n"
+        << "   *\n"
+        << "   */\n"
+        << "  class " << name << "\n"
+        << "  {\n"
+        << "    public :\n"
+        << "      enum { TemplateId = " << message.id
+        << ", BlockLength = " << message.blockLength ;
+    if( group != 0 )
+    {
+      out << ",\n             Max" << group->countField << " = " << group->max
+          << ",\n             MaxLength = BlockLength + Max" << group->countField
+          << " * " << group->type << "::Size } ;\n\n" ;
+    }
+    else
+    {
+      out << ", MaxLength = BlockLength } ;\n\n" ;
+    }
+
+    out << "      " << name << "()\n"
+        << "        : _buffer( 0 ), _version( SchemaVersion )" ;
+    if( group != 0 )
+    {
+      out << ", " << getMember( group->name ) << "Length( " << group->type << "::Size )" ;
+    }
+    out << "\n      {}\n\n"
+        << "      /**\n"
+        << "       * @brief Start a message with no " << ( group ? group->name + "s" : "fields" )
+        << " in a buffer of MaxLength bytes.\n"
+        << "       */\n"
+        << "      " << name << " &wrapForEncode( char *buffer )\n"
+        << "      {\n"
+        << "        _buffer = buffer ;\n"
+        << "        _version = SchemaVersion ;\n" ;
+    if( group != 0 )
+    {
+      out << "        " << getMember( group->name ) << "Length = " << group->type << "::Size ;\n" ;
+    }
+    out << "        memset( _buffer, 0, BlockLength ) ;\n"
+        << "        set" << message.typeField << "( TemplateId ) ;\n"
+        << "        set" << message.versionField << "( SchemaVersion ) ;\n"
+        << "        set" << message.lengthField << "( BlockLength - " << lengthEnd << " ) ;\n"
+        << "        return *this ;\n"
+        << "      }\n\n"
+        << "      /**\n"
+        << "       * @brief Read a message as received. The buffer is not written to.\n"
+        << "       *\n"
+        << "       * @return False if it is not a " << name << " or is cut short.\n"
+        << "       */\n"
+        << "      bool wrapForDecode( const char *buffer, size_t length )\n"
+        << "      {\n"
+        << "        _buffer = const_cast< char * >( buffer ) ;\n"
+        << "        if( length < BlockLength || get" << message.typeField << "() != TemplateId )\n"
+        << "        {\n"
+        << "          return false ;\n"
+        << "        }\n"
+        << "        _version = get" << message.versionField << "() ;\n"
+        << "        size_t encoded = getEncodedLength() ;\n"
+        << "        if( encoded < BlockLength || encoded > length )\n"
+        << "        {\n"
+        << "          return false ;\n"
+        << "        }\n" ;
+    if( group != 0 )
+    {
+      out << "        // Senders of another version repeat " << group->type
+          << "s of another length.\n"
+          << "        long count = get" << group->countField << "() ;\n"
+          << "        if( count <= 0 )\n"
+          << "        {\n"
+          << "          return count == 0 ;\n"
+          << "        }\n"
+          << "        " << getMember( group->name ) << "Length = ( encoded - BlockLength ) / count ;\n"
+          << "        return " << getMember( group->name ) << "Length >= "
+          << group->type << "::getSize( std::min< int >( _version, SchemaVersion ) ) ;\n" ;
+    }
+    else
+    {
+      out << "        return true ;\n" ;
+    }
+    out << "      }\n\n"
+        << "      size_t getEncodedLength() const\n"
+        << "      {\n"
+        << "        return get" << message.lengthField << "() + " << lengthEnd << " ;\n"
+        << "      }\n\n"
+        << "      int getVersion() const { return _version ; }\n\n" ;
+
+    if( group != 0 )
+    {
+      out << "      " << group->type << " get" << group->name << "At( int position ) const\n"
+          << "      {\n"
+          << "        return " << group->type << "( _buffer + BlockLength + position * "
+          << getMember( group->name ) << "Length, _version ) ;\n"
+          << "      }\n\n"
+          << "      /**\n"
+          << "       * @brief Append a " << group->name << ", up to Max" << group->countField << ".\n"
+          << "       */\n"
+          << "      " << group->type << " add" << group->name << "()\n"
+          << "      {\n"
+          << "        int position = get" << group->countField << "() ;\n"
+          << "        set" << group->countField << "( position + 1 ) ;\n"
+          << "        set" << message.lengthField << "( get" << message.lengthField
+          << "() + " << group->type << "::Size ) ;\n"
+          << "        return get" << group->name << "At( position ) ;\n"
+          << "      }\n\n" ;
+    }
+
+    writeAccessors( out, name, message.fields, "_buffer" ) ;
+    writeEncode( out, name, message.fields, skipped ) ;
+    if( group != 0 )
+    {
+      out << "        for( int i = 0 ; i < source.get" << group->countField << "() ; ++i )\n"
+          << "        {\n"
+          << "          add" << group->name << "().encode( source.get"
+          << group->name << "At( i ) ) ;\n"
+          << "        }\n" ;
+    }
+    out << "        return *this ;\n"
+        << "      }\n\n"
+        << "    private :\n"
+        << "      char *_buffer ;\n"
+        << "      int _version ;\n" ;
+    if( group != 0 )
+    {
+      out << "      size_t " << getMember( group->name ) << "Length ;\n" ;
+    }
+    out << "  };\n\n" ;
+  }
+
+  void write( std::ostream &out,
+              const std::string &schemaFile,
+              const std::string &guard,
+              const Schema &schema )
+  {
+    out << "// Generated by umatch_wiregen from " << schemaFile << ", do not edit.\n"
+        << "#ifndef " << guard << "\n"
+        << "#define " << guard << "\n\n"
+        << "#include <stdint.h>\n"
+        << "#include <string.h>\n"
+        << "#include <algorithm>\n\n"
+        << "#include \"wireOrder.h\"\n\n" ;
+    for( size_t i = 0 ; i < schema.namespaces.size() ; ++i )
+    {
+      out << "namespace " << schema.namespaces[ i ] << " {\n" ;
+    }
+    out << "\n"
+        << "  const int SchemaVersion = " << schema.version << " ;\n"
+        << "  typedef UT::" << ( schema.littleEndian ? "LittleEndian" : "BigEndian" )
+        << " Order ;\n\n" ;
+
+    for( size_t i = 0 ; i < schema.composites.size() ; ++i )
+    {
+      writeComposite( out, schema.composites[ i ] ) ;
+    }
+    for( size_t i = 0 ; i < schema.messages.size() ; ++i )
+    {
+      writeMessage( out, schema.messages[ i ] ) ;
+    }
+
+    for( size_t i = schema.namespaces.size() ; i > 0 ; --i )
+    {
+      out << "}\n" ;
+    }
+    out << "\n#endif // " << guard << "\n" ;
+  }
+
+  /**
+   * The include guard of a header, from its file name.
+   */
+  std::string getGuard( const std::string &header )
+  {
+    std::string name = header.substr( header.find_last_of( '/' ) + 1 ) ;
+    std::string guard( "UT_WIRE_" ) ;
+    for( std::string::const_iterator c = name.begin() ; c != name.end() ; ++c )
+    {
+      guard += isalnum( *c ) ? static_cast< char >( toupper( *c ) ) : '_' ;
+    }
+    return guard ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  if( argc != 3 )
+  {
+    std::cout << "Usage : umatch_wiregen schema header" << std::endl ;
+    return 1 ;
+  }
+
+  xmlDoc *document = xmlReadFile( argv[ 1 ], 0, 0 ) ;
+  if( document == 0 )
+  {
+    std::cerr << "Cannot parse " << argv[ 1 ] << std::endl ;
+    return 1 ;
+  }
+
+  Schema schema ;
+  try
+  {
+    xmlNode *root = xmlDocGetRootElement( document ) ;
+    if( root == 0 || !isElement( root, "schema" ) )
+    {
+      throw std::runtime_error( "no <schema>" ) ;
+    }
+    readSchema( root, schema ) ;
+  }
+  catch( std::exception &e )
+  {
+    std::cerr << argv[ 1 ] << " : " << e.what() << std::endl ;
+    xmlFreeDoc( document ) ;
+    return 1 ;
+  }
+  xmlFreeDoc( document ) ;
+  xmlCleanupParser() ;
+
+  std::ofstream header( argv[ 2 ] ) ;
+  write( header, argv[ 1 ], getGuard( argv[ 2 ] ), schema ) ;
+  if( !header )
+  {
+    std::cerr << "Cannot write " << argv[ 2 ] << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
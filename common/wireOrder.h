@@ -0,0 +1,95 @@
+#ifndef UT_WIRE_ORDER_H
+#define UT_WIRE_ORDER_H
+
+#include <stdint.h>
+#include <string.h>
+
+namespace UT
+{
+  /**
+   * Reading and writing the fields of a binary wire message in place, in
+   * the byte order of its schema. Whether the host has to swap is known at
+   * compile time, so a field in the host's order costs a plain load or
+   * store. Fields need not be aligned.
+   */
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  const bool HostIsLittleEndian = false ;
+#else
+  const bool HostIsLittleEndian = true ;
+#endif
+
+  template< size_t Size >
+  struct ByteSwap ;
+
+  template<>
+  struct ByteSwap< 1 >
+  {
+    static uint8_t swap( uint8_t value ) { return value ; }
+  };
+
+  template<>
+  struct ByteSwap< 2 >
+  {
+    static uint16_t swap( uint16_t value )
+    {
+      return static_cast< uint16_t >( ( value << 8 ) | ( value >> 8 ) ) ;
+    }
+  };
+
+  template<>
+  struct ByteSwap< 4 >
+  {
+    static uint32_t swap( uint32_t value ) { return __builtin_bswap32( value ) ; }
+  };
+
+  template<>
+  struct ByteSwap< 8 >
+  {
+    static uint64_t swap( uint64_t value ) { return __builtin_bswap64( value ) ; }
+  };
+
+  /**
+   * \class WireOrder
+   *
+   * The fields of a schema in one byte order, little endian or not.
+   *
+   */
+  template< bool LittleEndian >
+  struct WireOrder
+  {
+    template< class T >
+    static T get( const char *field )
+    {
+      T value ;
+      memcpy( &value, field, sizeof( T ) ) ;
+      if( LittleEndian != HostIsLittleEndian )
+      {
+        value = swap( value ) ;
+      }
+      return value ;
+    }
+
+    template< class T >
+    static void put( char *field, T value )
+    {
+      if( LittleEndian != HostIsLittleEndian )
+      {
+        value = swap( value ) ;
+      }
+      memcpy( field, &value, sizeof( T ) ) ;
+    }
+
+    private :
+      template< class T >
+      static T swap( T value )
+      {
+        typedef ByteSwap< sizeof( T ) > Swap ;
+        return static_cast< T >( Swap::swap( value ) ) ;
+      }
+  };
+
+  typedef WireOrder< true > LittleEndian ;
+  typedef WireOrder< false > BigEndian ;
+}
+
+#endif // UT_WIRE_ORDER_H
@@ -0,0 +1,12 @@
+#ifndef UMATCH_CONFIG_H
+#define UMATCH_CONFIG_H
+
+#define VERSION_MAJOR 1
+#define VERSION_MINOR 0
+#define VERSION_PATCH 0
+
+#define REVISION_NUMBER "49f4ff3"
+
+#define VERSION_STRING "1.0.0 (Build 49f4ff3)"
+
+#endif
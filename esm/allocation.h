@@ -0,0 +1,159 @@
+#ifndef ESM_ALLOCATION_H
+#define ESM_ALLOCATION_H
+
+#include "orderList.h"
+
+namespace ESM
+{
+  /**
+   * Allocation policies: how an incoming quantity is shared between the
+   * orders of the best level of an order list.
+   *
+   * A policy is a struct with a static fill() taking:
+   * * the list the resting orders are in
+   * * the quantity to fill, at most the incoming order's pending quantity
+   * * the allocation settings of the instrument
+   * * a handler called with every resting order filled and the quantity
+   *
+   * fill() works on the best level only and may fill less than asked; the
+   * order book calls it again while the orders still cross. Filled orders
+   * are erased from the list before the handler is called.
+   *
+   * The order book instantiates its matching loop once per policy, so a
+   * FIFO book runs the same loop as before policies existed.
+   */
+
+  /**
+   * Price & time priority: the first order of the level trades.
+   */
+  struct FifoAllocation
+  {
+    template< class List, class Handler >
+    static void fill( List &list,
+                      long qty,
+                      const Allocation &,
+                      Handler &handler )
+    {
+      OrderPtr order = list.first() ;
+      long fillQty = order->getPendingQty() < qty ? order->getPendingQty() : qty ;
+      list.fill( order->getPrice(), fillQty ) ;
+      handler( order, fillQty ) ;
+    }
+
+    /**
+     * @brief Fill by time priority what is left of a quantity, staying on
+     * one level.
+     *
+     * @return The quantity not filled because the level is used up.
+     */
+    template< class List, class Handler >
+    static long fillLevel( List &list,
+                           long level,
+                           long qty,
+                           Handler &handler )
+    {
+      while( qty > 0 && list.isBest( level ) )
+      {
+        OrderPtr order = list.first() ;
+        long fillQty = order->getPendingQty() < qty ? order->getPendingQty() : qty ;
+        list.fill( order->getPrice(), fillQty ) ;
+        handler( order, fillQty ) ;
+        qty -= fillQty ;
+      }
+      return qty ;
+    }
+  };
+
+  /**
+   * Pro-rata: every order of the level gets a share of the fill in
+   * proportion to its pending quantity, rounded down. Shares under the
+   * minimum are not given. What the rounding & the minimum leave goes by
+   * time priority.
+   */
+  struct ProRataAllocation
+  {
+    template< class List, class Handler >
+    static void fill( List &list,
+                      long qty,
+                      const Allocation &allocation,
+                      Handler &handler )
+    {
+      typename List::iterator iOrder = list.levelBegin() ;
+      long level = iOrder->first ;
+      long levelQty = list.getLevelQty( level ) ;
+
+      // The level total is kept by the list, so the shares are found in
+      // the same pass that fills them.
+      if( qty < levelQty )
+      {
+        const long totalQty = qty ;
+        typename List::iterator iEnd = list.levelEnd( iOrder ) ;
+        while( iOrder != iEnd )
+        {
+          OrderPtr order = iOrder->second ;
+          long share = order->getPendingQty() * totalQty / levelQty ;
+          if( share == 0 || share < allocation.minQty )
+          {
+            ++iOrder ;
+            continue ;
+          }
+          iOrder = list.fill( iOrder, order->getPrice(), share ) ;
+          handler( order, share ) ;
+          qty -= share ;
+        }
+      }
+
+      FifoAllocation::fillLevel( list, level, qty, handler ) ;
+    }
+  };
+
+  /**
+   * Time priority with a lead market maker: the first order of the level
+   * fills first, then the market maker's orders get their share of what
+   * is left, then the rest goes by time priority.
+   */
+  struct LmmAllocation
+  {
+    template< class List, class Handler >
+    static void fill( List &list,
+                      long qty,
+                      const Allocation &allocation,
+                      Handler &handler )
+    {
+      typename List::iterator iOrder = list.levelBegin() ;
+      long level = iOrder->first ;
+
+      OrderPtr top = iOrder->second ;
+      long topQty = top->getPendingQty() < qty ? top->getPendingQty() : qty ;
+      iOrder = list.fill( iOrder, top->getPrice(), topQty ) ;
+      handler( top, topQty ) ;
+      qty -= topQty ;
+
+      long lmmQty = static_cast< long >( qty * allocation.lmmShare ) ;
+      if( lmmQty > 0 && list.isBest( level ) )
+      {
+        typename List::iterator iEnd = list.levelEnd( list.levelBegin() ) ;
+        iOrder = list.levelBegin() ;
+        while( lmmQty > 0 && iOrder != iEnd )
+        {
+          OrderPtr order = iOrder->second ;
+          if( order->getSenderId() != allocation.lmmSenderId )
+          {
+            ++iOrder ;
+            continue ;
+          }
+          long fillQty = order->getPendingQty() < lmmQty
+                         ? order->getPendingQty() : lmmQty ;
+          iOrder = list.fill( iOrder, order->getPrice(), fillQty ) ;
+          handler( order, fillQty ) ;
+          lmmQty -= fillQty ;
+          qty -= fillQty ;
+        }
+      }
+
+      FifoAllocation::fillLevel( list, level, qty, handler ) ;
+    }
+  };
+}
+
+#endif // ESM_ALLOCATION_H
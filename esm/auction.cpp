@@ -0,0 +1,94 @@
+#include "auction.h"
+
+namespace ESM
+{
+  void Auction::reset( long lowTick, long highTick )
+  {
+    std::size_t ticks = static_cast< std::size_t >( highTick - lowTick + 1 ) ;
+    _lowTick = lowTick ;
+    _buys.assign( ticks, 0 ) ;
+    _sells.assign( ticks, 0 ) ;
+    _volumes.resize( ticks ) ;
+    _imbalances.resize( ticks ) ;
+  }
+
+  AuctionResult Auction::uncross( long referenceTick )
+  {
+    AuctionResult result ;
+    const long n = size() ;
+    if( n == 0 )
+    {
+      return result ;
+    }
+
+    long *buys = &_buys[0] ;
+    long *sells = &_sells[0] ;
+    long *volumes = &_volumes[0] ;
+    long *imbalances = &_imbalances[0] ;
+
+    // A buy at a tick also buys at every lower tick, a sell at a tick also
+    // sells at every higher one.
+    for( long i = n - 2 ; i >= 0 ; --i )
+    {
+      buys[i] += buys[i + 1] ;
+    }
+    for( long i = 1 ; i < n ; ++i )
+    {
+      sells[i] += sells[i - 1] ;
+    }
+
+    long maxVolume = 0 ;
+    for( long i = 0 ; i < n ; ++i )
+    {
+      volumes[i] = buys[i] < sells[i] ? buys[i] : sells[i] ;
+      imbalances[i] = buys[i] - sells[i] ;
+      maxVolume = volumes[i] > maxVolume ? volumes[i] : maxVolume ;
+    }
+
+    if( maxVolume == 0 )
+    {
+      return result ;
+    }
+
+    // Only the ticks at the maximum volume are left to compare.
+    long best = -1 ;
+    for( long i = 0 ; i < n ; ++i )
+    {
+      if( volumes[i] != maxVolume )
+      {
+        continue ;
+      }
+      if( best < 0 )
+      {
+        best = i ;
+        continue ;
+      }
+
+      long imbalance = imbalances[i] < 0 ? -imbalances[i] : imbalances[i] ;
+      long bestImbalance = imbalances[best] < 0 ? -imbalances[best]
+                                                : imbalances[best] ;
+      if( imbalance != bestImbalance )
+      {
+        if( imbalance < bestImbalance )
+        {
+          best = i ;
+        }
+        continue ;
+      }
+
+      long distance = _lowTick + i - referenceTick ;
+      long bestDistance = _lowTick + best - referenceTick ;
+      distance = distance < 0 ? -distance : distance ;
+      bestDistance = bestDistance < 0 ? -bestDistance : bestDistance ;
+      if( distance < bestDistance )
+      {
+        best = i ;
+      }
+    }
+
+    result.tick = _lowTick + best ;
+    result.volume = maxVolume ;
+    result.imbalance = imbalances[best] ;
+    return result ;
+  }
+}
@@ -0,0 +1,106 @@
+#ifndef ESM_AUCTION_H
+#define ESM_AUCTION_H
+
+#include <vector>
+
+namespace ESM
+{
+  /**
+   * The outcome of an uncross: the equilibrium tick, the quantity that
+   * trades at it and what is left over.
+   */
+  struct AuctionResult
+  {
+    AuctionResult() : tick( 0 ), volume( 0 ), imbalance( 0 ) {}
+
+    long tick ;
+
+    /**
+     * Quantity executed at the tick, 0 if the book does not cross.
+     */
+    long volume ;
+
+    /**
+     * Buy quantity - sell quantity willing to trade at the tick. Positive
+     * when buys are left over.
+     */
+    long imbalance ;
+  };
+
+  /**
+   * \class Auction
+   *
+   * The buy & sell curves of a call auction over a range of ticks, and the
+   * uncross that picks the equilibrium tick.
+   *
+   * Only the ticks between the best sell and the best buy can trade, so the
+   * curves cover that range alone, one slot per tick. The uncross is then a
+   * few passes over flat arrays with no branch in the loop bodies, which
+   * the compiler vectorizes:
+   * * cumulative buy quantity at or above each tick (suffix sum)
+   * * cumulative sell quantity at or below each tick (prefix sum)
+   * * executable volume min( buys, sells ) and imbalance buys - sells
+   *
+   * The equilibrium tick has, in order of precedence:
+   * * the largest executable volume
+   * * the smallest absolute imbalance
+   * * the closest distance to the reference tick
+   * * the lowest tick
+   *
+   */
+  class Auction
+  {
+    public :
+      Auction() : _lowTick( 0 ) {}
+
+      /**
+       * @brief Clear the curves and size them for a range of ticks.
+       *
+       * @param The best (lowest) sell tick.
+       * @param The best (highest) buy tick, >= the lowest.
+       */
+      void reset( long lowTick, long highTick ) ;
+
+      /**
+       * @brief Add the quantity of a buy / sell at a tick. Ticks outside
+       * the range cannot trade and are ignored.
+       */
+      void addBuy( long tick, long qty )
+      {
+        if( tick >= _lowTick && tick < _lowTick + size() )
+        {
+          _buys[ tick - _lowTick ] += qty ;
+        }
+      }
+
+      void addSell( long tick, long qty )
+      {
+        if( tick >= _lowTick && tick < _lowTick + size() )
+        {
+          _sells[ tick - _lowTick ] += qty ;
+        }
+      }
+
+      /**
+       * @brief Find the equilibrium tick. The curves are consumed.
+       *
+       * @param The tick to be closest to when volume & imbalance tie,
+       *        usually the last trade.
+       *
+       * @return The equilibrium. Volume 0 if nothing crosses.
+       */
+      AuctionResult uncross( long referenceTick ) ;
+
+    private :
+      long size() const { return static_cast< long >( _buys.size() ) ; }
+
+      long _lowTick ;
+
+      std::vector< long > _buys ;
+      std::vector< long > _sells ;
+      std::vector< long > _volumes ;
+      std::vector< long > _imbalances ;
+  };
+}
+
+#endif // ESM_AUCTION_H
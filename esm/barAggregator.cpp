@@ -0,0 +1,403 @@
+#include "barAggregator.h"
+
+#include <time.h>
+#include <algorithm>
+
+namespace ESM
+{
+  /**
+   * The bars of one instrument at every interval: the one open and a ring
+   * of the last ones closed, allocated with its first trade.
+   */
+  class BarSeries
+  {
+    public :
+      struct IntervalBars
+      {
+        Bars::Record bar ;
+        bool open ;
+        bool listed ;       // in the open series of the interval
+        int32_t openTradeNo ;
+        int32_t closeTradeNo ;
+
+        std::vector< Bars::Record > history ;
+        size_t next ;       // where the next bar closed goes
+        size_t size ;
+      };
+
+      std::vector< IntervalBars > intervals ;
+  };
+
+  namespace
+  {
+    /**
+     * How long after its interval a bar waits for trades still in the
+     * rings, before it is closed.
+     */
+    const int64_t CloseDelay = 100 ;
+
+    int64_t now()
+    {
+      timespec time ;
+      clock_gettime( CLOCK_REALTIME, &time ) ;
+      return time.tv_sec * 1000LL + time.tv_nsec / 1000000 ;
+    }
+
+    /**
+     * Trade numbers wrap, the later one is ahead by less than half.
+     */
+    bool isBefore( int32_t tradeNo, int32_t other )
+    {
+      return static_cast< int32_t >( static_cast< uint32_t >( tradeNo )
+                                     - static_cast< uint32_t >( other ) ) < 0 ;
+    }
+
+    void update( Bars::Record &bar, int64_t price, int64_t qty )
+    {
+      bar.setHighPrice( std::max< int64_t >( bar.getHighPrice(), price ) ) ;
+      bar.setLowPrice( std::min< int64_t >( bar.getLowPrice(), price ) ) ;
+      bar.setNoOfTrades( bar.getNoOfTrades() + 1 ) ;
+      bar.setVolume( bar.getVolume() + qty ) ;
+      bar.setValue( bar.getValue() + qty * price ) ;
+      bar.setWeightedAvgPrice( bar.getValue() / bar.getVolume() ) ;
+    }
+  }
+
+  BarAggregator::BarAggregator()
+    : _started( false ),
+      _history( 0 ),
+      _tradeRing( &BarAggregator::retire ),
+      _retiredDropped( 0 ),
+      _publisher( 0 ),
+      _sequenceNo( 0 )
+  {
+    std::fill( _nextClose, _nextClose + MaxIntervals, 0 ) ;
+  }
+
+  void BarAggregator::start( const std::vector< long > &intervals,
+                             size_t history )
+  {
+    if( _started || intervals.empty() )
+    {
+      return ;
+    }
+
+    _intervals.assign( intervals.begin(),
+                       intervals.begin() + std::min< size_t >( intervals.size(),
+                                                               MaxIntervals ) ) ;
+    _history = std::max< size_t >( history, 1 ) ;
+    _started.store( true, boost::memory_order_release ) ;
+
+    boost::thread aggregatorThread( &BarAggregator::run, this ) ;
+  }
+
+  BarSeries *BarAggregator::getSeries( const std::string &securityId )
+  {
+    if( !_started.load( boost::memory_order_acquire ) )
+    {
+      return 0 ;
+    }
+
+    boost::mutex::scoped_lock lock( _mutexSeries ) ;
+    BarSeries *&series = _series[ securityId ] ;
+    if( series == 0 )
+    {
+      series = new BarSeries() ;
+      series->intervals.resize( _intervals.size() ) ;
+      for( size_t i = 0 ; i < _intervals.size() ; ++i )
+      {
+        BarSeries::IntervalBars &bars = series->intervals[i] ;
+        bars.bar.setScripCodeFromString( securityId ) ;
+        bars.bar.setInterval( _intervals[i] ) ;
+        bars.open = false ;
+        bars.listed = false ;
+        bars.openTradeNo = 0 ;
+        bars.closeTradeNo = 0 ;
+        bars.next = 0 ;
+        bars.size = 0 ;
+      }
+    }
+    return series ;
+  }
+
+  void BarAggregator::addTrade( BarSeries *series,
+                                long price,
+                                long qty,
+                                int32_t tradeNo )
+  {
+    TradeRing &tradeRing = getTradeRing() ;
+    Trade *trade = tradeRing.ring.claim() ;
+    if( trade == 0 )
+    {
+      tradeRing.dropped.fetch_add( 1, boost::memory_order_relaxed ) ;
+      return ;
+    }
+
+    trade->series = series ;
+    trade->time = now() ;
+    trade->price = price ;
+    trade->qty = qty ;
+    trade->tradeNo = tradeNo ;
+    tradeRing.ring.publish() ;
+  }
+
+  void BarAggregator::retire( TradeRing *tradeRing )
+  {
+    tradeRing->retired.store( true, boost::memory_order_release ) ;
+  }
+
+  BarAggregator::TradeRing &BarAggregator::getTradeRing()
+  {
+    TradeRing *tradeRing = _tradeRing.get() ;
+    if( tradeRing == 0 )
+    {
+      tradeRing = new TradeRing() ;
+      tradeRing->ring.init() ;
+      tradeRing->dropped.store( 0, boost::memory_order_relaxed ) ;
+      tradeRing->retired.store( false, boost::memory_order_relaxed ) ;
+      {
+        boost::mutex::scoped_lock lock( _mutexTradeRings ) ;
+        _tradeRings.push_back( tradeRing ) ;
+      }
+      _tradeRing.reset( tradeRing ) ;
+    }
+    return *tradeRing ;
+  }
+
+  bool BarAggregator::getBars( const std::string &securityId,
+                               long interval,
+                               std::vector< Bars::Record > &bars )
+  {
+    size_t i = std::find( _intervals.begin(), _intervals.end(), interval )
+               - _intervals.begin() ;
+    if( i == _intervals.size() )
+    {
+      return false ;
+    }
+
+    boost::mutex::scoped_lock lock( _mutexSeries ) ;
+    SeriesMap::const_iterator iSeries = _series.find( securityId ) ;
+    if( iSeries == _series.end() )
+    {
+      return false ;
+    }
+
+    const BarSeries::IntervalBars &intervalBars = iSeries->second->intervals[i] ;
+    for( size_t j = 0 ; j < intervalBars.size ; ++j )
+    {
+      bars.push_back( intervalBars.history[
+          ( intervalBars.next + _history - intervalBars.size + j ) % _history ] ) ;
+    }
+    if( intervalBars.open )
+    {
+      bars.push_back( intervalBars.bar ) ;
+    }
+    return intervalBars.size > 0 || intervalBars.open ;
+  }
+
+  long long BarAggregator::getDropped()
+  {
+    long long dropped = _retiredDropped ;
+    boost::mutex::scoped_lock lock( _mutexTradeRings ) ;
+    for( size_t i = 0 ; i < _tradeRings.size() ; ++i )
+    {
+      dropped += _tradeRings[i]->dropped.load( boost::memory_order_relaxed ) ;
+    }
+    return dropped ;
+  }
+
+  void BarAggregator::run()
+  {
+    while( true )
+    {
+      bool added ;
+      {
+        boost::mutex::scoped_lock lock( _mutexSeries ) ;
+        added = drain() ;
+        closeBars( now() ) ;
+      }
+      publish() ;
+
+      if( !added )
+      {
+        boost::this_thread::sleep( boost::posix_time::milliseconds( 1 ) ) ;
+      }
+    }
+  }
+
+  bool BarAggregator::drain()
+  {
+    std::vector< TradeRing * > tradeRings ;
+    {
+      boost::mutex::scoped_lock lock( _mutexTradeRings ) ;
+      tradeRings = _tradeRings ;
+    }
+
+    bool added = false ;
+    for( size_t i = 0 ; i < tradeRings.size() ; ++i )
+    {
+      TradeRing *tradeRing = tradeRings[i] ;
+
+      // Checked first, so nothing is added after the last drain.
+      bool retired = tradeRing->retired.load( boost::memory_order_acquire ) ;
+      const Trade *trade ;
+      while( ( trade = tradeRing->ring.front() ) != 0 )
+      {
+        add( *trade ) ;
+        tradeRing->ring.pop() ;
+        added = true ;
+      }
+
+      if( retired )
+      {
+        boost::mutex::scoped_lock lock( _mutexTradeRings ) ;
+        _retiredDropped += tradeRing->dropped.load( boost::memory_order_relaxed ) ;
+        _tradeRings.erase( std::find( _tradeRings.begin(), _tradeRings.end(),
+                                      tradeRing ) ) ;
+        delete tradeRing ;
+      }
+    }
+    return added ;
+  }
+
+  void BarAggregator::add( const Trade &trade )
+  {
+    BarSeries &series = *trade.series ;
+    for( size_t i = 0 ; i < _intervals.size() ; ++i )
+    {
+      const int64_t length = _intervals[i] * 1000LL ;
+      const int64_t startTime = trade.time - trade.time % length ;
+      BarSeries::IntervalBars &bars = series.intervals[i] ;
+
+      if( bars.open && startTime > bars.bar.getStartTime() )
+      {
+        close( series, i ) ;
+      }
+
+      if( bars.open && startTime == bars.bar.getStartTime() )
+      {
+        update( bars.bar, trade.price, trade.qty ) ;
+        if( isBefore( trade.tradeNo, bars.openTradeNo ) )
+        {
+          bars.bar.setOpenPrice( trade.price ) ;
+          bars.openTradeNo = trade.tradeNo ;
+        }
+        if( isBefore( bars.closeTradeNo, trade.tradeNo ) )
+        {
+          bars.bar.setClosePrice( trade.price ) ;
+          bars.closeTradeNo = trade.tradeNo ;
+        }
+        continue ;
+      }
+
+      const size_t last = ( bars.next + _history - 1 ) % _history ;
+      if( !bars.open
+          && ( bars.size == 0 || startTime > bars.history[ last ].getStartTime() ) )
+      {
+        Bars::Record &bar = bars.bar ;
+        bar.setStartTime( startTime ) ;
+        bar.setOpenPrice( trade.price ) ;
+        bar.setHighPrice( trade.price ) ;
+        bar.setLowPrice( trade.price ) ;
+        bar.setClosePrice( trade.price ) ;
+        bar.setNoOfTrades( 1 ) ;
+        bar.setVolume( trade.qty ) ;
+        bar.setValue( trade.qty * trade.price ) ;
+        bar.setWeightedAvgPrice( trade.price ) ;
+        bars.openTradeNo = trade.tradeNo ;
+        bars.closeTradeNo = trade.tradeNo ;
+        bars.open = true ;
+
+        if( !bars.listed )
+        {
+          _openSeries[i].push_back( &series ) ;
+          bars.listed = true ;
+        }
+        continue ;
+      }
+
+      // Late for a bar closed already.
+      for( size_t j = 0 ; j < bars.size ; ++j )
+      {
+        Bars::Record &bar = bars.history[ ( last + _history - j ) % _history ] ;
+        if( bar.getStartTime() == startTime )
+        {
+          update( bar, trade.price, trade.qty ) ;
+          break ;
+        }
+        if( bar.getStartTime() < startTime )
+        {
+          break ;
+        }
+      }
+    }
+  }
+
+  void BarAggregator::closeBars( int64_t now )
+  {
+    for( size_t i = 0 ; i < _intervals.size() ; ++i )
+    {
+      if( now < _nextClose[i] )
+      {
+        continue ;
+      }
+
+      // Bars starting before the current interval are over.
+      const int64_t length = _intervals[i] * 1000LL ;
+      const int64_t current = ( now - CloseDelay ) - ( now - CloseDelay ) % length ;
+      std::vector< BarSeries * > &openSeries = _openSeries[i] ;
+      for( size_t j = 0 ; j < openSeries.size() ; )
+      {
+        BarSeries::IntervalBars &bars = openSeries[j]->intervals[i] ;
+        if( bars.open && bars.bar.getStartTime() < current )
+        {
+          close( *openSeries[j], i ) ;
+        }
+
+        if( !bars.open )
+        {
+          bars.listed = false ;
+          openSeries[j] = openSeries.back() ;
+          openSeries.pop_back() ;
+        }
+        else
+        {
+          ++j ;
+        }
+      }
+      _nextClose[i] = current + length + CloseDelay ;
+    }
+  }
+
+  void BarAggregator::close( BarSeries &series, size_t interval )
+  {
+    BarSeries::IntervalBars &bars = series.intervals[ interval ] ;
+    if( bars.history.empty() )
+    {
+      bars.history.resize( _history ) ;
+    }
+
+    bars.history[ bars.next ] = bars.bar ;
+    bars.next = ( bars.next + 1 ) % _history ;
+    bars.size = std::min( bars.size + 1, _history ) ;
+    bars.open = false ;
+
+    _closed.push_back( bars.bar ) ;
+  }
+
+  void BarAggregator::publish()
+  {
+    MarketDataPublisher *publisher = _publisher ;
+    for( size_t i = 0 ; publisher != 0 && i < _closed.size() ; ++i )
+    {
+      _bars.addRecord( _closed[i] ) ;
+      if( _bars.getNoOfRecs() == Bars::MaxNoOfRecs || i + 1 == _closed.size() )
+      {
+        _bars.setSequenceNo( ++_sequenceNo ) ;
+        publisher->sendBars( _bars ) ;
+        _bars.reset() ;
+      }
+    }
+    _closed.clear() ;
+  }
+}
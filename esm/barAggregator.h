@@ -0,0 +1,194 @@
+#ifndef ESM_BAR_AGGREGATOR_H
+#define ESM_BAR_AGGREGATOR_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "../common/spscRing.h"
+#include "marketDataPublisher.h"
+
+namespace ESM
+{
+  class BarSeries ;
+
+  /**
+   * \class BarAggregator
+   *
+   * Open, high, low, close, volume & VWAP bars of the trades of every
+   * instrument, over several intervals at once, e.g. 1 second & 1 minute.
+   *
+   * An order book hands each trade to a ring of its matching thread and
+   * goes on; a thread of the aggregator drains the rings and keeps the
+   * bars, so the matching thread pays for a clock read and a copy. A trade
+   * which finds the ring full is dropped and counted, the matching thread
+   * never waits. Bars are aligned on the epoch and close when their
+   * interval is over, or as soon as a later trade is seen; then they are
+   * published and kept in a ring of the last few of each instrument, to
+   * be read at once by getBars().
+   *
+   * Trades of an instrument can reach the aggregator out of order when
+   * its book is matched from several threads. Each carries the trade
+   * number of its book, which decides the open & close; a trade arriving
+   * after its bar closed is added to the bar kept, not published again.
+   *
+   */
+  class BarAggregator
+  {
+    public :
+      enum { MaxIntervals = 4 } ;
+
+      BarAggregator() ;
+
+      /**
+       * @brief Keep bars from now on. Call once, before the first order;
+       *        books created earlier have no bars.
+       *
+       * @param The intervals in seconds, at most MaxIntervals.
+       * @param How many bars are kept for each instrument & interval.
+       */
+      void start( const std::vector< long > &intervals, size_t history ) ;
+
+      /**
+       * @brief The bars of an instrument, for its order book to add its
+       *        trades to.
+       *
+       * @return 0 unless started.
+       */
+      BarSeries *getSeries( const std::string &securityId ) ;
+
+      /**
+       * @brief Add a trade of an order book. Called under the lock of the
+       *        book; does not wait.
+       *
+       * @param The bars of the book.
+       * @param The price & quantity of the trade.
+       * @param The number of the trade in the book.
+       */
+      void addTrade( BarSeries *series, long price, long qty, int32_t tradeNo ) ;
+
+      /**
+       * @brief Send the bars which close to a publisher.
+       */
+      void setPublisher( MarketDataPublisher *publisher )
+      {
+        _publisher = publisher ;
+      }
+
+      /**
+       * @brief Copy the bars kept of an instrument, oldest first, the one
+       *        still open last.
+       *
+       * @param The security id.
+       * @param The interval in seconds.
+       * @param The bars are appended here.
+       *
+       * @return False if there are no bars of the instrument at this
+       *         interval.
+       */
+      bool getBars( const std::string &securityId,
+                    long interval,
+                    std::vector< Bars::Record > &bars ) ;
+
+      const std::vector< long > &getIntervals() const { return _intervals ; }
+
+      /**
+       * @brief The trades dropped as the ring of their thread was full.
+       */
+      long long getDropped() ;
+
+    private :
+      struct Trade
+      {
+        BarSeries *series ;
+        int64_t time ;      // ms since the epoch
+        int64_t price ;
+        int64_t qty ;
+        int32_t tradeNo ;
+      };
+
+      /**
+       * The trades of one matching thread. Once its thread ends, the
+       * aggregator thread deletes it after taking what is left.
+       */
+      struct TradeRing
+      {
+        UT::SpscRing< Trade, 4096 > ring ;
+        boost::atomic< long long > dropped ;
+        boost::atomic< bool > retired ;
+      };
+
+      static void retire( TradeRing *tradeRing ) ;
+
+      TradeRing &getTradeRing() ;
+
+      boost::atomic< bool > _started ;
+      std::vector< long > _intervals ;
+      size_t _history ;
+
+      boost::thread_specific_ptr< TradeRing > _tradeRing ;
+      std::vector< TradeRing * > _tradeRings ;
+      boost::mutex _mutexTradeRings ;
+
+      /**
+       * Dropped by the threads which ended.
+       */
+      boost::atomic< long long > _retiredDropped ;
+
+      /**
+       * The bars of every instrument, written by the aggregator thread and
+       * read by getBars() under _mutexSeries.
+       */
+      typedef boost::unordered_map< std::string, BarSeries * > SeriesMap ;
+      SeriesMap _series ;
+      boost::mutex _mutexSeries ;
+
+      /**
+       * The instruments with a bar open at each interval, to close them
+       * when it is over, and the time of the next close.
+       */
+      std::vector< BarSeries * > _openSeries[ MaxIntervals ] ;
+      int64_t _nextClose[ MaxIntervals ] ;
+
+      MarketDataPublisher *_publisher ;
+
+      /**
+       * The bars closed by the last cycle, published once _mutexSeries is
+       * released.
+       */
+      std::vector< Bars::Record > _closed ;
+      Bars _bars ;
+      short _sequenceNo ;
+
+      /**
+       * @brief The loop of the aggregator thread.
+       */
+      void run() ;
+
+      /**
+       * @brief Take the trades of every ring.
+       *
+       * @return Whether there were any.
+       */
+      bool drain() ;
+
+      void add( const Trade &trade ) ;
+
+      /**
+       * @brief Close the bars whose interval is over.
+       */
+      void closeBars( int64_t now ) ;
+
+      /**
+       * @brief Keep a bar which closed, to be published.
+       */
+      void close( BarSeries &series, size_t interval ) ;
+
+      void publish() ;
+  };
+}
+
+#endif // ESM_BAR_AGGREGATOR_H
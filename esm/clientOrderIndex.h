@@ -0,0 +1,121 @@
+#ifndef ESM_CLIENT_ORDER_INDEX_H
+#define ESM_CLIENT_ORDER_INDEX_H
+
+#include <algorithm>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "order.h"
+
+namespace ESM
+{
+  /**
+   * \class ClientOrderIndex
+   *
+   * The ClOrdIDs used by one session and the order each one refers to.
+   * A new order adds its own ClOrdID. A cancel or replace adds its ClOrdID
+   * against the order it targets, so that a later request can name the
+   * order by any ClOrdID in its chain.
+   *
+   * Every ClOrdID is kept for the life of the session: one may not be
+   * reused even once its order is done. The orders themselves are only
+   * held while live; those finished are dropped each time the index has
+   * doubled since it was last swept, after which their ClOrdIDs name no
+   * order. Whether an order is still live is otherwise only checked by
+   * the order book, when the request reaches it.
+   *
+   * The index is only used by the thread reading the session, so it has
+   * no lock.
+   *
+   */
+  class ClientOrderIndex
+  {
+    public :
+      ClientOrderIndex() : _sweepSize( MinSweepSize ) {}
+
+      /**
+       * @brief Record a ClOrdID.
+       *
+       * @param The ClOrdID of the request.
+       *
+       * @param The order it refers to. May be empty for a request naming
+       *        an unknown order.
+       *
+       * @return False if the ClOrdID was already used by this session.
+       */
+      bool insert( const std::string &clientOrderId, const OrderPtr &order )
+      {
+        if( !_clientOrderIds.insert( clientOrderId ).second )
+        {
+          return false ;
+        }
+
+        if( order )
+        {
+          if( _orders.size() >= _sweepSize )
+          {
+            sweep() ;
+          }
+          _orders.insert( std::make_pair( clientOrderId, order ) ) ;
+        }
+        return true ;
+      }
+
+      /**
+       * @brief Find the order a ClOrdID refers to.
+       *
+       * @return The order, or an empty pointer if the ClOrdID is unknown or
+       *         its order is done and was dropped.
+       */
+      OrderPtr find( const std::string &clientOrderId ) const
+      {
+        OrdersByClientOrderIdMap::const_iterator iOrder =
+          _orders.find( clientOrderId ) ;
+        if( iOrder == _orders.end() )
+        {
+          return OrderPtr() ;
+        }
+        return iOrder->second ;
+      }
+
+    private :
+      enum { MinSweepSize = 1024 } ;
+
+      boost::unordered_set< std::string > _clientOrderIds ;
+
+      typedef boost::unordered_map< std::string, OrderPtr >
+        OrdersByClientOrderIdMap ;
+      OrdersByClientOrderIdMap _orders ;
+
+      /**
+       * The number of orders at which the next sweep is done.
+       */
+      size_t _sweepSize ;
+
+      /**
+       * @brief Drop the orders which are done.
+       */
+      void sweep()
+      {
+        for( OrdersByClientOrderIdMap::iterator iOrder = _orders.begin() ;
+             iOrder != _orders.end() ; )
+        {
+          if( iOrder->second->isFinished() )
+          {
+            iOrder = _orders.erase( iOrder ) ;
+          }
+          else
+          {
+            ++iOrder ;
+          }
+        }
+        _sweepSize = std::max< size_t >( MinSweepSize, 2 * _orders.size() ) ;
+      }
+  };
+
+  typedef boost::shared_ptr< ClientOrderIndex > ClientOrderIndexPtr ;
+}
+
+#endif // ESM_CLIENT_ORDER_INDEX_H
@@ -5,5 +5,18 @@ namespace ESM
 {
   const long ZERO = 0 ;
   const char FIX_ExecType_TRIGGERED = 'T' ;
+
+  /**
+   * Status replies on the shared memory transport. FIX 4.2 sessions use
+   * ExecTransType STATUS instead.
+   */
+  const char FIX_ExecType_ORDER_STATUS = 'I' ;
+
+  /**
+   * Mass cancel messages are from FIX 4.3. We accept them on our 4.2
+   * sessions through the data dictionary.
+   */
+  const char FIX_MsgType_ORDER_MASS_CANCEL_REQUEST[] = "q" ;
+  const char FIX_MsgType_ORDER_MASS_CANCEL_REPORT[] = "r" ;
 }
 #endif  //ESM_CONSTANTS_H
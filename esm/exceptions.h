@@ -2,7 +2,6 @@
 #define ESM_EXCEPTIONS_H
 
 #include <string>
-#include "order.h"
 
 namespace ESM
 {
@@ -21,23 +20,24 @@ namespace ESM
 
       Exception(const std::string errorType, const std::string &what )
                : _type ( errorType), _message ( what )
-      { }
+      {
+        _returnMessage = _type ;
+        _returnMessage.append( " : " ) ;
+        _returnMessage.append( _message ) ;
+      }
 
       ~Exception() throw() {}
 
       virtual const char* what() const
         throw()
       {
-        std::string msg( _type ) ;
-        msg.append( " : " ) ;
-        msg.append( _message ) ;
-
-        return msg.c_str() ;
+        return _returnMessage.c_str() ;
       }
 
     private :
       std::string _type ;
       std::string _message ;
+      std::string _returnMessage ;
   };
 
   /**
@@ -62,6 +62,29 @@ namespace ESM
       {}
   };
 
+  /**
+   * @brief Exception thrown when a price is not on the tick table of its
+   * instrument.
+   */
+  class InvalidPrice : public Exception
+  {
+    public :
+      InvalidPrice( const std::string &what )
+        : Exception( "Invalid Price", what )
+      {}
+  };
+
+  /**
+   * @brief Exception thrown when an order fails a pre-trade risk check.
+   */
+  class RiskRejected : public Exception
+  {
+    public :
+      RiskRejected( const std::string &what )
+        : Exception( "Risk Rejected", what )
+      {}
+  };
+
   /**
    * @brief Exception thrown when a container doesn't have any data but we try
    * to access it's element ;
@@ -0,0 +1,138 @@
+#ifndef ESM_EXECUTION_SINK_H
+#define ESM_EXECUTION_SINK_H
+
+#include <string>
+
+#include "order.h"
+
+namespace ESM
+{
+  /**
+   * \class ExecutionSink
+   *
+   * Where the market & the order books send what happens to orders. The
+   * FIX ReplyApplication is one sink; others record or drop the events so
+   * that the engine can run without sessions, e.g. in a backtest or a
+   * benchmark.
+   *
+   * Every event telling the sender an order is done (filled, cancelled or
+   * rejected) finishes the order, taking it out of the open orders of the
+   * risk gate, before the sink sees it. A sink only has to deliver.
+   *
+   * The order books call a sink from several threads, each holding the
+   * lock of its book.
+   *
+   */
+  class ExecutionSink
+  {
+    public :
+      virtual ~ExecutionSink() {}
+
+      /**
+       * @brief The order has been accepted by its order book.
+       */
+      void sendNewConfirm( OrderPtr order )
+      {
+        onNewConfirm( order ) ;
+      }
+
+      /**
+       * @brief The order has been replaced.
+       */
+      void sendReplaceConfirm( OrderPtr order )
+      {
+        onReplaceConfirm( order ) ;
+      }
+
+      /**
+       * @brief The order has been cancelled, by its sender or the market.
+       */
+      void sendCancelConfirm( OrderPtr order, const std::string &reason )
+      {
+        order->finish() ;
+        onCancelConfirm( order, reason ) ;
+      }
+
+      /**
+       * @brief The new order has been rejected.
+       */
+      void sendNewReject( OrderPtr order, const std::string &reason )
+      {
+        order->finish() ;
+        onNewReject( order, reason ) ;
+      }
+
+      /**
+       * @brief The replace request has been rejected.
+       */
+      void sendReplaceReject( OrderPtr order, const std::string &reason )
+      {
+        onReplaceReject( order, reason ) ;
+      }
+
+      /**
+       * @brief The cancel request has been rejected.
+       */
+      void sendCancelReject( OrderPtr order, const std::string &reason )
+      {
+        onCancelReject( order, reason ) ;
+      }
+
+      /**
+       * @brief A market order that could not be filled was converted to
+       * limit.
+       */
+      void sendMarketToLimit( OrderPtr order )
+      {
+        onMarketToLimit( order ) ;
+      }
+
+      /**
+       * @brief A stop loss order has been triggered.
+       */
+      void sendTriggered( OrderPtr order )
+      {
+        onTriggered( order ) ;
+      }
+
+      /**
+       * @brief The order has traded, its last shares at its last price.
+       */
+      void sendFillConfirm( OrderPtr order )
+      {
+        if( order->getPendingQty() == 0 )
+        {
+          order->finish() ;
+        }
+        onFillConfirm( order ) ;
+      }
+
+      /**
+       * @brief The current status of an order, in reply to a status
+       * request.
+       */
+      void sendOrderStatus( OrderPtr order, const std::string &text = "" )
+      {
+        onOrderStatus( order, text ) ;
+      }
+
+    protected :
+      virtual void onNewConfirm( const OrderPtr &order ) = 0 ;
+      virtual void onReplaceConfirm( const OrderPtr &order ) = 0 ;
+      virtual void onCancelConfirm( const OrderPtr &order,
+                                    const std::string &reason ) = 0 ;
+      virtual void onNewReject( const OrderPtr &order,
+                                const std::string &reason ) = 0 ;
+      virtual void onReplaceReject( const OrderPtr &order,
+                                    const std::string &reason ) = 0 ;
+      virtual void onCancelReject( const OrderPtr &order,
+                                   const std::string &reason ) = 0 ;
+      virtual void onMarketToLimit( const OrderPtr &order ) = 0 ;
+      virtual void onTriggered( const OrderPtr &order ) = 0 ;
+      virtual void onFillConfirm( const OrderPtr &order ) = 0 ;
+      virtual void onOrderStatus( const OrderPtr &order,
+                                  const std::string &text ) = 0 ;
+  };
+}
+
+#endif // ESM_EXECUTION_SINK_H
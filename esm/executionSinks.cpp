@@ -0,0 +1,153 @@
+#include "executionSinks.h"
+#include "../common/exceptions.h"
+
+#include <time.h>
+#include <cstring>
+
+namespace ESM
+{
+  namespace
+  {
+    void copyString( char *destination, const std::string &value, size_t size )
+    {
+      size_t length = value.size() < size ? value.size() : size - 1 ;
+      memcpy( destination, value.data(), length ) ;
+      destination[ length ] = '\0' ;
+    }
+  }
+
+  void ExecutionRecord::set( ExecutionEvent event,
+                             const OrderPtr &order,
+                             const std::string &text )
+  {
+    timespec now ;
+    clock_gettime( CLOCK_REALTIME, &now ) ;
+
+    // Written to file as it is, so no byte is left unset.
+    memset( this, 0, sizeof( *this ) ) ;
+    setEvent( event ) ;
+    setSide( order->getSide() ) ;
+    setTimestamp( now.tv_sec * 1000000000LL + now.tv_nsec ) ;
+    setOrderQty( order->getOrderQty() ) ;
+    setLeavesQty( order->getActualPendingQty() ) ;
+    setCumQty( order->getFilledQty() ) ;
+    setAvgPrice( order->getAvgPrice() ) ;
+    setLastQty( order->getLastShares() ) ;
+    setLastPrice( order->getLastPrice() ) ;
+    setPrice( order->getPrice() ) ;
+    copyString( getRefSecurityId(), order->getSecurityId(), ExecutionIdLength ) ;
+    copyString( getRefClOrdId(), order->getClientOrderId(), ExecutionIdLength ) ;
+    copyString( getRefOrderId(), UT::UniqueOrderId::toString( order->getOrderId() ),
+                ExecutionIdLength ) ;
+    copyString( getRefSenderId(), order->getSenderId(), ExecutionSenderLength ) ;
+    copyString( getRefText(), text, ExecutionTextLength ) ;
+  }
+
+  void RecordedExecutionSink::recordEvent( ExecutionEvent event,
+                                           const OrderPtr &order,
+                                           const std::string &text )
+  {
+    ExecutionRecord executionRecord ;
+    executionRecord.set( event, order, text ) ;
+    record( executionRecord ) ;
+  }
+
+  void RecordedExecutionSink::onNewConfirm( const OrderPtr &order )
+  {
+    recordEvent( ExecutionEvent_NEW, order, "" ) ;
+  }
+
+  void RecordedExecutionSink::onReplaceConfirm( const OrderPtr &order )
+  {
+    recordEvent( ExecutionEvent_REPLACED, order, "" ) ;
+  }
+
+  void RecordedExecutionSink::onCancelConfirm( const OrderPtr &order,
+                                               const std::string &reason )
+  {
+    recordEvent( ExecutionEvent_CANCELLED, order, reason ) ;
+  }
+
+  void RecordedExecutionSink::onNewReject( const OrderPtr &order,
+                                           const std::string &reason )
+  {
+    recordEvent( ExecutionEvent_NEW_REJECT, order, reason ) ;
+  }
+
+  void RecordedExecutionSink::onReplaceReject( const OrderPtr &order,
+                                               const std::string &reason )
+  {
+    recordEvent( ExecutionEvent_REPLACE_REJECT, order, reason ) ;
+  }
+
+  void RecordedExecutionSink::onCancelReject( const OrderPtr &order,
+                                              const std::string &reason )
+  {
+    recordEvent( ExecutionEvent_CANCEL_REJECT, order, reason ) ;
+  }
+
+  void RecordedExecutionSink::onMarketToLimit( const OrderPtr &order )
+  {
+    recordEvent( ExecutionEvent_MARKET_TO_LIMIT, order, "" ) ;
+  }
+
+  void RecordedExecutionSink::onTriggered( const OrderPtr &order )
+  {
+    recordEvent( ExecutionEvent_TRIGGERED, order, "" ) ;
+  }
+
+  void RecordedExecutionSink::onFillConfirm( const OrderPtr &order )
+  {
+    recordEvent( ExecutionEvent_FILL, order, "" ) ;
+  }
+
+  void RecordedExecutionSink::onOrderStatus( const OrderPtr &order,
+                                             const std::string &text )
+  {
+    recordEvent( ExecutionEvent_ORDER_STATUS, order, text ) ;
+  }
+
+  void MemoryExecutionSink::record( const ExecutionRecord &executionRecord )
+  {
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    _records.push_back( executionRecord ) ;
+  }
+
+  void MemoryExecutionSink::getRecords( std::vector< ExecutionRecord > &records )
+  {
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    records.insert( records.end(), _records.begin(), _records.end() ) ;
+  }
+
+  void MemoryExecutionSink::clear()
+  {
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    _records.clear() ;
+  }
+
+  FileExecutionSink::FileExecutionSink( const std::string &fileName )
+    : _file( fopen( fileName.c_str(), "wb" ) )
+  {
+    if( _file == 0 )
+    {
+      throw UT::FileNotFound( fileName ) ;
+    }
+  }
+
+  FileExecutionSink::~FileExecutionSink()
+  {
+    fclose( _file ) ;
+  }
+
+  void FileExecutionSink::record( const ExecutionRecord &executionRecord )
+  {
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    fwrite( &executionRecord, sizeof( executionRecord ), 1, _file ) ;
+  }
+
+  void FileExecutionSink::flush()
+  {
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    fflush( _file ) ;
+  }
+}
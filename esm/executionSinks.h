@@ -0,0 +1,174 @@
+#ifndef ESM_EXECUTION_SINKS_H
+#define ESM_EXECUTION_SINKS_H
+
+#include <cstdio>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "../common/definesForCreateEndianless.h"
+#include "executionSink.h"
+
+namespace ESM
+{
+  /**
+   * The event of an execution record.
+   */
+  enum ExecutionEvent
+  {
+    ExecutionEvent_NEW,
+    ExecutionEvent_REPLACED,
+    ExecutionEvent_CANCELLED,
+    ExecutionEvent_NEW_REJECT,
+    ExecutionEvent_REPLACE_REJECT,
+    ExecutionEvent_CANCEL_REJECT,
+    ExecutionEvent_MARKET_TO_LIMIT,
+    ExecutionEvent_TRIGGERED,
+    ExecutionEvent_FILL,
+    ExecutionEvent_ORDER_STATUS
+  };
+
+  const unsigned long ExecutionIdLength = 24 ;
+  const unsigned long ExecutionSenderLength = 64 ;
+  const unsigned long ExecutionTextLength = 64 ;
+
+  /**
+   * An event sent to an execution sink, as recorded in memory and written
+   * to file. Prices are fixed-point, as in the order.
+   */
+  struct ExecutionRecord
+  {
+    UT_CREATE_CHAR( Event ) ;
+    UT_CREATE_CHAR( Side ) ;
+    UT_CREATE_LONGLONG( Timestamp ) ;
+    UT_CREATE_LONGLONG( OrderQty ) ;
+    UT_CREATE_LONGLONG( LeavesQty ) ;
+    UT_CREATE_LONGLONG( CumQty ) ;
+    UT_CREATE_LONGLONG( AvgPrice ) ;
+    UT_CREATE_LONGLONG( LastQty ) ;
+    UT_CREATE_LONGLONG( LastPrice ) ;
+    UT_CREATE_LONGLONG( Price ) ;
+    UT_CREATE_STRING( SecurityId, ExecutionIdLength ) ;
+    UT_CREATE_STRING( ClOrdId, ExecutionIdLength ) ;
+    UT_CREATE_STRING( OrderId, ExecutionIdLength ) ;
+    UT_CREATE_STRING( SenderId, ExecutionSenderLength ) ;
+    UT_CREATE_STRING( Text, ExecutionTextLength ) ;
+
+    public :
+      /**
+       * @brief Record an event of an order, at the current time in
+       * nanoseconds since the epoch.
+       */
+      void set( ExecutionEvent event,
+                const OrderPtr &order,
+                const std::string &text ) ;
+  };
+
+  /**
+   * \class NullExecutionSink
+   *
+   * Drops every event, to measure the engine alone.
+   *
+   */
+  class NullExecutionSink : public ExecutionSink
+  {
+    protected :
+      void onNewConfirm( const OrderPtr & ) {}
+      void onReplaceConfirm( const OrderPtr & ) {}
+      void onCancelConfirm( const OrderPtr &, const std::string & ) {}
+      void onNewReject( const OrderPtr &, const std::string & ) {}
+      void onReplaceReject( const OrderPtr &, const std::string & ) {}
+      void onCancelReject( const OrderPtr &, const std::string & ) {}
+      void onMarketToLimit( const OrderPtr & ) {}
+      void onTriggered( const OrderPtr & ) {}
+      void onFillConfirm( const OrderPtr & ) {}
+      void onOrderStatus( const OrderPtr &, const std::string & ) {}
+  };
+
+  /**
+   * \class RecordedExecutionSink
+   *
+   * Turns every event into an ExecutionRecord and hands it to record().
+   *
+   */
+  class RecordedExecutionSink : public ExecutionSink
+  {
+    protected :
+      virtual void record( const ExecutionRecord &executionRecord ) = 0 ;
+
+      void onNewConfirm( const OrderPtr &order ) ;
+      void onReplaceConfirm( const OrderPtr &order ) ;
+      void onCancelConfirm( const OrderPtr &order, const std::string &reason ) ;
+      void onNewReject( const OrderPtr &order, const std::string &reason ) ;
+      void onReplaceReject( const OrderPtr &order, const std::string &reason ) ;
+      void onCancelReject( const OrderPtr &order, const std::string &reason ) ;
+      void onMarketToLimit( const OrderPtr &order ) ;
+      void onTriggered( const OrderPtr &order ) ;
+      void onFillConfirm( const OrderPtr &order ) ;
+      void onOrderStatus( const OrderPtr &order, const std::string &text ) ;
+
+    private :
+      void recordEvent( ExecutionEvent event,
+                        const OrderPtr &order,
+                        const std::string &text ) ;
+  };
+
+  /**
+   * \class MemoryExecutionSink
+   *
+   * Keeps the events in memory, e.g. for a backtest to inspect.
+   *
+   */
+  class MemoryExecutionSink : public RecordedExecutionSink
+  {
+    public :
+      /**
+       * @brief Copy the events recorded so far.
+       *
+       * @param The events are appended here.
+       */
+      void getRecords( std::vector< ExecutionRecord > &records ) ;
+
+      void clear() ;
+
+    protected :
+      void record( const ExecutionRecord &executionRecord ) ;
+
+    private :
+      std::vector< ExecutionRecord > _records ;
+      boost::mutex _mutex ;
+  };
+
+  /**
+   * \class FileExecutionSink
+   *
+   * Appends the events to a file as ExecutionRecord structs, through the
+   * stdio buffer.
+   *
+   */
+  class FileExecutionSink : public RecordedExecutionSink,
+                            private boost::noncopyable
+  {
+    public :
+      /**
+       * @param The file, truncated. Throws UT::FileNotFound if it cannot
+       * be opened.
+       */
+      explicit FileExecutionSink( const std::string &fileName ) ;
+      ~FileExecutionSink() ;
+
+      /**
+       * @brief Write the buffered records to the file.
+       */
+      void flush() ;
+
+    protected :
+      void record( const ExecutionRecord &executionRecord ) ;
+
+    private :
+      FILE *_file ;
+      boost::mutex _mutex ;
+  };
+}
+
+#endif // ESM_EXECUTION_SINKS_H
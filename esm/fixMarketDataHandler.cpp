@@ -1,21 +1,42 @@
 #include "fixMarketDataHandler.h"
-#include <dismantleFix.h>
+
+#include "market.h"
+
+#include <time.h>
 
 #include <quickfix/Session.h>
-#include <quickfix/fix42/MarketDataSnapshotFullRefresh.h>
+#include <quickfix/fix42/MarketDataRequestReject.h>
 
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 
 namespace ESM {
 
+  MarketDataApplication::MarketDataApplication()
+    : _subscribers(),
+      _requests(),
+      _allSubscriptions(),
+      _mutexSubscriptions(),
+      _streams(),
+      _mutexStreams(),
+      _streamsQueued(),
+      _market( 0 ),
+      _capture( 0 ),
+      _subscribeOnLogon( false )
+  {
+    boost::thread streamThread( &MarketDataApplication::sendStreams, this ) ;
+  }
+
   void MarketDataApplication::toApp( FIX::Message&message,
                                      const FIX::SessionID& )
     throw( FIX::DoNotSend )
   {
-#ifndef NDEBUG
-    UT::DismantleFix::dismantle( "OUTBOUND", message.toString() ) ;
-#endif
+    if( _capture != 0 )
+    {
+      _capture->append( UT::CaptureDirection_OUTBOUND, message.toString() ) ;
+    }
   }
 
   void MarketDataApplication::fromApp(const FIX::Message& message,
@@ -26,84 +47,569 @@ namespace ESM {
            FIX::UnsupportedMessageType )
 
   {
-#ifndef NDEBUG
-    UT::DismantleFix::dismantle( "INBOUND", message.toString() ) ;
-#endif
+    if( _capture != 0 )
+    {
+      _capture->append( UT::CaptureDirection_INBOUND, message.toString() ) ;
+    }
+
+    crack( message, sessionId ) ;
+  }
+
+  void MarketDataApplication::onMessage(
+      const FIX42::MarketDataRequest &request,
+      const FIX::SessionID &sessionId )
+  {
+    std::string mdReqId = request.getField( FIX::FIELD::MDReqID ) ;
+    FIX::SubscriptionRequestType lType ;
+    request.get( lType ) ;
+    char type = lType ;
+    FIX::MarketDepth lDepth ;
+    request.get( lDepth ) ;
+
+    // Rejects are sent once _mutexSubscriptions is released, as the
+    // publishing threads share it for every book.
+    if( type == FIX::SubscriptionRequestType_DISABLE_PREVIOUS_SNAPSHOT_PLUS_UPDATE_REQUEST )
+    {
+      bool isKnown = false ;
+      {
+        boost::unique_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
+        RequestsMap &requests = _requests[ sessionId ] ;
+        RequestsMap::iterator iRequest = requests.find( mdReqId ) ;
+        if( iRequest != requests.end() )
+        {
+          for( size_t i = 0 ; i < iRequest->second.size() ; ++i )
+          {
+            unsubscribe( iRequest->second[i], sessionId, mdReqId ) ;
+          }
+          requests.erase( iRequest ) ;
+          isKnown = true ;
+        }
+      }
+      if( !isKnown )
+      {
+        reject( mdReqId, 0, "Unknown MDReqID", sessionId ) ;
+      }
+      return ;
+    }
+
+    if( type != FIX::SubscriptionRequestType_SNAPSHOT
+        && type != FIX::SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES )
+    {
+      reject( mdReqId, FIX::MDReqRejReason_UNSUPPORTED_SUBSCRIPTIONREQUESTTYPE,
+              "Unsupported SubscriptionRequestType", sessionId ) ;
+      return ;
+    }
+
+    int depth = lDepth ;
+    if( depth < 0 )
+    {
+      reject( mdReqId, FIX::MDReqRejReason_UNSUPPORTED_MARKETDEPTH,
+              "Unsupported MarketDepth", sessionId ) ;
+      return ;
+    }
+    if( depth == 0 || depth > MaxDepth )
+    {
+      depth = MaxDepth ;
+    }
+
+    // Securities are named by SecurityID like the orders, or by Symbol.
+    std::vector< std::string > securityIds ;
+    FIX42::MarketDataRequest::NoRelatedSym group ;
+    size_t noRelatedSym = request.groupCount( FIX::FIELD::NoRelatedSym ) ;
+    for( size_t i = 1 ; i <= noRelatedSym ; ++i )
+    {
+      request.getGroup( i, group ) ;
+      FIX::SecurityID lSecurityId ;
+      if( group.isSetField( lSecurityId ) )
+      {
+        group.getField( lSecurityId ) ;
+        securityIds.push_back( lSecurityId ) ;
+      }
+      else
+      {
+        securityIds.push_back( group.getField( FIX::FIELD::Symbol ) ) ;
+      }
+
+      if( securityIds.back().empty() )
+      {
+        reject( mdReqId, FIX::MDReqRejReason_UNKNOWN_SYMBOL,
+                "Empty security", sessionId ) ;
+        return ;
+      }
+    }
+
+    if( type == FIX::SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES )
+    {
+      bool isDuplicate = false ;
+      {
+        boost::unique_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
+        RequestsMap &requests = _requests[ sessionId ] ;
+        if( requests.find( mdReqId ) != requests.end() )
+        {
+          isDuplicate = true ;
+        }
+        else
+        {
+          requests[ mdReqId ] = securityIds ;
+
+          Subscription subscription ;
+          subscription.sessionId = sessionId ;
+          subscription.mdReqId = mdReqId ;
+          subscription.depth = depth ;
+          for( size_t i = 0 ; i < securityIds.size() ; ++i )
+          {
+            _subscribers[ securityIds[i] ].push_back( subscription ) ;
+          }
+        }
+      }
+      if( isDuplicate )
+      {
+        reject( mdReqId, FIX::MDReqRejReason_DUPLICATE_MDREQID,
+                "Duplicate MDReqID", sessionId ) ;
+        return ;
+      }
+    }
+
+    Stream stream ;
+    stream.sessionId = sessionId ;
+    stream.mdReqId = mdReqId ;
+    stream.depth = depth ;
+    stream.subscribed = type == FIX::SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES ;
+    stream.securityIds = securityIds ;
+    queue( stream ) ;
   }
 
   void MarketDataApplication::onLogon( const FIX::SessionID& id )
   {
-    boost::mutex::scoped_lock lock( _mutexSetSessions );
-    _setSessions.insert( id );
+    if( !_subscribeOnLogon )
+    {
+      return ;
+    }
+
+    Stream stream ;
+    stream.sessionId = id ;
+    stream.depth = MaxDepth ;
+    stream.subscribed = true ;
+
+    Subscription subscription ;
+    subscription.sessionId = id ;
+    subscription.depth = MaxDepth ;
+    {
+      boost::unique_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
+      _allSubscriptions.push_back( subscription ) ;
+    }
+    queue( stream ) ;
   }
 
   void MarketDataApplication::onLogout( const FIX::SessionID& id )
   {
-    boost::mutex::scoped_lock lock( _mutexSetSessions );
-    _setSessions.erase( id );
+    boost::unique_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
+    for( Subscriptions::iterator iSubscription = _allSubscriptions.begin() ;
+         iSubscription != _allSubscriptions.end() ;
+         ++iSubscription )
+    {
+      if( iSubscription->sessionId == id )
+      {
+        _allSubscriptions.erase( iSubscription ) ;
+        break ;
+      }
+    }
+
+    RequestsBySessionMap::iterator iSession = _requests.find( id ) ;
+    if( iSession == _requests.end() )
+    {
+      return ;
+    }
+
+    for( RequestsMap::iterator iRequest = iSession->second.begin() ;
+         iRequest != iSession->second.end() ;
+         ++iRequest )
+    {
+      for( size_t i = 0 ; i < iRequest->second.size() ; ++i )
+      {
+        unsubscribe( iRequest->second[i], id, iRequest->first ) ;
+      }
+    }
+    _requests.erase( iSession ) ;
+  }
+
+  void MarketDataApplication::unsubscribe( const std::string &securityId,
+                                           const FIX::SessionID &sessionId,
+                                           const std::string &mdReqId )
+  {
+    SubscribersMap::iterator iSubscribers = _subscribers.find( securityId ) ;
+    if( iSubscribers == _subscribers.end() )
+    {
+      return ;
+    }
+
+    Subscriptions &subscriptions = iSubscribers->second ;
+    for( Subscriptions::iterator iSubscription = subscriptions.begin() ;
+         iSubscription != subscriptions.end() ;
+         ++iSubscription )
+    {
+      if( iSubscription->sessionId == sessionId
+          && iSubscription->mdReqId == mdReqId )
+      {
+        subscriptions.erase( iSubscription ) ;
+        break ;
+      }
+    }
+
+    if( subscriptions.empty() )
+    {
+      _subscribers.erase( iSubscribers ) ;
+    }
+  }
+
+  void MarketDataApplication::reject( const std::string &mdReqId,
+                                      char reason,
+                                      const std::string &text,
+                                      const FIX::SessionID &sessionId )
+  {
+    FIX42::MarketDataRequestReject fixReject( ( FIX::MDReqID( mdReqId ) ) ) ;
+    if( reason != 0 )
+    {
+      fixReject.set( FIX::MDReqRejReason( reason ) ) ;
+    }
+    fixReject.set( FIX::Text( text ) ) ;
+
+    try
+    {
+      FIX::Session::sendToTarget( fixReject, sessionId ) ;
+    }
+    catch( FIX::SessionNotFound &e )
+    {
+      std::cout << "Error on Sending market data reject " << e.what()
+                << std::endl ;
+    }
+  }
+
+  void MarketDataApplication::makeSnapshot(
+      const MarketPicture::Record &mpRecord,
+      const std::string &securityId,
+      int depth,
+      FIX42::MarketDataSnapshotFullRefresh &mdSnapshot )
+  {
+    const Instrument &instrument = Instruments::get( securityId );
+
+    mdSnapshot = FIX42::MarketDataSnapshotFullRefresh() ;
+    mdSnapshot.set( FIX::Symbol( securityId ) );
+    mdSnapshot.set( FIX::SecurityID( securityId ) );
+    FIX42::MarketDataSnapshotFullRefresh::NoMDEntries group;
+
+    for (int j = 0; j < depth; j++)
+    {
+      long buyPrice = mpRecord.getDepthAt( j ).getBestBuyPrice();
+      long buyQty = mpRecord.getDepthAt( j ).getTotalBuyQty();
+      long sellPrice = mpRecord.getDepthAt( j ).getBestSellPrice();
+      long sellQty = mpRecord.getDepthAt( j ).getTotalSellQty();
+
+      bool buyNotAvail = false;
+      bool sellNotAvail = false;
+
+      if ( buyPrice != 0 && buyQty != 0 )
+      {
+        group.set( FIX::MDEntryType( FIX::MDEntryType_BID ) );
+        group.set( FIX::MDEntryPx( instrument.toDouble( buyPrice ) ) );
+        group.set( FIX::MDEntrySize( buyQty ) );
+        mdSnapshot.addGroup( group );
+      }
+      else
+        buyNotAvail = true;
+
+      if ( sellPrice != 0 && sellQty != 0 )
+      {
+        group.set( FIX::MDEntryType( FIX::MDEntryType_OFFER ) );
+        group.set( FIX::MDEntryPx( instrument.toDouble( sellPrice ) ) );
+        group.set( FIX::MDEntrySize( sellQty ) );
+        mdSnapshot.addGroup( group );
+      }
+      else
+        sellNotAvail = true;
+
+      if ( buyNotAvail && sellNotAvail )
+        break;
+    }
   }
 
   void MarketDataApplication::send( const MarketPicture& message )
   {
+    FIX42::MarketDataSnapshotFullRefresh scratch;
+    boost::shared_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
+
     for (int i = 0; i < message.getNoOfRecs(); i++ )
     {
       const MarketPicture::Record& mpRecord = message.getRecordAt( i );
+      std::string securityId =
+        boost::lexical_cast<std::string>( mpRecord.getScripCode() );
+
+      SnapshotStripe &stripe = getSnapshotStripe( securityId ) ;
+      boost::mutex::scoped_lock stripeLock( stripe.mutex ) ;
+
+      // Encoded again only when a subscriber or a stream needs it.
+      CachedSnapshot &cached = stripe.snapshots[ securityId ] ;
+      cached.record = mpRecord ;
+      cached.encoded = false ;
+
+      for ( Subscriptions::const_iterator it = _allSubscriptions.begin();
+            it != _allSubscriptions.end();
+            it++ )
+      {
+        sendTo( getSnapshot( stripe, securityId, it->depth, scratch ), *it ) ;
+      }
+
+      SubscribersMap::const_iterator iSubscribers =
+        _subscribers.find( securityId ) ;
+      if( iSubscribers == _subscribers.end() )
+      {
+        continue ;
+      }
+
+      const Subscriptions &subscriptions = iSubscribers->second ;
+      for ( Subscriptions::const_iterator it = subscriptions.begin();
+            it != subscriptions.end();
+            it++ )
+      {
+        sendTo( getSnapshot( stripe, securityId, it->depth, scratch ), *it ) ;
+      }
+    }
+  }
+
+  MarketDataApplication::SnapshotStripe &
+  MarketDataApplication::getSnapshotStripe( const std::string &securityId )
+  {
+    return _snapshotStripes[ boost::hash< std::string >()( securityId )
+                             % SnapshotStripes ] ;
+  }
 
-      FIX42::MarketDataSnapshotFullRefresh mdSnapshot;
-      mdSnapshot.set(
-        FIX::SecurityID(
-          boost::lexical_cast<std::string>( mpRecord.getScripCode() )
-          )
-        );
-      FIX42::MarketDataSnapshotFullRefresh::NoMDEntries group;
+  void MarketDataApplication::sendBars( const Bars &message )
+  {
+    FIX42::MarketDataIncrementalRefresh fixBar ;
+    boost::shared_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
 
-      for (int j = 0; j < 5; j++)
+    for( int i = 0 ; i < message.getNoOfRecs() ; ++i )
+    {
+      const Bars::Record &bar = message.getRecordAt( i ) ;
+      std::string securityId =
+        boost::lexical_cast< std::string >( bar.getScripCode() ) ;
+
+      SubscribersMap::const_iterator iSubscribers =
+        _subscribers.find( securityId ) ;
+      if( _allSubscriptions.empty() && iSubscribers == _subscribers.end() )
       {
-        long buyPrice = mpRecord.getDepthAt( i ).getBestBuyPrice();
-        long buyQty = mpRecord.getDepthAt( i ).getTotalBuyQty();
-        long sellPrice = mpRecord.getDepthAt( i ).getBestSellPrice();
-        long sellQty = mpRecord.getDepthAt( i ).getTotalSellQty();
+        continue ;
+      }
 
-        bool buyNotAvail = false;
-        bool sellNotAvail = false;
+      makeBar( bar, securityId, fixBar ) ;
+      for( Subscriptions::const_iterator it = _allSubscriptions.begin() ;
+           it != _allSubscriptions.end() ;
+           ++it )
+      {
+        sendTo( fixBar, *it ) ;
+      }
+
+      if( iSubscribers == _subscribers.end() )
+      {
+        continue ;
+      }
+      for( Subscriptions::const_iterator it = iSubscribers->second.begin() ;
+           it != iSubscribers->second.end() ;
+           ++it )
+      {
+        sendTo( fixBar, *it ) ;
+      }
+    }
+  }
+
+  void MarketDataApplication::makeBar( const Bars::Record &bar,
+                                       const std::string &securityId,
+                                       FIX42::MarketDataIncrementalRefresh &message )
+  {
+    const Instrument &instrument = Instruments::get( securityId ) ;
+
+    time_t start = bar.getStartTime() / 1000 ;
+    tm utc ;
+    gmtime_r( &start, &utc ) ;
+    char startDate[ 16 ] ;
+    char startTime[ 16 ] ;
+    strftime( startDate, sizeof( startDate ), "%Y%m%d", &utc ) ;
+    strftime( startTime, sizeof( startTime ), "%H:%M:%S", &utc ) ;
+    const std::string interval =
+      boost::lexical_cast< std::string >( bar.getInterval() ) ;
+
+    const char types[] = { FIX::MDEntryType_OPENING_PRICE,
+                           FIX::MDEntryType_TRADING_SESSION_HIGH_PRICE,
+                           FIX::MDEntryType_TRADING_SESSION_LOW_PRICE,
+                           FIX::MDEntryType_CLOSING_PRICE,
+                           FIX::MDEntryType_TRADING_SESSION_VWAP_PRICE } ;
+    const long prices[] = { bar.getOpenPrice(),
+                            bar.getHighPrice(),
+                            bar.getLowPrice(),
+                            bar.getClosePrice(),
+                            bar.getWeightedAvgPrice() } ;
+
+    message = FIX42::MarketDataIncrementalRefresh() ;
+    FIX42::MarketDataIncrementalRefresh::NoMDEntries group ;
+    for( size_t i = 0 ; i < sizeof( types ) ; ++i )
+    {
+      group = FIX42::MarketDataIncrementalRefresh::NoMDEntries() ;
+      group.set( FIX::MDUpdateAction( FIX::MDUpdateAction_NEW ) ) ;
+      group.set( FIX::MDEntryType( types[i] ) ) ;
+      group.set( FIX::Symbol( securityId ) ) ;
+      group.set( FIX::SecurityID( securityId ) ) ;
+      group.set( FIX::MDEntryPx( instrument.toDouble( prices[i] ) ) ) ;
+      group.setField( FIX::FIELD::MDEntryDate, startDate ) ;
+      group.setField( FIX::FIELD::MDEntryTime, startTime ) ;
+      group.setField( FIX::FIELD::TradingSessionID, interval ) ;
+      if( types[i] == FIX::MDEntryType_TRADING_SESSION_VWAP_PRICE )
+      {
+        group.set( FIX::MDEntrySize( bar.getVolume() ) ) ;
+      }
+      message.addGroup( group ) ;
+    }
+  }
 
-        if ( buyPrice != 0 && buyQty != 0 )
+  FIX42::MarketDataSnapshotFullRefresh &MarketDataApplication::getSnapshot(
+      SnapshotStripe &stripe,
+      const std::string &securityId,
+      int depth,
+      FIX42::MarketDataSnapshotFullRefresh &scratch )
+  {
+    SnapshotCache::iterator iSnapshot = stripe.snapshots.find( securityId ) ;
+    if( iSnapshot == stripe.snapshots.end() )
+    {
+      // Not published yet: the book is read directly, and a book not
+      // created yet has no orders, so its snapshot is empty.
+      MarketPicture::Record record ;
+      if( _market != 0 )
+      {
+        _market->getMarketPictureRecord( securityId, record ) ;
+      }
+      makeSnapshot( record, securityId, depth, scratch ) ;
+      return scratch ;
+    }
+
+    CachedSnapshot &cached = iSnapshot->second ;
+    if( depth != MaxDepth )
+    {
+      makeSnapshot( cached.record, securityId, depth, scratch ) ;
+      return scratch ;
+    }
+
+    if( !cached.encoded )
+    {
+      makeSnapshot( cached.record, securityId, MaxDepth, cached.message ) ;
+      cached.encoded = true ;
+    }
+    return cached.message ;
+  }
+
+  void MarketDataApplication::sendTo( FIX::Message &message,
+                                      const Subscription &subscription )
+  {
+    if( subscription.mdReqId.empty() )
+    {
+      message.removeField( FIX::FIELD::MDReqID ) ;
+    }
+    else
+    {
+      message.setField( FIX::MDReqID( subscription.mdReqId ) ) ;
+    }
+
+    try
+    {
+      FIX::Session::sendToTarget ( message, subscription.sessionId ) ;
+    }
+    catch ( FIX::SessionNotFound &e )
+    {
+      std::cout << "Error on Sending market data "
+                << e.what() << std::endl ;
+    }
+  }
+
+  void MarketDataApplication::queue( const Stream &stream )
+  {
+    boost::mutex::scoped_lock lock( _mutexStreams ) ;
+    _streams.push_back( stream ) ;
+    _streamsQueued.notify_one() ;
+  }
+
+  bool MarketDataApplication::isWanted( const Stream &stream )
+  {
+    if( !stream.subscribed )
+    {
+      return true ;
+    }
+
+    if( stream.securityIds.empty() )
+    {
+      for( Subscriptions::const_iterator iSubscription = _allSubscriptions.begin() ;
+           iSubscription != _allSubscriptions.end() ;
+           ++iSubscription )
+      {
+        if( iSubscription->sessionId == stream.sessionId )
         {
-          group.set( FIX::MDEntryType( FIX::MDEntryType_BID ) );
-          group.set( FIX::MDEntryPx( buyPrice ) );
-          group.set( FIX::MDEntrySize( buyQty ) );
-          mdSnapshot.addGroup( group );
+          return true ;
         }
-        else
-          buyNotAvail = true;
+      }
+      return false ;
+    }
 
-        if ( sellPrice != 0 && sellQty != 0 )
+    RequestsBySessionMap::const_iterator iSession =
+      _requests.find( stream.sessionId ) ;
+    return iSession != _requests.end()
+      && iSession->second.find( stream.mdReqId ) != iSession->second.end() ;
+  }
+
+  void MarketDataApplication::sendStreams()
+  {
+    FIX42::MarketDataSnapshotFullRefresh scratch ;
+    Subscription subscription ;
+    while( true )
+    {
+      Stream stream ;
+      {
+        boost::mutex::scoped_lock lock( _mutexStreams ) ;
+        while( _streams.empty() )
         {
-          group.set( FIX::MDEntryType( FIX::MDEntryType_OFFER ) );
-          group.set( FIX::MDEntryPx( sellPrice ) );
-          group.set( FIX::MDEntrySize( sellQty ) );
-          mdSnapshot.addGroup( group );
+          _streamsQueued.wait( lock ) ;
         }
-        else
-          sellNotAvail = true;
-
-        if ( buyNotAvail && sellNotAvail )
-          break;
+        stream = _streams.front() ;
+        _streams.pop_front() ;
       }
 
-      try {
-        boost::mutex::scoped_lock lock( _mutexSetSessions );
-        for ( std::set<FIX::SessionID>::iterator it = _setSessions.begin();
-              it != _setSessions.end();
-              it++ )
+      subscription.sessionId = stream.sessionId ;
+      subscription.mdReqId = stream.mdReqId ;
+      subscription.depth = stream.depth ;
+
+      std::vector< std::string > securityIds( stream.securityIds ) ;
+      for( int i = 0 ; stream.securityIds.empty() && i < SnapshotStripes ; ++i )
+      {
+        SnapshotStripe &stripe = _snapshotStripes[i] ;
+        boost::mutex::scoped_lock lock( stripe.mutex ) ;
+        for( SnapshotCache::const_iterator iSnapshot = stripe.snapshots.begin() ;
+             iSnapshot != stripe.snapshots.end() ;
+             ++iSnapshot )
         {
-          FIX::SessionID session = *it;
-          FIX::Session::sendToTarget ( mdSnapshot, session ) ;
+          securityIds.push_back( iSnapshot->first ) ;
         }
       }
-      catch (boost::lock_error& e)
+
+      // The locks are taken for each snapshot, so that the publishers go
+      // on between them.
+      for( size_t i = 0 ; i < securityIds.size() ; ++i )
       {
-        std::cout << "lock error: " << e.what() << std::endl;
+        boost::shared_lock< boost::shared_mutex > lock( _mutexSubscriptions ) ;
+        if( !isWanted( stream ) )
+        {
+          break ;
+        }
+        SnapshotStripe &stripe = getSnapshotStripe( securityIds[i] ) ;
+        boost::mutex::scoped_lock stripeLock( stripe.mutex ) ;
+        sendTo( getSnapshot( stripe, securityIds[i], stream.depth,
+                                   scratch ),
+                      subscription ) ;
       }
     }
   }
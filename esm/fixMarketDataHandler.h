@@ -1,24 +1,59 @@
 #ifndef UT_ESM_FIX_MARKET_DATA_HANDLER_H
 #define UT_ESM_FIX_MARKET_DATA_HANDLER_H
 
+#include "../common/fixCapture.h"
+#include "marketDataPublisher.h"
 #include "order.h"
 #include <quickfix/Application.h>
 #include <quickfix/MessageCracker.h>
 #include <quickfix/Session.h>
+#include <quickfix/fix42/MarketDataIncrementalRefresh.h>
+#include <quickfix/fix42/MarketDataRequest.h>
+#include <quickfix/fix42/MarketDataSnapshotFullRefresh.h>
 
+#include <deque>
+#include <map>
+#include <vector>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_map.hpp>
 
 namespace ESM
 {
+  class Market ;
+
   /**
    * \class MarketDataApplication
    *
    * \brief Sends market data for the matching engine in FIX Format
    *
+   * Sessions subscribe to securities with MarketDataRequest, at a depth of
+   * their choice, and get a snapshot of each of them at once, then again
+   * whenever the book changes. The subscribers are indexed by security, so
+   * a book that changes costs only its own subscribers.
+   *
+   * The last snapshot of every book is cached, encoded at full depth once
+   * per change when first needed. The first snapshots of a subscription,
+   * or of a session subscribing to everything at logon, are streamed from
+   * the cache by a thread of their own, so that sessions joining together
+   * at the open do not hold up the publisher.
+   *
+   * Bars go to the same subscribers as the snapshots of their security, in
+   * a MarketDataIncrementalRefresh: opening, high, low, closing & VWAP
+   * entries at the start of the bar, its volume on the VWAP and its
+   * interval in seconds as TradingSessionID.
+   *
+   * Several market picture threads may send at once. The cache is split in
+   * stripes by security, each locked while one of its securities is
+   * encoded and sent, so that the snapshots of a security go out in order
+   * while those of others are encoded in parallel.
+   *
    */
   class MarketDataApplication :
     public FIX::Application,
-    public FIX::MessageCracker
+    public FIX::MessageCracker,
+    public MarketDataPublisher
   {
     public :
       /**
@@ -28,10 +63,8 @@ namespace ESM
        * @param address
        * @param port
        */
-      MarketDataApplication()
-        : _setSessions(),
-          _mutexSetSessions()
-      { }
+      MarketDataApplication() ;
+
       void onCreate(const FIX::SessionID&) {}
       void onLogon(const FIX::SessionID& id);
       void onLogout(const FIX::SessionID& id);
@@ -52,15 +85,200 @@ namespace ESM
                FIX::UnsupportedMessageType );
 
       /**
-       * \brief send MarketDataSnapshot to all the connected sessions
+       * @brief Subscribe to securities, unsubscribe with the MDReqID of the
+       * subscription, or ask for a single snapshot. A MarketDepth of 0 is
+       * the full depth of 5 levels.
+       */
+      void onMessage( const FIX42::MarketDataRequest&,
+                      const FIX::SessionID& );
+
+      /**
+       * \brief send MarketDataSnapshot to the subscribers of each security
        *
         * @param message
        */
       void send( const MarketPicture &message );
 
+      /**
+       * \brief send the bars to the subscribers of each security
+       *
+       * @param message
+       */
+      void sendBars( const Bars &message ) ;
+
+      /**
+       * @brief The market the first snapshot of a book not yet published is
+       * read from. Without one, subscribers wait for its first snapshot.
+       */
+      void setMarket( Market *market )
+      {
+        _market = market ;
+      }
+
+      /**
+       * @brief Capture the messages of every session. None are captured by
+       * default.
+       */
+      void setCapture( UT::FixCapture *capture )
+      {
+        _capture = capture ;
+      }
+
+      /**
+       * @brief Subscribe every session to every security at full depth
+       * when it logs on, without MarketDataRequest. Off by default.
+       */
+      void setSubscribeOnLogon( bool subscribeOnLogon )
+      {
+        _subscribeOnLogon = subscribeOnLogon ;
+      }
+
     private :
-      std::set<FIX::SessionID> _setSessions;
-      boost::mutex _mutexSetSessions;
+      enum { MaxDepth = 5 } ;
+
+      struct Subscription
+      {
+        FIX::SessionID sessionId ;
+        std::string mdReqId ;
+        int depth ;
+      };
+
+      /**
+       * The subscriptions to each security.
+       */
+      typedef std::vector< Subscription > Subscriptions ;
+      typedef boost::unordered_map< std::string, Subscriptions >
+        SubscribersMap ;
+      SubscribersMap _subscribers ;
+
+      /**
+       * The securities of each subscription of a session, by MDReqID, to
+       * unsubscribe or to drop them all at logout.
+       */
+      typedef std::map< std::string, std::vector< std::string > > RequestsMap ;
+      typedef std::map< FIX::SessionID, RequestsMap > RequestsBySessionMap ;
+      RequestsBySessionMap _requests ;
+
+      /**
+       * The sessions subscribed to every security at logon.
+       */
+      Subscriptions _allSubscriptions ;
+
+      /**
+       * The last snapshot of a book and, once encoded, its message.
+       */
+      struct CachedSnapshot
+      {
+        MarketPicture::Record record ;
+        bool encoded ;
+        FIX42::MarketDataSnapshotFullRefresh message ;
+      };
+      typedef boost::unordered_map< std::string, CachedSnapshot >
+        SnapshotCache ;
+
+      /**
+       * A share of the cache, whose mutex is held while sending one of its
+       * snapshots, so that a snapshot from the cache never follows a later
+       * one.
+       */
+      struct SnapshotStripe
+      {
+        boost::mutex mutex ;
+        SnapshotCache snapshots ;
+      };
+      enum { SnapshotStripes = 64 } ;
+      SnapshotStripe _snapshotStripes[ SnapshotStripes ] ;
+
+      SnapshotStripe &getSnapshotStripe( const std::string &securityId ) ;
+
+      /**
+       * Protects the subscriptions, shared while sending and exclusive
+       * while they change. Taken before the mutex of a stripe.
+       */
+      boost::shared_mutex _mutexSubscriptions ;
+
+      /**
+       * The first snapshots owed to a session. No securities is all of them.
+       */
+      struct Stream
+      {
+        FIX::SessionID sessionId ;
+        std::string mdReqId ;
+        int depth ;
+        bool subscribed ;
+        std::vector< std::string > securityIds ;
+      };
+      std::deque< Stream > _streams ;
+      boost::mutex _mutexStreams ;
+      boost::condition_variable _streamsQueued ;
+
+      Market *_market ;
+      UT::FixCapture *_capture ;
+      bool _subscribeOnLogon ;
+
+      /**
+       * @brief The loop sending the streams queued.
+       */
+      void sendStreams() ;
+
+      void queue( const Stream &stream ) ;
+
+      /**
+       * @brief Whether the stream is still wanted, i.e. the session did not
+       *        unsubscribe or log out meanwhile.
+       *        The caller must share _mutexSubscriptions.
+       */
+      bool isWanted( const Stream &stream ) ;
+
+      /**
+       * @brief The snapshot of a security at a depth, the cached message at
+       *        full depth or else built in the scratch message.
+       *        The caller must hold the mutex of the stripe.
+       */
+      FIX42::MarketDataSnapshotFullRefresh &getSnapshot(
+          SnapshotStripe &stripe,
+          const std::string &securityId,
+          int depth,
+          FIX42::MarketDataSnapshotFullRefresh &scratch ) ;
+
+      /**
+       * @brief Send a message to a subscriber, with its MDReqID.
+       */
+      void sendTo( FIX::Message &message,
+                   const Subscription &subscription ) ;
+
+      /**
+       * @brief Remove the subscription of a session to a security.
+       *        The caller must hold _mutexSubscriptions.
+       */
+      void unsubscribe( const std::string &securityId,
+                        const FIX::SessionID &sessionId,
+                        const std::string &mdReqId ) ;
+
+      /**
+       * @brief Fill a snapshot with a number of price levels of a record.
+       */
+      void makeSnapshot( const MarketPicture::Record &record,
+                         const std::string &securityId,
+                         int depth,
+                         FIX42::MarketDataSnapshotFullRefresh &snapshot ) ;
+
+      /**
+       * @brief Fill a MarketDataIncrementalRefresh with a bar.
+       */
+      void makeBar( const Bars::Record &bar,
+                    const std::string &securityId,
+                    FIX42::MarketDataIncrementalRefresh &message ) ;
+
+      /**
+       * @brief Send a MarketDataRequestReject. The caller must not hold
+       *        _mutexSubscriptions, so that a slow session does not hold up
+       *        the market data.
+       */
+      void reject( const std::string &mdReqId,
+                   char reason,
+                   const std::string &text,
+                   const FIX::SessionID &sessionId ) ;
   };
 
 }
@@ -2,6 +2,7 @@
 #define ESM_FIX_TO_ORDER_H
 
 #include <quickfix/Fields.h>
+#include "../common/uniqueOrderId.h"
 #include "structures.h"
 #include "exceptions.h"
 
@@ -53,6 +54,38 @@ namespace ESM
         throw OrderTypeNotHandled( "" ) ;
       }
 
+      /**
+       * @brief Convert the order status from native to fix.
+       *
+       * @param order status to be converted.
+       */
+      static FIX::OrdStatus convert( OrderStatus orderStatus )
+      {
+        switch( orderStatus )
+        {
+          case OrderStatus_NEW :
+            return FIX::OrdStatus_NEW ;
+          case OrderStatus_PARTIALLY_FILLED :
+            return FIX::OrdStatus_PARTIALLY_FILLED ;
+          case OrderStatus_FILLED :
+            return FIX::OrdStatus_FILLED ;
+          case OrderStatus_CANCELED :
+            return FIX::OrdStatus_CANCELED ;
+          case OrderStatus_REJECTED :
+            return FIX::OrdStatus_REJECTED ;
+        }
+        throw OrderError( "Unknown Order Status" ) ;
+      }
+
+      /**
+       * @brief Format the order id for the client, the only place it is a
+       * string.
+       */
+      static FIX::OrderID convert( UT::OrderId orderId )
+      {
+        return FIX::OrderID( UT::UniqueOrderId::toString( orderId ) ) ;
+      }
+
   };
 
   /**
@@ -120,9 +153,23 @@ namespace ESM
             return TimeInForce_DAY ;
           case FIX::TimeInForce_IMMEDIATE_OR_CANCEL :
             return TimeInForce_IOC ;
+          case FIX::TimeInForce_GOOD_TILL_CANCEL :
+            return TimeInForce_GTC ;
+          case FIX::TimeInForce_GOOD_TILL_DATE :
+            return TimeInForce_GTD ;
+          case FIX::TimeInForce_FILL_OR_KILL :
+            return TimeInForce_FOK ;
         }
         throw TimeInForceNotHandled( timeInForce.getString() ) ;
       }
+
+      /**
+       * @return The order id, 0 if it is not one of ours.
+       */
+      static UT::OrderId convert( const FIX::OrderID &orderId )
+      {
+        return UT::UniqueOrderId::fromString( orderId ) ;
+      }
   };
 
 }
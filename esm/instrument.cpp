@@ -0,0 +1,255 @@
+#include "instrument.h"
+#include "exceptions.h"
+#include "../common/exceptions.h"
+
+#include <math.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace ESM
+{
+  namespace
+  {
+    const char BettingOddsLadder[] =
+      "1.01:0.01, 2:0.02, 3:0.05, 4:0.1, 6:0.2, 10:0.5, "
+      "20:1, 30:2, 50:5, 100:10" ;
+    const double BettingOddsMaxPrice = 1000 ;
+
+    /**
+     * Scale a decimal price, failing if it does not fit the scale.
+     */
+    bool scale( double price, long priceScale, long &result )
+    {
+      double scaled = price * priceScale ;
+      result = static_cast< long >( floor( scaled + 0.5 ) ) ;
+      return fabs( scaled - result ) < 1e-6 ;
+    }
+
+    Allocation readAllocation( const std::string &securityId,
+                               const boost::property_tree::ptree &section )
+    {
+      Allocation allocation ;
+      std::string type = section.get< std::string >( "allocation", "fifo" ) ;
+      if( type == "fifo" )
+      {
+        allocation.type = AllocationType_FIFO ;
+      }
+      else if( type == "pro_rata" )
+      {
+        allocation.type = AllocationType_PRO_RATA ;
+        allocation.minQty = section.get< long >( "min_allocation_qty", 0 ) ;
+      }
+      else if( type == "lmm" )
+      {
+        allocation.type = AllocationType_LMM ;
+        allocation.lmmSenderId = section.get< std::string >( "lmm_sender", "" ) ;
+        allocation.lmmShare = section.get< double >( "lmm_share", 0 ) ;
+        if( allocation.lmmSenderId.empty()
+            || allocation.lmmShare < 0 || allocation.lmmShare > 1 )
+        {
+          throw UT::ConfigError( "lmm allocation needs lmm_sender and an "
+                                 "lmm_share from 0 to 1 for " + securityId ) ;
+        }
+      }
+      else
+      {
+        throw UT::ConfigError( "Unknown allocation " + type + " for " + securityId
+                               + ", use fifo, pro_rata or lmm" ) ;
+      }
+      return allocation ;
+    }
+
+    long scaleOrThrow( const std::string &value, long priceScale )
+    {
+      long result ;
+      if( !scale( boost::lexical_cast< double >( value ), priceScale, result ) )
+      {
+        throw UT::ConfigError( "Price " + value + " does not fit price scale "
+                               + boost::lexical_cast< std::string >( priceScale ) ) ;
+      }
+      return result ;
+    }
+  }
+
+  TickTable::TickTable()
+    : _maxPrice( 0 ),
+      _maxTick( -1 )
+  {
+    addTier( 0, 1 ) ;
+  }
+
+  TickTable::TickTable( const std::string &tiers,
+                        long priceScale,
+                        double maxPrice )
+    : _maxPrice( 0 ),
+      _maxTick( -1 )
+  {
+    std::string ladder( tiers ) ;
+    if( ladder == "betting" )
+    {
+      ladder = BettingOddsLadder ;
+      if( maxPrice == 0 )
+      {
+        maxPrice = BettingOddsMaxPrice ;
+      }
+    }
+
+    std::vector< std::string > entries ;
+    boost::split( entries, ladder, boost::is_any_of( "," ) ) ;
+
+    try
+    {
+      for( std::vector< std::string >::iterator iEntry = entries.begin() ;
+           iEntry != entries.end() ;
+           ++iEntry )
+      {
+        std::vector< std::string > tier ;
+        boost::split( tier, *iEntry, boost::is_any_of( ":" ) ) ;
+        if( tier.size() != 2 )
+        {
+          throw UT::ConfigError( "Tick table tier must be price:tick, not "
+                                 + *iEntry ) ;
+        }
+        boost::trim( tier[0] ) ;
+        boost::trim( tier[1] ) ;
+        addTier( scaleOrThrow( tier[0], priceScale ),
+                 scaleOrThrow( tier[1], priceScale ) ) ;
+      }
+    }
+    catch( boost::bad_lexical_cast &e )
+    {
+      throw UT::ConfigError( "Tick table is not a list of prices : " + tiers ) ;
+    }
+
+    if( maxPrice > 0 )
+    {
+      setMaxPrice( scaleOrThrow( boost::lexical_cast< std::string >( maxPrice ),
+                                 priceScale ) ) ;
+    }
+  }
+
+  void TickTable::addTier( long fromPrice, long tickSize )
+  {
+    if( tickSize <= 0 || fromPrice < 0 )
+    {
+      throw UT::ConfigError( "Tick size must be > 0 and prices >= 0" ) ;
+    }
+
+    Tier tier ;
+    tier.fromPrice = fromPrice ;
+    tier.tickSize = tickSize ;
+    tier.fromTick = 0 ;
+
+    if( !_tiers.empty() )
+    {
+      const Tier &previous = _tiers.back() ;
+      long width = fromPrice - previous.fromPrice ;
+      if( width <= 0 || width % previous.tickSize != 0 )
+      {
+        throw UT::ConfigError( "Tick table tiers must be ascending and start "
+                               "on a tick of the previous tier" ) ;
+      }
+      tier.fromTick = previous.fromTick + width / previous.tickSize ;
+    }
+
+    _tiers.push_back( tier ) ;
+  }
+
+  void TickTable::setMaxPrice( long maxPrice )
+  {
+    _maxTick = toTick( maxPrice ) ;
+    _maxPrice = maxPrice ;
+  }
+
+  long TickTable::toTick( long price ) const
+  {
+    if( price < _tiers.front().fromPrice
+        || ( _maxTick >= 0 && price > _maxPrice ) )
+    {
+      throw InvalidPrice( "Price outside of the tick table" ) ;
+    }
+
+    // Tables have a handful of tiers, most orders are in the first ones.
+    std::vector< Tier >::const_iterator iTier = _tiers.begin() ;
+    while( iTier + 1 != _tiers.end() && ( iTier + 1 )->fromPrice <= price )
+    {
+      ++iTier ;
+    }
+
+    long offset = price - iTier->fromPrice ;
+    if( offset % iTier->tickSize != 0 )
+    {
+      throw InvalidPrice( "Price is not a multiple of the tick size" ) ;
+    }
+    return iTier->fromTick + offset / iTier->tickSize ;
+  }
+
+  long TickTable::toPrice( long tick ) const
+  {
+    std::vector< Tier >::const_iterator iTier = _tiers.begin() ;
+    while( iTier + 1 != _tiers.end() && ( iTier + 1 )->fromTick <= tick )
+    {
+      ++iTier ;
+    }
+    return iTier->fromPrice + ( tick - iTier->fromTick ) * iTier->tickSize ;
+  }
+
+  long Instrument::toPrice( double price ) const
+  {
+    long result ;
+    if( !scale( price, _priceScale, result ) )
+    {
+      throw InvalidPrice( "Price has more decimals than allowed" ) ;
+    }
+    return result ;
+  }
+
+  Instruments::InstrumentsMap Instruments::_instruments ;
+  const Instrument Instruments::_default ;
+
+  void Instruments::load( const std::string &fileName )
+  {
+    boost::property_tree::ptree instruments ;
+    try
+    {
+      boost::property_tree::ini_parser::read_ini( fileName, instruments ) ;
+    }
+    catch( boost::property_tree::ini_parser_error &e )
+    {
+      throw UT::ConfigError( e.what() ) ;
+    }
+
+    for( boost::property_tree::ptree::const_iterator iSection = instruments.begin() ;
+         iSection != instruments.end() ;
+         ++iSection )
+    {
+      const boost::property_tree::ptree &section = iSection->second ;
+
+      long priceScale = section.get< long >( "price_scale", 1 ) ;
+      if( priceScale <= 0 )
+      {
+        throw UT::ConfigError( "price_scale must be > 0 for " + iSection->first ) ;
+      }
+
+      std::string tiers = section.get< std::string >( "tick_table", "" ) ;
+      double maxPrice = section.get< double >( "max_price", 0 ) ;
+
+      _instruments[ iSection->first ] = Instrument( priceScale,
+          tiers.empty() ? TickTable()
+                        : TickTable( tiers, priceScale, maxPrice ),
+          readAllocation( iSection->first, section ) ) ;
+    }
+  }
+
+  const Instrument &Instruments::get( const std::string &securityId )
+  {
+    InstrumentsMap::const_iterator iInstrument = _instruments.find( securityId ) ;
+    if( iInstrument == _instruments.end() )
+    {
+      return _default ;
+    }
+    return iInstrument->second ;
+  }
+}
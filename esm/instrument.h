@@ -0,0 +1,210 @@
+#ifndef ESM_INSTRUMENT_H
+#define ESM_INSTRUMENT_H
+
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+namespace ESM
+{
+  /**
+   * \class TickTable
+   *
+   * The prices at which an instrument may trade, and the position (tick) of
+   * each of them on the price ladder.
+   *
+   * The table is made of tiers. A tier starts at a price and has its own
+   * tick size, up to the start of the next tier, so non-linear ladders like
+   * betting odds (1.01, 1.02 .. 2.00, 2.02 .. 3.00, 3.05 ..) are a list of
+   * tiers. Prices are fixed-point, in units of the instrument's price scale.
+   *
+   * Tick 0 is the first price of the first tier. Ticks are increasing with
+   * price, so an order book can use them as keys in place of prices.
+   *
+   */
+  class TickTable
+  {
+    public :
+      /**
+       * @brief A table where any price >= 0 is valid.
+       */
+      TickTable() ;
+
+      /**
+       * @brief Build a table from its tiers, e.g. "1.01:0.01, 2:0.02"
+       * for a tier starting at 1.01 with a tick of 0.01, then a tier
+       * starting at 2 with a tick of 0.02. "betting" gives the usual
+       * betting odds ladder from 1.01 to 1000.
+       *
+       * @param The tiers, with prices not yet scaled.
+       * @param The price scale of the instrument.
+       * @param The highest valid price, not yet scaled. 0 for no limit.
+       */
+      TickTable( const std::string &tiers, long priceScale, double maxPrice ) ;
+
+      /**
+       * @brief Get the tick of a price.
+       *
+       * @return The tick. Throws InvalidPrice if the price is not on the
+       *         ladder.
+       */
+      long toTick( long price ) const ;
+
+      /**
+       * @brief Get the price of a tick.
+       */
+      long toPrice( long tick ) const ;
+
+      /**
+       * @brief The highest tick, -1 if the ladder has no upper limit.
+       */
+      long getMaxTick() const { return _maxTick ; }
+
+    private :
+      struct Tier
+      {
+        long fromPrice ;
+        long tickSize ;
+        long fromTick ;
+      };
+      std::vector< Tier > _tiers ;
+
+      long _maxPrice ;
+      long _maxTick ;
+
+      void addTier( long fromPrice, long tickSize ) ;
+      void setMaxPrice( long maxPrice ) ;
+  };
+
+  enum AllocationType
+  {
+    AllocationType_FIFO,
+    AllocationType_PRO_RATA,
+    AllocationType_LMM
+  };
+
+  /**
+   * How a fill is shared between the orders of a price level.
+   */
+  struct Allocation
+  {
+    Allocation()
+      : type( AllocationType_FIFO ),
+        minQty( 0 ),
+        lmmShare( 0 )
+    {}
+
+    AllocationType type ;
+
+    /**
+     * Pro-rata: a share below this quantity is not given, the rest of the
+     * fill goes by time priority.
+     */
+    long minQty ;
+
+    /**
+     * LMM: the sender of the lead market maker and the part of a fill,
+     * after the top order, it gets ahead of time priority.
+     */
+    std::string lmmSenderId ;
+    double lmmShare ;
+  };
+
+  /**
+   * \class Instrument
+   *
+   * How the prices of a security are written. Prices reach us as decimals
+   * on FIX and are converted once, at the gateway, to a fixed-point price
+   * (price * price scale) and its tick. Replies convert them back.
+   *
+   */
+  class Instrument
+  {
+    public :
+      Instrument() : _priceScale( 1 ) {}
+
+      Instrument( long priceScale,
+                  const TickTable &tickTable,
+                  const Allocation &allocation = Allocation() )
+        : _priceScale( priceScale ),
+          _tickTable( tickTable ),
+          _allocation( allocation )
+      {}
+
+      /**
+       * @brief Convert a decimal price to fixed-point.
+       *
+       * @return The price. Throws InvalidPrice if it has more decimals than
+       *         the price scale allows.
+       */
+      long toPrice( double price ) const ;
+
+      /**
+       * @brief Convert a fixed-point price to decimal.
+       */
+      double toDouble( long price ) const
+      {
+        return static_cast< double >( price ) / _priceScale ;
+      }
+
+      long toTick( long price ) const { return _tickTable.toTick( price ) ; }
+      long tickToPrice( long tick ) const { return _tickTable.toPrice( tick ) ; }
+
+      long getPriceScale() const { return _priceScale ; }
+      const TickTable &getTickTable() const { return _tickTable ; }
+      const Allocation &getAllocation() const { return _allocation ; }
+
+    private :
+      long _priceScale ;
+      TickTable _tickTable ;
+      Allocation _allocation ;
+  };
+
+  /**
+   * \class Instruments
+   *
+   * The instruments read from the instruments file at start up. Securities
+   * not in the file trade in whole numbers with a tick of 1.
+   *
+   * The file is loaded before any session starts and not changed after, so
+   * lookups take no lock.
+   *
+   */
+  class Instruments
+  {
+    public :
+      /**
+       * @brief Load the instruments file. Each section is a security id:
+       *
+       *   [1001]
+       *   price_scale=100
+       *   tick_table=0:0.05
+       *
+       *   [2001]
+       *   price_scale=100
+       *   tick_table=betting
+       *
+       * max_price is optional and limits the ladder.
+       *
+       * allocation is fifo (default), pro_rata with min_allocation_qty, or
+       * lmm with lmm_sender and lmm_share (0 to 1).
+       *
+       * @param The name of the file.
+       */
+      static void load( const std::string &fileName ) ;
+
+      /**
+       * @brief Get an instrument.
+       *
+       * @param The security id.
+       */
+      static const Instrument &get( const std::string &securityId ) ;
+
+    private :
+      typedef boost::unordered_map< std::string, Instrument > InstrumentsMap ;
+      static InstrumentsMap _instruments ;
+      static const Instrument _default ;
+  };
+}
+
+#endif // ESM_INSTRUMENT_H
@@ -0,0 +1,926 @@
+#include "../config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <quickfix/Application.h>
+#include <quickfix/FileStore.h>
+#include <quickfix/MessageCracker.h>
+#include <quickfix/SessionSettings.h>
+#include <quickfix/SocketInitiator.h>
+#include <quickfix/fix42/ExecutionReport.h>
+#include <quickfix/fix42/NewOrderSingle.h>
+#include <quickfix/fix42/OrderCancelReject.h>
+#include <quickfix/fix42/OrderCancelReplaceRequest.h>
+#include <quickfix/fix42/OrderCancelRequest.h>
+
+#include "../common/binaryLog.h"
+#include "../common/latency.h"
+#include "executionSink.h"
+#include "market.h"
+
+/**
+ * Send synthetic order flow to the engine, for soak & load tests, and
+ * measure how long each order waits for its acknowledgement.
+ *
+ * The flow comes from N sessions, either FIX initiators connecting to
+ * uMatch, or senders of an in-process market with no session layer at all.
+ * Symbols are picked by popularity, following Zipf's law. The mid price of
+ * each symbol walks a tick at a time; orders rest a few ticks away from it,
+ * some cross it. A share of the messages cancel or replace a resting order
+ * of their session. Messages arrive as a Poisson process at the target
+ * rate, or in bursts with Poisson gaps between them.
+ *
+ * The latency of an acknowledgement is counted from the time its message
+ * was due, not from when it was sent, so that a generator falling behind
+ * its schedule shows up as latency rather than hiding it.
+ *
+ * FIX sessions are named orderGenerator..., so that uMatch does not dump
+ * their messages. In process, the rate is bound by the market and the
+ * orders it is given; through FIX, by the sessions. The rate reached is
+ * printed next to the target.
+ */
+namespace
+{
+  const long MidPrice = 10000 ;
+
+  /**
+   * Live orders kept per session. Beyond, a new order takes the place of a
+   * random one, which then is never cancelled nor replaced.
+   */
+  const size_t MaxLiveOrders = 100000 ;
+
+  struct FlowSettings
+  {
+    long symbols ;
+    long firstSecurityId ;
+    double zipf ;          // exponent of the popularity of the symbols
+    double cancelRatio ;   // of the messages
+    double replaceRatio ;  // of the messages
+    double drift ;         // chance that the mid moves a tick, per order
+    long spread ;          // orders rest up to so many ticks from the mid
+    double crossRatio ;    // of the new orders, priced through the mid
+    long maxQty ;
+    double rate ;          // messages per second, over all the sessions
+    long burst ;           // messages per burst, 1 for Poisson arrivals
+  };
+
+  enum Action
+  {
+    Action_NEW,
+    Action_CANCEL,
+    Action_REPLACE
+  };
+
+  /**
+   * An order of the generator, which may still rest on the book.
+   */
+  struct LiveOrder
+  {
+    std::string clientOrderId ;
+    long symbol ;
+    ESM::Side side ;
+    long qty ;
+    ESM::OrderPtr order ;  // in process only
+  };
+
+  /**
+   * \class OrderFlow
+   *
+   * The random side of the flow: what is sent, where, at what price and
+   * when. The same seed gives the same flow.
+   *
+   */
+  class OrderFlow
+  {
+    public :
+      OrderFlow( const FlowSettings &settings, unsigned seed )
+        : _settings( settings ),
+          _generator( seed ),
+          _mids( settings.symbols, MidPrice ),
+          _burstLeft( 0 )
+      {
+        double total = 0 ;
+        for( long symbol = 0 ; symbol < settings.symbols ; ++symbol )
+        {
+          total += 1 / pow( symbol + 1.0, settings.zipf ) ;
+          _popularity.push_back( total ) ;
+        }
+        for( long symbol = 0 ; symbol < settings.symbols ; ++symbol )
+        {
+          _popularity[ symbol ] /= total ;
+
+          std::ostringstream securityId ;
+          securityId << settings.firstSecurityId + symbol ;
+          _securityIds.push_back( securityId.str() ) ;
+        }
+      }
+
+      Action nextAction( bool hasLiveOrders )
+      {
+        double draw = uniform() ;
+        if( !hasLiveOrders || draw >= _settings.cancelRatio + _settings.replaceRatio )
+        {
+          return Action_NEW ;
+        }
+        return draw < _settings.cancelRatio ? Action_CANCEL : Action_REPLACE ;
+      }
+
+      long nextSymbol()
+      {
+        std::vector< double >::const_iterator iSymbol =
+          std::lower_bound( _popularity.begin(), _popularity.end(), uniform() ) ;
+        if( iSymbol == _popularity.end() )
+        {
+          --iSymbol ;
+        }
+        return iSymbol - _popularity.begin() ;
+      }
+
+      ESM::Side nextSide()
+      {
+        return uniform() < 0.5 ? ESM::Side_BUY : ESM::Side_SELL ;
+      }
+
+      /**
+       * @brief Move the mid of the symbol, maybe, and price an order
+       * around it.
+       */
+      long nextPrice( long symbol, ESM::Side side )
+      {
+        long &mid = _mids[ symbol ] ;
+        if( uniform() < _settings.drift )
+        {
+          mid += uniform() < 0.5 ? -1 : 1 ;
+          mid = std::max( mid, _settings.spread + 1 ) ;
+        }
+
+        long ticks = 1 + pick( _settings.spread ) ;
+        bool crosses = uniform() < _settings.crossRatio ;
+        return ( side == ESM::Side_BUY ) == crosses ? mid + ticks : mid - ticks ;
+      }
+
+      long nextQty()
+      {
+        return 1 + pick( _settings.maxQty ) ;
+      }
+
+      /**
+       * @brief The time from this message to the next, in nanoseconds.
+       */
+      long long nextGap()
+      {
+        if( _burstLeft > 0 )
+        {
+          --_burstLeft ;
+          return 0 ;
+        }
+        _burstLeft = _settings.burst - 1 ;
+        double mean = _settings.burst / _settings.rate ;
+        return static_cast< long long >( -log( uniform() ) * mean * 1e9 ) ;
+      }
+
+      /**
+       * @return A random index below size.
+       */
+      long pick( size_t size )
+      {
+        return static_cast< long >( uniform() * size ) % size ;
+      }
+
+      const std::string &getSecurityId( long symbol ) const
+      {
+        return _securityIds[ symbol ] ;
+      }
+
+    private :
+      FlowSettings _settings ;
+      boost::mt19937 _generator ;
+      std::vector< double > _popularity ;  // cumulative, by symbol
+      std::vector< std::string > _securityIds ;
+      std::vector< long > _mids ;
+      long _burstLeft ;
+
+      /**
+       * @return A draw in ( 0, 1 ).
+       */
+      double uniform()
+      {
+        return ( _generator() + 0.5 ) / 4294967296.0 ;
+      }
+  };
+
+  /**
+   * \class LoadGenerator
+   *
+   * Paces the flow & keeps the live orders of every session. The sessions
+   * themselves, and how acknowledgements come back, are up to the
+   * subclass.
+   *
+   */
+  class LoadGenerator
+  {
+    public :
+      LoadGenerator( const FlowSettings &settings, unsigned seed )
+        : _flow( settings, seed ),
+          _nextClientOrderId( 0 ),
+          _news( 0 ),
+          _cancels( 0 ),
+          _replaces( 0 ),
+          _elapsed( 0 )
+      {
+      }
+
+      virtual ~LoadGenerator() {}
+
+      /**
+       * @brief Send the flow for a while, round robin over the sessions.
+       *
+       * @param The number of sessions.
+       * @param The duration in seconds.
+       */
+      void run( size_t sessions, double seconds )
+      {
+        _liveOrders.resize( sessions ) ;
+
+        long long start = UT::Latency::now() ;
+        long long end = start + static_cast< long long >( seconds * 1e9 ) ;
+        long long due = start ;
+        // Behind schedule, the flow still ends on time.
+        for( size_t message = 0 ;
+             due < end && UT::Latency::now() < end ;
+             ++message )
+        {
+          waitUntil( due ) ;
+          send( message % sessions, due ) ;
+          due += _flow.nextGap() ;
+        }
+        _elapsed = UT::Latency::now() - start ;
+      }
+
+      long getSent() const
+      {
+        return _news + _cancels + _replaces ;
+      }
+
+      void print( std::ostream &out, double rate ) const
+      {
+        long messages = getSent() ;
+        out << "Sent " << messages << " messages, " << _news << " new, "
+            << _cancels << " cancels, " << _replaces << " replaces in "
+            << _elapsed / 1000000 << " ms : "
+            << ( _elapsed > 0 ? messages * 1000000000LL / _elapsed : 0 )
+            << " messages/s for a target of "
+            << static_cast< long long >( rate ) << std::endl ;
+      }
+
+    protected :
+      /**
+       * @brief Send a new order. The ClOrdID of the order is set.
+       *
+       * @param The session.
+       * @param The order, to be kept live.
+       * @param Its price.
+       * @param The time it was due.
+       */
+      virtual void sendNew( size_t session,
+                            LiveOrder &order,
+                            long price,
+                            long long due ) = 0 ;
+
+      virtual void sendCancel( size_t session,
+                               const LiveOrder &order,
+                               const std::string &clientOrderId,
+                               long long due ) = 0 ;
+
+      /**
+       * @param The price & quantity replacing those of the order.
+       */
+      virtual void sendReplace( size_t session,
+                                const LiveOrder &order,
+                                const std::string &clientOrderId,
+                                long price,
+                                long qty,
+                                long long due ) = 0 ;
+
+      /**
+       * @brief Whether the order still rests, if known.
+       */
+      virtual bool isLive( const LiveOrder & ) { return true ; }
+
+      const std::string &getSecurityId( const LiveOrder &order ) const
+      {
+        return _flow.getSecurityId( order.symbol ) ;
+      }
+
+    private :
+      OrderFlow _flow ;
+      std::vector< std::vector< LiveOrder > > _liveOrders ;
+      unsigned long _nextClientOrderId ;
+      long _news ;
+      long _cancels ;
+      long _replaces ;
+      long long _elapsed ;
+
+      static void waitUntil( long long due )
+      {
+        long long wait = due - UT::Latency::now() ;
+        if( wait > 200000 )
+        {
+          boost::this_thread::sleep( boost::posix_time::microseconds( wait / 1000 - 100 ) ) ;
+        }
+        while( UT::Latency::now() < due )
+        {
+        }
+      }
+
+      std::string makeClientOrderId()
+      {
+        char clientOrderId[ 24 ] ;
+        snprintf( clientOrderId, sizeof( clientOrderId ), "G%lx", _nextClientOrderId++ ) ;
+        return clientOrderId ;
+      }
+
+      /**
+       * @brief Pick a live order of the session, dropping those known to be
+       * filled or cancelled on the way.
+       *
+       * @return Its index, or -1 if the session has no live order.
+       */
+      long pickLiveOrder( std::vector< LiveOrder > &orders )
+      {
+        while( !orders.empty() )
+        {
+          long index = _flow.pick( orders.size() ) ;
+          if( isLive( orders[ index ] ) )
+          {
+            return index ;
+          }
+          orders[ index ] = orders.back() ;
+          orders.pop_back() ;
+        }
+        return -1 ;
+      }
+
+      void send( size_t session, long long due )
+      {
+        std::vector< LiveOrder > &orders = _liveOrders[ session ] ;
+        Action action = _flow.nextAction( !orders.empty() ) ;
+        long index = action == Action_NEW ? -1 : pickLiveOrder( orders ) ;
+
+        if( index < 0 )
+        {
+          LiveOrder order ;
+          order.clientOrderId = makeClientOrderId() ;
+          order.symbol = _flow.nextSymbol() ;
+          order.side = _flow.nextSide() ;
+          order.qty = _flow.nextQty() ;
+          sendNew( session, order, _flow.nextPrice( order.symbol, order.side ), due ) ;
+          if( orders.size() < MaxLiveOrders )
+          {
+            orders.push_back( order ) ;
+          }
+          else
+          {
+            orders[ _flow.pick( orders.size() ) ] = order ;
+          }
+          ++_news ;
+        }
+        else if( action == Action_CANCEL )
+        {
+          sendCancel( session, orders[ index ], makeClientOrderId(), due ) ;
+          orders[ index ] = orders.back() ;
+          orders.pop_back() ;
+          ++_cancels ;
+        }
+        else
+        {
+          LiveOrder &order = orders[ index ] ;
+          std::string clientOrderId = makeClientOrderId() ;
+          long qty = _flow.nextQty() ;
+          sendReplace( session, order, clientOrderId,
+                       _flow.nextPrice( order.symbol, order.side ), qty, due ) ;
+          order.clientOrderId = clientOrderId ;
+          order.qty = qty ;
+          ++_replaces ;
+        }
+      }
+  };
+
+  void printLatency( std::ostream &out,
+                     const UT::LatencyHistogram &latency,
+                     long sent )
+  {
+    out << std::fixed << std::setprecision( 1 )
+        << "Acknowledged " << latency.getCount() << " of " << sent
+        << " messages, latency (us) p50 "
+        << latency.getValueAtPercentile( 50 ) / 1000.0
+        << " p99 " << latency.getValueAtPercentile( 99 ) / 1000.0
+        << " p99.9 " << latency.getValueAtPercentile( 99.9 ) / 1000.0
+        << " max " << latency.getMax() / 1000.0 << std::endl ;
+    out.unsetf( std::ios_base::floatfield ) ;
+  }
+
+  /**
+   * \class AckSink
+   *
+   * Execution sink of the in-process market, acknowledging the message the
+   * generator is sending. The market matches in the thread of the caller,
+   * so the acknowledgement comes before the call returns; replies from the
+   * threads of the market, e.g. expiries, are not acknowledgements.
+   *
+   */
+  class AckSink : public ESM::ExecutionSink
+  {
+    public :
+      AckSink() : _due( 0 ), _expecting( false ) {}
+
+      /**
+       * @brief Wait for the reply to a ClOrdID, from the calling thread.
+       */
+      void expect( const std::string &clientOrderId, long long due )
+      {
+        _thread = boost::this_thread::get_id() ;
+        _clientOrderId = clientOrderId ;
+        _due = due ;
+        _expecting = true ;
+      }
+
+      const UT::LatencyHistogram &getLatency() const { return _latency ; }
+
+    protected :
+      void onNewConfirm( const ESM::OrderPtr &order ) { acknowledge( order ) ; }
+      void onReplaceConfirm( const ESM::OrderPtr &order ) { acknowledge( order ) ; }
+      void onCancelConfirm( const ESM::OrderPtr &order, const std::string & )
+      {
+        acknowledge( order ) ;
+      }
+      void onNewReject( const ESM::OrderPtr &order, const std::string & )
+      {
+        acknowledge( order ) ;
+      }
+      void onReplaceReject( const ESM::OrderPtr &order, const std::string & )
+      {
+        acknowledge( order ) ;
+      }
+      void onCancelReject( const ESM::OrderPtr &order, const std::string & )
+      {
+        acknowledge( order ) ;
+      }
+      void onMarketToLimit( const ESM::OrderPtr & ) {}
+      void onTriggered( const ESM::OrderPtr & ) {}
+      void onFillConfirm( const ESM::OrderPtr & ) {}
+      void onOrderStatus( const ESM::OrderPtr &, const std::string & ) {}
+
+    private :
+      UT::LatencyHistogram _latency ;
+      boost::thread::id _thread ;
+      std::string _clientOrderId ;
+      long long _due ;
+      bool _expecting ;
+
+      void acknowledge( const ESM::OrderPtr &order )
+      {
+        if( _expecting
+            && boost::this_thread::get_id() == _thread
+            && order->getClientOrderId() == _clientOrderId )
+        {
+          _latency.record( UT::Latency::now() - _due ) ;
+          _expecting = false ;
+        }
+      }
+  };
+
+  /**
+   * \class InProcessGenerator
+   *
+   * Sends straight to a market of its own, with no session layer nor risk
+   * gate in the way.
+   *
+   */
+  class InProcessGenerator : public LoadGenerator
+  {
+    public :
+      InProcessGenerator( const FlowSettings &settings, unsigned seed, size_t sessions )
+        : LoadGenerator( settings, seed ),
+          _market( _sink )
+      {
+        for( size_t session = 0 ; session < sessions ; ++session )
+        {
+          std::ostringstream senderId ;
+          senderId << "orderGenerator" << session ;
+          _senderIds.push_back( senderId.str() ) ;
+        }
+      }
+
+      const AckSink &getSink() const { return _sink ; }
+
+    protected :
+      void sendNew( size_t session, LiveOrder &order, long price, long long due )
+      {
+        ESM::NewOrderPtr newOrder( new ESM::NewOrder(
+            getSecurityId( order ), order.clientOrderId, _senderIds[ session ],
+            order.side, ESM::OrderType_LIMIT, order.qty ) ) ;
+        newOrder->setPrice( price ) ;
+        order.order = newOrder ;
+
+        _sink.expect( order.clientOrderId, due ) ;
+        _market.insert( newOrder ) ;
+      }
+
+      void sendCancel( size_t session,
+                       const LiveOrder &order,
+                       const std::string &clientOrderId,
+                       long long due )
+      {
+        ESM::CancelOrderPtr cancelOrder( new ESM::CancelOrder(
+            order.order->getOrderId(), order.clientOrderId,
+            getSecurityId( order ), clientOrderId, _senderIds[ session ],
+            order.side, ESM::OrderType_LIMIT, order.qty ) ) ;
+
+        _sink.expect( clientOrderId, due ) ;
+        _market.cancel( cancelOrder ) ;
+      }
+
+      void sendReplace( size_t session,
+                        const LiveOrder &order,
+                        const std::string &clientOrderId,
+                        long price,
+                        long qty,
+                        long long due )
+      {
+        ESM::ReplaceOrderPtr replaceOrder( new ESM::ReplaceOrder(
+            order.order->getOrderId(), order.clientOrderId,
+            getSecurityId( order ), clientOrderId, _senderIds[ session ],
+            order.side, ESM::OrderType_LIMIT, qty ) ) ;
+        replaceOrder->setPrice( price ) ;
+
+        _sink.expect( clientOrderId, due ) ;
+        _market.replace( replaceOrder ) ;
+      }
+
+      bool isLive( const LiveOrder &order )
+      {
+        ESM::OrderStatus status = order.order->getStatus() ;
+        return status == ESM::OrderStatus_NEW
+          || status == ESM::OrderStatus_PARTIALLY_FILLED ;
+      }
+
+    private :
+      AckSink _sink ;
+      ESM::Market _market ;
+      std::vector< std::string > _senderIds ;
+  };
+
+  /**
+   * \class FixGenerator
+   *
+   * Sends over the FIX initiator sessions of a settings file, once they
+   * are all logged on. The first execution report or cancel reject with
+   * the ClOrdID of a message acknowledges it.
+   *
+   */
+  class FixGenerator :
+    public LoadGenerator,
+    public FIX::Application,
+    public FIX::MessageCracker
+  {
+    public :
+      FixGenerator( const FlowSettings &settings, unsigned seed )
+        : LoadGenerator( settings, seed )
+      {
+      }
+
+      void onCreate( const FIX::SessionID & ) {}
+      void onLogon( const FIX::SessionID &sessionId )
+      {
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        _sessions.push_back( sessionId ) ;
+        std::cout << "Logon " << sessionId.toString() << std::endl ;
+      }
+      void onLogout( const FIX::SessionID &sessionId )
+      {
+        std::cout << "Logout " << sessionId.toString() << std::endl ;
+      }
+      void toAdmin( FIX::Message &, const FIX::SessionID & ) {}
+      void toApp( FIX::Message &, const FIX::SessionID & )
+        throw( FIX::DoNotSend ) {}
+      void fromAdmin( const FIX::Message &, const FIX::SessionID & )
+        throw( FIX::FieldNotFound,
+               FIX::IncorrectDataFormat,
+               FIX::IncorrectTagValue,
+               FIX::RejectLogon ) {}
+      void fromApp( const FIX::Message &message, const FIX::SessionID &sessionId )
+        throw( FIX::FieldNotFound,
+               FIX::IncorrectDataFormat,
+               FIX::IncorrectTagValue,
+               FIX::UnsupportedMessageType )
+      {
+        crack( message, sessionId ) ;
+      }
+
+      void onMessage( const FIX42::ExecutionReport &report, const FIX::SessionID & )
+      {
+        acknowledge( report.getField( FIX::FIELD::ClOrdID ) ) ;
+      }
+
+      void onMessage( const FIX42::OrderCancelReject &reject, const FIX::SessionID & )
+      {
+        acknowledge( reject.getField( FIX::FIELD::ClOrdID ) ) ;
+      }
+
+      /**
+       * @brief Wait for the sessions to log on.
+       *
+       * @return The number of sessions logged on.
+       */
+      size_t waitForLogons( size_t sessions, long seconds )
+      {
+        for( long tenths = 0 ; tenths < seconds * 10 ; ++tenths )
+        {
+          {
+            boost::mutex::scoped_lock lock( _mutex ) ;
+            if( _sessions.size() >= sessions )
+            {
+              break ;
+            }
+          }
+          boost::this_thread::sleep( boost::posix_time::milliseconds( 100 ) ) ;
+        }
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        return _sessions.size() ;
+      }
+
+      /**
+       * @brief Wait for the acknowledgements still expected.
+       */
+      void waitForAcks( long seconds )
+      {
+        for( long tenths = 0 ; tenths < seconds * 10 ; ++tenths )
+        {
+          {
+            boost::mutex::scoped_lock lock( _mutex ) ;
+            if( _pending.empty() )
+            {
+              return ;
+            }
+          }
+          boost::this_thread::sleep( boost::posix_time::milliseconds( 100 ) ) ;
+        }
+      }
+
+      /**
+       * @brief The latencies, once the acknowledgements are in.
+       */
+      const UT::LatencyHistogram &getLatency() const { return _latency ; }
+
+    protected :
+      void sendNew( size_t session, LiveOrder &order, long price, long long due )
+      {
+        FIX42::NewOrderSingle newOrder(
+            FIX::ClOrdID( order.clientOrderId ),
+            FIX::HandlInst( FIX::HandlInst_AUTOMATED_EXECUTION_ORDER_PRIVATE_NO_BROKER_INTERVENTION ),
+            FIX::Symbol( getSecurityId( order ) ),
+            FIX::Side( toFix( order.side ) ),
+            FIX::TransactTime(),
+            FIX::OrdType( FIX::OrdType_LIMIT ) ) ;
+        newOrder.set( FIX::SecurityID( getSecurityId( order ) ) ) ;
+        newOrder.set( FIX::OrderQty( order.qty ) ) ;
+        newOrder.set( FIX::Price( price ) ) ;
+
+        send( newOrder, session, order.clientOrderId, due ) ;
+      }
+
+      void sendCancel( size_t session,
+                       const LiveOrder &order,
+                       const std::string &clientOrderId,
+                       long long due )
+      {
+        FIX42::OrderCancelRequest cancelOrder(
+            FIX::OrigClOrdID( order.clientOrderId ),
+            FIX::ClOrdID( clientOrderId ),
+            FIX::Symbol( getSecurityId( order ) ),
+            FIX::Side( toFix( order.side ) ),
+            FIX::TransactTime() ) ;
+        cancelOrder.set( FIX::SecurityID( getSecurityId( order ) ) ) ;
+        cancelOrder.set( FIX::OrderQty( order.qty ) ) ;
+        cancelOrder.setField( FIX::OrdType( FIX::OrdType_LIMIT ) ) ;
+
+        send( cancelOrder, session, clientOrderId, due ) ;
+      }
+
+      void sendReplace( size_t session,
+                        const LiveOrder &order,
+                        const std::string &clientOrderId,
+                        long price,
+                        long qty,
+                        long long due )
+      {
+        FIX42::OrderCancelReplaceRequest replaceOrder(
+            FIX::OrigClOrdID( order.clientOrderId ),
+            FIX::ClOrdID( clientOrderId ),
+            FIX::HandlInst( FIX::HandlInst_AUTOMATED_EXECUTION_ORDER_PRIVATE_NO_BROKER_INTERVENTION ),
+            FIX::Symbol( getSecurityId( order ) ),
+            FIX::Side( toFix( order.side ) ),
+            FIX::TransactTime(),
+            FIX::OrdType( FIX::OrdType_LIMIT ) ) ;
+        replaceOrder.set( FIX::SecurityID( getSecurityId( order ) ) ) ;
+        replaceOrder.set( FIX::OrderQty( qty ) ) ;
+        replaceOrder.set( FIX::Price( price ) ) ;
+        // The fills are not followed, the quantity replaces the leaves.
+        replaceOrder.setField( FIX::CumQty( 0 ) ) ;
+
+        send( replaceOrder, session, clientOrderId, due ) ;
+      }
+
+    private :
+      boost::mutex _mutex ;
+      std::vector< FIX::SessionID > _sessions ;
+      boost::unordered_map< std::string, long long > _pending ;
+      UT::LatencyHistogram _latency ;
+
+      static char toFix( ESM::Side side )
+      {
+        return side == ESM::Side_BUY ? FIX::Side_BUY : FIX::Side_SELL ;
+      }
+
+      void send( FIX::Message &message,
+                 size_t session,
+                 const std::string &clientOrderId,
+                 long long due )
+      {
+        FIX::SessionID sessionId ;
+        {
+          boost::mutex::scoped_lock lock( _mutex ) ;
+          sessionId = _sessions[ session ] ;
+          _pending[ clientOrderId ] = due ;
+        }
+        FIX::Session::sendToTarget( message, sessionId ) ;
+      }
+
+      void acknowledge( const std::string &clientOrderId )
+      {
+        long long now = UT::Latency::now() ;
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        boost::unordered_map< std::string, long long >::iterator iPending =
+          _pending.find( clientOrderId ) ;
+        if( iPending != _pending.end() )
+        {
+          // Recorded under the lock, as the sessions may have threads of
+          // their own.
+          _latency.record( now - iPending->second ) ;
+          _pending.erase( iPending ) ;
+        }
+      }
+  };
+}
+
+int main( int argc, char *argv[] )
+{
+  namespace bpo = boost::program_options ;
+
+  FlowSettings settings ;
+  std::string mode, settingsFile ;
+  size_t sessions = 0 ;
+  double seconds = 0 ;
+  unsigned seed = 0 ;
+
+  bpo::options_description options( "Allowed options" ) ;
+  options.add_options()
+    ( "help,h", "produce help message" )
+    ( "mode",
+      bpo::value< std::string >( &mode )->default_value( "inprocess" ),
+      "inprocess, to a market of our own, or fix, to uMatch" )
+    ( "settings",
+      bpo::value< std::string >( &settingsFile )->default_value( "loadgen-settings" ),
+      "QuickFIX settings of the initiator sessions, in fix mode" )
+    ( "sessions",
+      bpo::value< size_t >( &sessions )->default_value( 1 ),
+      "Number of sessions. In fix mode, those of the settings to wait for" )
+    ( "rate",
+      bpo::value< double >( &settings.rate )->default_value( 100000 ),
+      "Target messages per second, over all the sessions" )
+    ( "duration",
+      bpo::value< double >( &seconds )->default_value( 10 ),
+      "Seconds to send for" )
+    ( "burst",
+      bpo::value< long >( &settings.burst )->default_value( 1 ),
+      "Messages sent back to back per burst. 1 for Poisson arrivals" )
+    ( "symbols",
+      bpo::value< long >( &settings.symbols )->default_value( 1000 ),
+      "Number of symbols" )
+    ( "first-security-id",
+      bpo::value< long >( &settings.firstSecurityId )->default_value( 1000 ),
+      "Security id of the most popular symbol, the others follow" )
+    ( "zipf",
+      bpo::value< double >( &settings.zipf )->default_value( 1 ),
+      "Exponent of the popularity of the symbols, 0 for all alike" )
+    ( "cancel-ratio",
+      bpo::value< double >( &settings.cancelRatio )->default_value( 0.3 ),
+      "Share of the messages cancelling a live order" )
+    ( "replace-ratio",
+      bpo::value< double >( &settings.replaceRatio )->default_value( 0.2 ),
+      "Share of the messages replacing a live order" )
+    ( "drift",
+      bpo::value< double >( &settings.drift )->default_value( 0.1 ),
+      "Chance per order that the mid price moves a tick" )
+    ( "spread",
+      bpo::value< long >( &settings.spread )->default_value( 10 ),
+      "Orders are priced up to so many ticks from the mid" )
+    ( "cross-ratio",
+      bpo::value< double >( &settings.crossRatio )->default_value( 0.05 ),
+      "Share of the new orders priced through the mid" )
+    ( "max-qty",
+      bpo::value< long >( &settings.maxQty )->default_value( 100 ),
+      "Quantities are drawn from 1 to this" )
+    ( "seed",
+      bpo::value< unsigned >( &seed )->default_value( 42 ),
+      "Seed of the flow" )
+    ;
+
+  try
+  {
+    bpo::variables_map vm ;
+    store( parse_command_line( argc, argv, options ), vm ) ;
+    notify( vm ) ;
+
+    if( vm.count( "help" ) )
+    {
+      std::cout << "Usage : umatch_loadgen [options]\n" << options << std::endl ;
+      return 1 ;
+    }
+    if( ( mode != "inprocess" && mode != "fix" ) || sessions == 0
+        || settings.rate <= 0 || settings.burst < 1 || settings.symbols < 1
+        || settings.spread < 1 || settings.maxQty < 1 )
+    {
+      std::cout << "Found error in the options, see --help" << std::endl ;
+      return 1 ;
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cout << "Found error in the options : " << e.what() << std::endl ;
+    return 1 ;
+  }
+
+  try
+  {
+    if( mode == "inprocess" )
+    {
+      // Left to _exit, as the threads of the market never end.
+      InProcessGenerator *generator = new InProcessGenerator( settings, seed, sessions ) ;
+      generator->run( sessions, seconds ) ;
+      generator->print( std::cout, settings.rate ) ;
+      printLatency( std::cout, generator->getSink().getLatency(),
+                    generator->getSent() ) ;
+    }
+    else
+    {
+      FixGenerator generator( settings, seed ) ;
+      FIX::SessionSettings sessionSettings( settingsFile ) ;
+      FIX::FileStoreFactory storeFactory( sessionSettings ) ;
+      FIX::SocketInitiator initiator( generator, storeFactory, sessionSettings ) ;
+      initiator.start() ;
+
+      size_t loggedOn = generator.waitForLogons( sessions, 30 ) ;
+      if( loggedOn == 0 )
+      {
+        std::cout << "No session logged on" << std::endl ;
+        UT::BinaryLog::flush() ;
+        _exit( 1 ) ;
+      }
+      if( loggedOn < sessions )
+      {
+        std::cout << "Only " << loggedOn << " of " << sessions
+                  << " sessions logged on" << std::endl ;
+      }
+
+      generator.run( loggedOn, seconds ) ;
+      generator.waitForAcks( 5 ) ;
+      generator.print( std::cout, settings.rate ) ;
+      printLatency( std::cout, generator.getLatency(), generator.getSent() ) ;
+      initiator.stop() ;
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cout << "stopping due to error " << e.what() << std::endl ;
+    UT::BinaryLog::flush() ;
+    return 1 ;
+  }
+
+  // The threads of the market never end. Statements still in the rings
+  // of the threads would be lost.
+  UT::BinaryLog::flush() ;
+  _exit( 0 ) ;
+}
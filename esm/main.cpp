@@ -1,11 +1,17 @@
 #include "../config.h"
 
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <fstream>
 
 #include "quickfix/FileStore.h"
 #include "quickfix/ThreadedSocketAcceptor.h"
 
+#include "../common/binaryLog.h"
+#include "../common/fixCapture.h"
+#include "../common/uniqueOrderId.h"
+#include "../common/latency.h"
 #include "requestApplication.h"
 #include "replyApplication.h"
 
@@ -15,6 +21,23 @@ int main ( int argc, char * argv[] )
 
   std::string esmSettingsFile, configFile, udpAddress, udpPort ;
   std::string mdSettingsFile;
+  int mdThreads ;
+  std::string barIntervals ;
+  long barHistory ;
+#ifndef UDP_MARKET_DATA
+  bool mdSubscribeOnLogon ;
+#endif
+  std::string shmClients ;
+  std::string instrumentsFile ;
+  bool cancelOnDisconnect ;
+  std::string tradingSchedule ;
+  std::string sessionEnd ;
+  long latencyDumpInterval ;
+  std::string logFile ;
+  std::string orderIdFile ;
+  std::string captureFile ;
+  long captureFileSize ;
+  ESM::RiskLimits riskLimits ;
 
   bpo::options_description visible("Allowed options");
   bpo::variables_map vm;
@@ -37,6 +60,66 @@ int main ( int argc, char * argv[] )
       ("UMATCH.settings_file",
        bpo::value<std::string>(&esmSettingsFile),
        "Settings file to configure uMatch")
+      ("UMATCH.shm_clients",
+       bpo::value<std::string>(&shmClients),
+       "Comma separated co-located clients sending orders over shared memory")
+      ("UMATCH.instruments_file",
+       bpo::value<std::string>(&instrumentsFile),
+       "Price scale & tick table of the instruments")
+      ("UMATCH.cancel_on_disconnect",
+       bpo::value<bool>(&cancelOnDisconnect)->default_value( true ),
+       "Cancel the orders of a FIX session when it disconnects")
+      ("UMATCH.trading_schedule",
+       bpo::value<std::string>(&tradingSchedule),
+       "Trading phases of the day, e.g. \"09:00 call, 09:15 continuous\"")
+      ("UMATCH.session_end",
+       bpo::value<std::string>(&sessionEnd),
+       "Local time DAY orders expire at, HH:MM. Defaults to the time the "
+       "trading schedule closes")
+      ("UMATCH.latency_dump_interval",
+       bpo::value<long>(&latencyDumpInterval)->default_value( 0 ),
+       "Seconds between dumps of the latency histograms, 0 for none. Only "
+       "when built with LATENCY_HISTOGRAMS")
+      ("UMATCH.log_file",
+       bpo::value<std::string>(&logFile),
+       "Write the log in binary to this file, for umatch_logdecode. "
+       "Printed to stderr otherwise")
+      ("UMATCH.order_id_file",
+       bpo::value<std::string>(&orderIdFile),
+       "Keeps the order ids unique across restarts. Without it they start "
+       "from the time")
+      ("UMATCH.capture_file",
+       bpo::value<std::string>(&captureFile),
+       "Capture the FIX messages to this file, .0, .1 and so on, for "
+       "umatch_capdecode")
+      ("UMATCH.capture_file_size",
+       bpo::value<long>(&captureFileSize)->default_value( 256 ),
+       "MB of messages in each capture file")
+      ("RISK.max_order_qty",
+       bpo::value<long>(&riskLimits.maxOrderQty)->default_value( 0 ),
+       "Largest quantity of an order, 0 for no limit")
+      ("RISK.max_order_notional",
+       bpo::value<double>(&riskLimits.maxOrderNotional)->default_value( 0 ),
+       "Largest quantity * price of an order, 0 for no limit")
+      ("RISK.max_open_orders",
+       bpo::value<long>(&riskLimits.maxOpenOrders)->default_value( 0 ),
+       "Most open orders of a session, 0 for no limit")
+      ("RISK.max_position",
+       bpo::value<long>(&riskLimits.maxPosition)->default_value( 0 ),
+       "Largest long or short position of a session in an instrument, "
+       "counting its open orders as filled, 0 for no limit")
+      ("UMATCH.md_threads",
+       bpo::value<int>(&mdThreads)->default_value( 1 ),
+       "Threads encoding & sending the market data, each for its own "
+       "share of the instruments")
+      ("UMATCH.bar_intervals",
+       bpo::value<std::string>(&barIntervals),
+       "Comma separated seconds of the bars of the trades kept & sent with "
+       "the market data, each dividing a day, e.g. \"1, 60\". Up to 4, "
+       "none by default")
+      ("UMATCH.bar_history",
+       bpo::value<long>(&barHistory)->default_value( 60 ),
+       "Bars kept for each security & interval, for the bars command")
 #ifdef UDP_MARKET_DATA
       ("UMATCH.udp_host",
        bpo::value<std::string>(&udpAddress),
@@ -48,6 +131,10 @@ int main ( int argc, char * argv[] )
       ("UMATCH.md_settings_file",
        bpo::value<std::string>(&mdSettingsFile),
        "Settings File For MarketData")
+      ("UMATCH.md_subscribe_on_logon",
+       bpo::value<bool>(&mdSubscribeOnLogon)->default_value( false ),
+       "Send every security to a market data session from logon, "
+       "without MarketDataRequest")
 #endif
       ;
 
@@ -124,12 +211,89 @@ int main ( int argc, char * argv[] )
 
   try
   {
+    if( !instrumentsFile.empty() )
+    {
+      ESM::Instruments::load( instrumentsFile ) ;
+    }
+
+    if( !logFile.empty() )
+    {
+      UT::BinaryLog::open( logFile ) ;
+    }
+
+    if( !orderIdFile.empty() )
+    {
+      UT::UniqueOrderId::load( orderIdFile ) ;
+    }
+
+    if( latencyDumpInterval > 0 )
+    {
+      UT::Latency::startDumping( latencyDumpInterval ) ;
+    }
+
+    boost::scoped_ptr< UT::FixCapture > capture ;
+    if( !captureFile.empty() )
+    {
+      capture.reset( new UT::FixCapture( captureFile,
+                                         captureFileSize * 1024 * 1024 ) ) ;
+    }
+
     FIX::SessionSettings settings( esmSettingsFile );
     ESM::RequestApplication requestApplication( udpAddress, udpPort ) ;
+    requestApplication.setCapture( capture.get() ) ;
+    requestApplication.setCancelOnDisconnect( cancelOnDisconnect ) ;
+    requestApplication.setRiskLimits( riskLimits ) ;
+    requestApplication.setMarketDataThreads( mdThreads ) ;
+    if( !barIntervals.empty() )
+    {
+      std::vector< std::string > words ;
+      boost::split( words, barIntervals, boost::is_any_of( ", " ),
+                    boost::token_compress_on ) ;
+      std::vector< long > intervals ;
+      for( size_t i = 0 ; i < words.size() ; ++i )
+      {
+        long interval = atol( words[i].c_str() ) ;
+        if( interval <= 0 || 86400 % interval != 0 )
+        {
+          throw UT::ConfigError( "Invalid UMATCH.bar_intervals : " + barIntervals ) ;
+        }
+        intervals.push_back( interval ) ;
+      }
+      if( intervals.size() > ESM::BarAggregator::MaxIntervals )
+      {
+        throw UT::ConfigError( "Too many UMATCH.bar_intervals : " + barIntervals ) ;
+      }
+      requestApplication.setBarIntervals( intervals, barHistory ) ;
+    }
+    ESM::TradingSchedule schedule( tradingSchedule ) ;
+    if( !schedule.empty() )
+    {
+      requestApplication.setTradingSchedule( schedule ) ;
+    }
+
+    boost::posix_time::time_duration dayEnd ;
+    if( !sessionEnd.empty() )
+    {
+      try
+      {
+        dayEnd = boost::posix_time::duration_from_string( sessionEnd ) ;
+      }
+      catch( std::exception &e )
+      {
+        throw UT::ConfigError( "Invalid UMATCH.session_end : " + sessionEnd ) ;
+      }
+      requestApplication.setSessionEnd( dayEnd ) ;
+    }
+    else if( schedule.getSessionEnd( dayEnd ) )
+    {
+      requestApplication.setSessionEnd( dayEnd ) ;
+    }
 
 #ifndef UDP_MARKET_DATA
     ESM::MarketDataApplication mdApplication;
     requestApplication.setMarketDataApplication( &mdApplication );
+    mdApplication.setCapture( capture.get() ) ;
+    mdApplication.setSubscribeOnLogon( mdSubscribeOnLogon ) ;
 
     FIX::SessionSettings mdSettings( mdSettingsFile );
     FIX::FileStoreFactory mdFileStore( mdSettings );
@@ -141,6 +305,14 @@ int main ( int argc, char * argv[] )
     mdAcceptor.start();
 #endif
 
+    if( !shmClients.empty() )
+    {
+      std::vector< std::string > clients ;
+      boost::split( clients, shmClients, boost::is_any_of( ", " ),
+                    boost::token_compress_on ) ;
+      requestApplication.startSharedMemoryGateway( clients ) ;
+    }
+
     FIX::SessionSettings sessionSettings( settings )  ;
     FIX::FileStoreFactory fileStoreFactory( settings );
     FIX::ThreadedSocketAcceptor acceptor( requestApplication,
@@ -161,6 +333,8 @@ int main ( int argc, char * argv[] )
     std::cout << "stopping due to error " << e.what() << std::endl ;
   }
 
+  // Statements still in the rings of the threads would be lost.
+  UT::BinaryLog::flush() ;
   return 0 ;
 
 }
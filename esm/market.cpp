@@ -1,28 +1,91 @@
 
 #include "market.h"
 
+#include <algorithm>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <boost/functional/hash.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/thread.hpp>
 
+#include "../common/latency.h"
+
 namespace ESM
 {
-  Market::Market( ReplyApplication &replyApplication,
-                  const std::string &address,
-                  const std::string &port)
-#ifdef UDP_MARKET_DATA
-    : _replyApplication( replyApplication ) ,
-      _udpSender( address, port )
-#else
-    : _replyApplication( replyApplication )
-#endif
-  {
-#ifdef UDP_MARKET_DATA
-    std::cout << "Sending market data on  : " << address << ":" << port << std::endl ;
-#endif
-    boost::thread marketPictureThread( &Market::sendMarketPicture, this ) ;
+  namespace
+  {
+    const std::string KilledSessionText(
+        "Orders from this session are blocked by the kill switch" ) ;
+  }
+
+  Market::Market( ExecutionSink &executionSink )
+    : _executionSink( executionSink ),
+      _tradingPhase( TradingPhase_CONTINUOUS ),
+      _dayExpireTime( 0 ),
+      _marketDataPublisher( 0 ),
+      _marketDataThreads( 1 ),
+      _marketDataThreadsStarted( 1 )
+  {
+    boost::thread marketPictureThread( &Market::sendMarketPicture, this, 0 ) ;
+    boost::thread expiryThread( &Market::runExpiry, this ) ;
   }
 
   void Market::insert( NewOrderPtr order )
+  {
+    LATENCY_SCOPE( ROUTE ) ;
+    setDayExpireTime( order ) ;
+    OrderBookPtr orderBook = findOrCreateOrderBook( order ) ;
+
+    if( !addSessionOrderBook( order->getSenderId(), orderBook ) )
+    {
+      _executionSink.sendNewReject( order, KilledSessionText ) ;
+      return ;
+    }
+
+    LATENCY_STOP( ROUTE ) ;
+    orderBook->insert( order ) ;
+  }
+
+  void Market::insert( const std::vector< NewOrderPtr > &orders )
+  {
+    LATENCY_SCOPE( ROUTE ) ;
+    typedef boost::unordered_map< std::string, size_t > BatchIndex ;
+    BatchIndex batchIndex ;
+    std::vector< std::pair< OrderBookPtr, std::vector< OrderPtr > > > batches ;
+
+    for( std::vector< NewOrderPtr >::const_iterator iOrder = orders.begin() ;
+         iOrder != orders.end() ;
+         ++iOrder )
+    {
+      setDayExpireTime( *iOrder ) ;
+      std::pair< BatchIndex::iterator, bool > iBatch = batchIndex.insert(
+          std::make_pair( ( *iOrder )->getSecurityId(), batches.size() ) ) ;
+      if( iBatch.second )
+      {
+        batches.push_back( std::make_pair( findOrCreateOrderBook( *iOrder ),
+                                           std::vector< OrderPtr >() ) ) ;
+      }
+
+      if( !addSessionOrderBook( ( *iOrder )->getSenderId(),
+                                batches[ iBatch.first->second ].first ) )
+      {
+        _executionSink.sendNewReject( *iOrder, KilledSessionText ) ;
+        continue ;
+      }
+      batches[ iBatch.first->second ].second.push_back( *iOrder ) ;
+    }
+    LATENCY_STOP( ROUTE ) ;
+
+    for( size_t i = 0 ; i < batches.size() ; ++i )
+    {
+      batches[i].first->insert( batches[i].second ) ;
+    }
+  }
+
+  OrderBookPtr Market::findOrCreateOrderBook( OrderPtr order )
   {
     OrderBooksMap::iterator iOrderBooks = _orderBooks.find( order->getSecurityId() ) ;
 
@@ -32,8 +95,16 @@ namespace ESM
       iOrderBooks = _orderBooks.find( order->getSecurityId() ) ;
       if( iOrderBooks == _orderBooks.end() )
       {
+        // A book always falls in the same partition, which only one
+        // thread sends at a time.
+        MarketDataPartition &partition = _marketDataPartitions[
+          boost::hash< std::string >()( order->getSecurityId() )
+          % MarketDataPartitions ] ;
         OrderBookPtr newOrderBook =
-          OrderBookPtr( new OrderBook( _replyApplication, order ) ) ;
+          OrderBookPtr( new OrderBook( _executionSink, order,
+                findOrCreatePriceBand( order->getSecurityId() ),
+                _tradingPhase, &partition.dirtyBooks, &_barAggregator,
+                &_expiryBooks ) ) ;
 
         iOrderBooks = _orderBooks.insert(
           std::make_pair( order->getSecurityId(), newOrderBook )
@@ -42,29 +113,328 @@ namespace ESM
       }
     }
 
-    iOrderBooks->second->insert( order ) ;
+    return iOrderBooks->second ;
+  }
+
+  const PriceBand &Market::getPriceBand( const std::string &securityId )
+  {
+    boost::mutex::scoped_lock lock( _mutexForNewBook ) ;
+    return findOrCreatePriceBand( securityId ) ;
+  }
+
+  PriceBand &Market::findOrCreatePriceBand( const std::string &securityId )
+  {
+    PriceBandPtr &priceBand = _priceBands[ securityId ] ;
+    if( !priceBand )
+    {
+      priceBand.reset( new PriceBand ) ;
+    }
+    return *priceBand ;
   }
 
   void Market::replace( ReplaceOrderPtr order )
   {
+    LATENCY_SCOPE( ROUTE ) ;
     OrderBooksMap::iterator iOrderBooks = _orderBooks.find( order->getSecurityId() ) ;
     if( iOrderBooks == _orderBooks.end() )
     {
       throw SecurityIdNotFound( order->getSecurityId() ) ;
     }
+    setDayExpireTime( order ) ;
+    LATENCY_STOP( ROUTE ) ;
     iOrderBooks->second->replace( order ) ;
   }
 
   void Market::cancel( CancelOrderPtr order )
   {
+    LATENCY_SCOPE( ROUTE ) ;
     OrderBooksMap::iterator iOrderBooks = _orderBooks.find( order->getSecurityId() ) ;
     if( iOrderBooks == _orderBooks.end() )
     {
       throw SecurityIdNotFound( order->getSecurityId() ) ;
     }
+    LATENCY_STOP( ROUTE ) ;
     iOrderBooks->second->cancel( order ) ;
   }
 
+  long Market::massCancel( const std::string &senderId,
+                           const std::string &securityId,
+                           bool buys,
+                           bool sells )
+  {
+    const std::string reason( "Order Cancelled By Mass Cancel Request" ) ;
+
+    if( !securityId.empty() )
+    {
+      OrderBooksMap::iterator iOrderBooks = _orderBooks.find( securityId ) ;
+      if( iOrderBooks == _orderBooks.end() )
+      {
+        throw SecurityIdNotFound( securityId ) ;
+      }
+      return iOrderBooks->second->massCancel( senderId, buys, sells, reason ) ;
+    }
+
+    return cancelSessionOrders( senderId, buys, sells, reason ) ;
+  }
+
+  bool Market::getMarketPictureRecord( const std::string &securityId,
+                                       MarketPicture::Record &record )
+  {
+    OrderBookPtr orderBook ;
+    {
+      boost::mutex::scoped_lock lock( _mutexForNewBook ) ;
+      OrderBooksMap::iterator iOrderBooks = _orderBooks.find( securityId ) ;
+      if( iOrderBooks == _orderBooks.end() )
+      {
+        return false ;
+      }
+      orderBook = iOrderBooks->second ;
+    }
+
+    orderBook->refreshIndicative() ;
+    orderBook->getMarketPictureRecord( record ) ;
+    return true ;
+  }
+
+  void Market::sendStatus( OrderPtr order )
+  {
+    OrderBooksMap::iterator iOrderBooks = _orderBooks.find( order->getSecurityId() ) ;
+    if( iOrderBooks == _orderBooks.end() )
+    {
+      // The order never reached a book, so nothing can change it.
+      _executionSink.sendOrderStatus( order ) ;
+      return ;
+    }
+
+    iOrderBooks->second->sendStatus( order ) ;
+  }
+
+  long Market::cancelAll( const std::string &senderId,
+                          const std::string &reason )
+  {
+    return cancelSessionOrders( senderId, true, true, reason ) ;
+  }
+
+  long Market::kill( const std::string &senderId )
+  {
+    {
+      boost::mutex::scoped_lock lock( _mutexForSessions ) ;
+      _killedSessions.insert( senderId ) ;
+    }
+    return cancelAll( senderId, "Order Cancelled By Kill Switch" ) ;
+  }
+
+  void Market::resume( const std::string &senderId )
+  {
+    boost::mutex::scoped_lock lock( _mutexForSessions ) ;
+    _killedSessions.erase( senderId ) ;
+  }
+
+  bool Market::addSessionOrderBook( const std::string &senderId,
+                                    const OrderBookPtr &orderBook )
+  {
+    boost::mutex::scoped_lock lock( _mutexForSessions ) ;
+
+    if( !_killedSessions.empty() && _killedSessions.count( senderId ) )
+    {
+      return false ;
+    }
+    _orderBooksBySession[ senderId ].insert( orderBook ) ;
+    return true ;
+  }
+
+  long Market::cancelSessionOrders( const std::string &senderId,
+                                    bool buys,
+                                    bool sells,
+                                    const std::string &reason )
+  {
+    // Take a copy so that no order book is held while we hold the session
+    // mutex.
+    OrderBookSet orderBooks ;
+    {
+      boost::mutex::scoped_lock lock( _mutexForSessions ) ;
+      OrderBooksBySessionMap::iterator iSession =
+        _orderBooksBySession.find( senderId ) ;
+      if( iSession == _orderBooksBySession.end() )
+      {
+        return 0 ;
+      }
+      orderBooks = iSession->second ;
+    }
+
+    long canceled = 0 ;
+    for( OrderBookSet::iterator iOrderBook = orderBooks.begin() ;
+         iOrderBook != orderBooks.end() ;
+         ++iOrderBook )
+    {
+      canceled += ( *iOrderBook )->massCancel( senderId, buys, sells, reason ) ;
+    }
+    return canceled ;
+  }
+
+  void Market::setTradingPhase( TradingPhase tradingPhase )
+  {
+    std::vector< OrderBookPtr > orderBooks ;
+    {
+      boost::mutex::scoped_lock lock( _mutexForNewBook ) ;
+      _tradingPhase = tradingPhase ;
+      orderBooks = _orderBooksForMarketPicture ;
+    }
+
+    std::cout << "Trading phase : " << TradingSchedule::toString( tradingPhase )
+              << std::endl ;
+
+    for( std::vector< OrderBookPtr >::iterator iOrderBook = orderBooks.begin() ;
+         iOrderBook != orderBooks.end() ;
+         ++iOrderBook )
+    {
+      ( *iOrderBook )->setTradingPhase( tradingPhase ) ;
+    }
+  }
+
+  void Market::setTradingSchedule( const TradingSchedule &tradingSchedule )
+  {
+    _tradingSchedule = tradingSchedule ;
+    boost::thread tradingScheduleThread( &Market::runTradingSchedule, this ) ;
+  }
+
+  void Market::runTradingSchedule()
+  {
+    bool isFirst = true ;
+    TradingPhase scheduledPhase = TradingPhase_CONTINUOUS ;
+    while( true )
+    {
+      TradingPhase tradingPhase = _tradingSchedule.getPhaseAt(
+          boost::posix_time::second_clock::local_time().time_of_day() ) ;
+      if( isFirst || tradingPhase != scheduledPhase )
+      {
+        setTradingPhase( tradingPhase ) ;
+        scheduledPhase = tradingPhase ;
+        isFirst = false ;
+      }
+
+      boost::this_thread::sleep( boost::posix_time::seconds( 1 ) ) ;
+    }
+  }
+
+  void Market::setSessionEnd( const boost::posix_time::time_duration &sessionEnd )
+  {
+    _sessionEnd = sessionEnd ;
+    _dayExpireTime.store( getNextSessionEnd( time( 0 ) ) ) ;
+
+    std::cout << "DAY orders expire at : " << sessionEnd << std::endl ;
+  }
+
+  long Market::getNextSessionEnd( long now ) const
+  {
+    time_t nowTime = now ;
+    tm sessionEnd ;
+    localtime_r( &nowTime, &sessionEnd ) ;
+    sessionEnd.tm_hour = _sessionEnd.hours() ;
+    sessionEnd.tm_min = _sessionEnd.minutes() ;
+    sessionEnd.tm_sec = _sessionEnd.seconds() ;
+    sessionEnd.tm_isdst = -1 ;
+
+    long endTime = mktime( &sessionEnd ) ;
+    if( endTime <= now )
+    {
+      ++sessionEnd.tm_mday ;
+      sessionEnd.tm_isdst = -1 ;
+      endTime = mktime( &sessionEnd ) ;
+    }
+    return endTime ;
+  }
+
+  void Market::setDayExpireTime( const OrderPtr &order )
+  {
+    if( order->getTimeInForce() != TimeInForce_DAY )
+    {
+      return ;
+    }
+
+    // Until the expiry thread moves it on, a session end just passed
+    // stands for the next one.
+    long expireTime = _dayExpireTime.load() ;
+    if( expireTime != 0 && expireTime <= time( 0 ) )
+    {
+      expireTime = getNextSessionEnd( time( 0 ) ) ;
+    }
+    order->setExpireTime( expireTime ) ;
+  }
+
+  void Market::runExpiry()
+  {
+    // The books by the time they are next due, earliest first. An entry
+    // whose time is no longer the one of its book is stale: the book has
+    // another entry, or is on the expiry queue.
+    typedef std::pair< long, OrderBook * > DueBook ;
+    std::priority_queue< DueBook, std::vector< DueBook >,
+                         std::greater< DueBook > > dueBooks ;
+    std::vector< OrderBook * > orderBooks ;
+
+    while( true )
+    {
+      long now = time( 0 ) ;
+      if( _dayExpireTime.load() != 0 && _dayExpireTime.load() <= now )
+      {
+        _dayExpireTime.store( getNextSessionEnd( now ) ) ;
+      }
+
+      orderBooks.clear() ;
+      _expiryBooks.take( orderBooks ) ;
+      for( std::vector< OrderBook * >::iterator iOrderBook = orderBooks.begin() ;
+           iOrderBook != orderBooks.end() ;
+           ++iOrderBook )
+      {
+        long nextExpiry = ( *iOrderBook )->getNextExpiry() ;
+        if( nextExpiry != 0 )
+        {
+          dueBooks.push( DueBook( nextExpiry, *iOrderBook ) ) ;
+        }
+      }
+
+      while( !dueBooks.empty() && dueBooks.top().first <= now )
+      {
+        DueBook dueBook = dueBooks.top() ;
+        dueBooks.pop() ;
+        if( dueBook.second->getNextExpiry() != dueBook.first )
+        {
+          continue ;
+        }
+
+        dueBook.second->expireOrders( now ) ;
+        long nextExpiry = dueBook.second->getNextExpiry() ;
+        if( nextExpiry != 0 )
+        {
+          dueBooks.push( DueBook( nextExpiry, dueBook.second ) ) ;
+        }
+      }
+
+      boost::this_thread::sleep( boost::posix_time::seconds( 1 ) ) ;
+    }
+  }
+
+  size_t Market::getChecksum( size_t &orderBooks )
+  {
+    std::map< std::string, OrderBookPtr > sortedOrderBooks ;
+    {
+      boost::mutex::scoped_lock lock( _mutexForNewBook ) ;
+      sortedOrderBooks.insert( _orderBooks.begin(), _orderBooks.end() ) ;
+    }
+
+    size_t seed = 0 ;
+    for( std::map< std::string, OrderBookPtr >::const_iterator iOrderBook =
+           sortedOrderBooks.begin() ;
+         iOrderBook != sortedOrderBooks.end() ;
+         ++iOrderBook )
+    {
+      boost::hash_combine( seed, iOrderBook->first ) ;
+      boost::hash_combine( seed, iOrderBook->second->getChecksum() ) ;
+    }
+    orderBooks = sortedOrderBooks.size() ;
+    return seed ;
+  }
+
   void Market::readCommands( )
   {
     std::string command = "";
@@ -77,18 +447,56 @@ namespace ESM
 
   bool Market::executeCommand( const std::string &command )
   {
+    std::istringstream words( command ) ;
+    std::string verb, argument ;
+    words >> verb >> argument ;
+
     if( command == "stop" || command == "quit" || command == "q" ) {
       stop() ;
     }
-    if( command == "start" ) {
+    else if( command == "start" ) {
       start() ;
     }
+    else if( command == "latency" ) {
+      UT::Latency::dump( std::cout ) ;
+    }
+    else if( verb == "kill" && !argument.empty() ) {
+      std::cout << "Cancelled " << kill( argument ) << " orders of "
+                << argument << ", new orders will be rejected" << std::endl ;
+    }
+    else if( verb == "resume" && !argument.empty() ) {
+      resume( argument ) ;
+      std::cout << "Accepting orders of " << argument << std::endl ;
+    }
+    else if( verb == "bars" && !argument.empty() ) {
+      long interval = 0 ;
+      words >> interval ;
+      printBars( argument, interval ) ;
+    }
+    else if( verb == "phase" && !argument.empty() ) {
+      try
+      {
+        setTradingPhase( TradingSchedule::toTradingPhase( argument ) ) ;
+      }
+      catch( std::exception &e )
+      {
+        std::cout << e.what() << std::endl ;
+      }
+    }
     else
     {
       std::cout << "The commands you can use are : \n"
                 << " q/quit : Quit the application. This will cancel all pending orders \n"
                 << " stop   : Cancel pending orders and do not accept new orders \n"
                 << " start  : Begin accepting new orders. Used after stop \n"
+                << " kill <session>   : Cancel the orders of a session and reject its new orders \n"
+                << " resume <session> : Accept orders from a killed session again \n"
+                << " phase <call|continuous|closed> : Change the trading phase, "
+                   "leaving a call uncrosses the books \n"
+                << " latency : Print the latency of every stage of an order, "
+                   "when built with LATENCY_HISTOGRAMS \n"
+                << " bars <security> [seconds] : Print the last bars of a security, "
+                   "when UMATCH.bar_intervals is set \n"
                 << std::endl ;
     }
 
@@ -120,42 +528,118 @@ namespace ESM
     }
   }
 
-  void Market::sendMarketPicture()
+  void Market::setBarIntervals( const std::vector< long > &intervals,
+                                size_t history )
   {
-    int i ;
+    _barAggregator.start( intervals, history ) ;
+  }
+
+  void Market::printBars( const std::string &securityId, long interval )
+  {
+    const std::vector< long > &intervals = _barAggregator.getIntervals() ;
+    if( intervals.empty() )
+    {
+      std::cout << "No bars are kept" << std::endl ;
+      return ;
+    }
+
+    std::vector< Bars::Record > bars ;
+    if( !getBars( securityId, interval > 0 ? interval : intervals.front(), bars ) )
+    {
+      std::cout << "No bars of " << securityId << std::endl ;
+      return ;
+    }
+
+    std::cout << "start open high low close volume vwap trades" << std::endl ;
+    for( size_t i = 0 ; i < bars.size() ; ++i )
+    {
+      time_t start = bars[i].getStartTime() / 1000 ;
+      char text[ 32 ] ;
+      strftime( text, sizeof( text ), "%H:%M:%S", localtime( &start ) ) ;
+      std::cout << text << " " << bars[i].getOpenPrice()
+                << " " << bars[i].getHighPrice()
+                << " " << bars[i].getLowPrice()
+                << " " << bars[i].getClosePrice()
+                << " " << bars[i].getVolume()
+                << " " << bars[i].getWeightedAvgPrice()
+                << " " << bars[i].getNoOfTrades() << std::endl ;
+    }
+    std::cout << _barAggregator.getDropped() << " trades dropped" << std::endl ;
+  }
+
+  void Market::setMarketDataThreads( int marketDataThreads )
+  {
+    _marketDataThreads = std::max( 1, std::min( marketDataThreads,
+                                   static_cast< int >( MaxMarketDataThreads ) ) ) ;
+  }
+
+  void Market::sendMarketPicture( int marketDataThread )
+  {
+    std::vector< OrderBook * > dirtyBooks ;
+    MarketPicture marketPicture ;
     while( true )
     {
-      for( i = _orderBooksForMarketPicture.size() - 1; i >= 0 ; i -- )
+      const int marketDataThreads = _marketDataThreads ;
+      if( marketDataThread == 0 )
       {
-        if( _orderBooksForMarketPicture[i]->hasChanged() )
+        while( _marketDataThreadsStarted < marketDataThreads )
         {
-          _marketPicture.addRecord(
-            _orderBooksForMarketPicture[i]->getMarketPictureRecord()
-            ) ;
-
-          if( _marketPicture.getNoOfRecs() == MarketPicture::MaxNoOfRecs )
-          {
-#ifdef UDP_MARKET_DATA
-            _udpSender.send( _marketPicture ) ;
-#else
-            _mdApplication->send( _marketPicture );
-#endif
-            _marketPicture.reset() ;
-          }
+          boost::thread marketPictureThread( &Market::sendMarketPicture,
+                                             this, _marketDataThreadsStarted ) ;
+          ++_marketDataThreadsStarted ;
         }
       }
 
-      if( _marketPicture.getNoOfRecs() > 0 )
+      // Threads beyond the number wanted now idle until it grows again.
+      MarketDataPublisher *publisher = _marketDataPublisher ;
+      if( publisher != 0 && marketDataThread < marketDataThreads )
       {
-#ifdef UDP_MARKET_DATA
-            _udpSender.send( _marketPicture ) ;
-#else
-            _mdApplication->send( _marketPicture );
-#endif
-        _marketPicture.reset() ;
+        for( int i = marketDataThread ;
+             i < MarketDataPartitions ;
+             i += marketDataThreads )
+        {
+          sendPartition( *publisher, _marketDataPartitions[ i ],
+                         marketPicture, dirtyBooks ) ;
+        }
       }
 
       boost::this_thread::sleep(boost::posix_time::seconds(1));
     }
   }
+
+  void Market::sendPartition( MarketDataPublisher &publisher,
+                              MarketDataPartition &partition,
+                              MarketPicture &marketPicture,
+                              std::vector< OrderBook * > &dirtyBooks )
+  {
+    // Taken by the thread it used to belong to when the number changed.
+    if( partition.busy.exchange( true, boost::memory_order_acquire ) )
+    {
+      return ;
+    }
+
+    // Only the books which changed, however many there are.
+    dirtyBooks.clear() ;
+    partition.dirtyBooks.take( dirtyBooks ) ;
+
+    MarketPicture::Record record ;
+    marketPicture.setSlotNo( &partition - _marketDataPartitions ) ;
+    for( size_t i = 0 ; i < dirtyBooks.size() ; ++i )
+    {
+      dirtyBooks[i]->refreshIndicative() ;
+      dirtyBooks[i]->getMarketPictureRecord( record ) ;
+      marketPicture.addRecord( record ) ;
+
+      if( marketPicture.getNoOfRecs() == MarketPicture::MaxNoOfRecs
+          || i + 1 == dirtyBooks.size() )
+      {
+        marketPicture.setSequenceNo( ++partition.sequenceNo ) ;
+        publisher.send( marketPicture ) ;
+        marketPicture.reset() ;
+      }
+    }
+
+    partition.busy.store( false, boost::memory_order_release ) ;
+  }
+
 }
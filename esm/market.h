@@ -1,9 +1,13 @@
 #ifndef ESM_MARKET_H
 #define ESM_MARKET_H
 
+#include <set>
+#include <boost/atomic.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "marketDataPublisher.h"
 #include "orderBook.h"
-#include "udpSender.h"
-#include "fixMarketDataHandler.h"
+#include "tradingSchedule.h"
 
 namespace ESM
 {
@@ -14,6 +18,9 @@ namespace ESM
    * If a new order is placed for a security id that is not associated with
    * the order book, it's order book is created.
    * Cancels & Replaces, on the other hand, are rejected.
+   *
+   * The market has no FIX dependency: replies go to an execution sink and
+   * snapshots to a market data publisher, both given by the application.
    */
   class Market
   {
@@ -21,18 +28,10 @@ namespace ESM
       /**
        * @brief Constructor to create a new instance of the market.
        *
-       * @param The application whose methods will be called when we wish to
+       * @param The sink whose methods will be called when we wish to
        *          send a confirmation back.
-       *
-       * @param If market data is enabled, the host to whom the data will be
-       *          sent.
-       *
-       * @param If market data is enabled, the port on which data will be
-       *          sent.
        */
-      Market( ReplyApplication &replyApplication,
-              const std::string &address,
-              const std::string &port) ;
+      explicit Market( ExecutionSink &executionSink ) ;
 
       /**
        * @brief Find the order book and insert the order into that order book.
@@ -42,6 +41,14 @@ namespace ESM
        */
       void insert( NewOrderPtr order ) ;
 
+      /**
+       * @brief Insert a list of new orders. The list is split by instrument
+       *        once and each order book takes its share in a single pass.
+       *
+       * @param The orders to be inserted.
+       */
+      void insert( const std::vector< NewOrderPtr > &orders ) ;
+
       /**
        * @brief Replace an order on the order book.
        *
@@ -56,6 +63,95 @@ namespace ESM
        */
       void cancel( CancelOrderPtr order ) ;
 
+      /**
+       * @brief Cancel all the orders of a sender.
+       *
+       * @param The sender whose orders will be cancelled.
+       * @param Restrict to this security id. Empty for all order books.
+       * @param Cancel the buy orders.
+       * @param Cancel the sell orders.
+       *
+       * @return The number of orders cancelled.
+       */
+      long massCancel( const std::string &senderId,
+                       const std::string &securityId,
+                       bool buys,
+                       bool sells ) ;
+
+      /**
+       * @brief Get the circuit limits of an instrument, to be read by the
+       * risk gate. They are set by the order book once it exists.
+       *
+       * @param The security id.
+       */
+      const PriceBand &getPriceBand( const std::string &securityId ) ;
+
+      /**
+       * @brief Answer an order status request.
+       *
+       * @param The order whose status is requested.
+       */
+      void sendStatus( OrderPtr order ) ;
+
+      /**
+       * @brief Cancel all the orders of a sender, e.g. when its session
+       *        disconnects. Only the order books the sender has used are
+       *        visited, each one once.
+       *
+       * @param The sender whose orders will be cancelled.
+       * @param The text sent with the cancel confirmations.
+       *
+       * @return The number of orders cancelled.
+       */
+      long cancelAll( const std::string &senderId,
+                      const std::string &reason ) ;
+
+      /**
+       * @brief Kill switch. Cancel all the orders of a sender and reject
+       *        its new orders until resume() is called.
+       *
+       *        An order that is already being inserted when the switch is
+       *        thrown can still rest on its book.
+       *
+       * @param The sender to be stopped.
+       *
+       * @return The number of orders cancelled.
+       */
+      long kill( const std::string &senderId ) ;
+
+      /**
+       * @brief Accept new orders again from a sender that was killed.
+       *
+       * @param The sender.
+       */
+      void resume( const std::string &senderId ) ;
+
+      /**
+       * @brief Move every order book to a trading phase. Books leaving a
+       *        call auction are uncrossed. New books start in this phase.
+       *
+       * @param The new phase.
+       */
+      void setTradingPhase( TradingPhase tradingPhase ) ;
+
+      /**
+       * @brief Follow a schedule of trading phases. A thread moves the
+       *        market to the phase of the schedule whenever it changes; a
+       *        phase set by hand holds until the next change.
+       *
+       * @param The schedule.
+       */
+      void setTradingSchedule( const TradingSchedule &tradingSchedule ) ;
+
+      /**
+       * @brief Expire DAY orders at a local time of day. Orders placed
+       *        after it expire at the same time the next day. Without a
+       *        session end DAY orders rest until cancelled.
+       *
+       * @param The time of day.
+       */
+      void setSessionEnd( const boost::posix_time::time_duration &sessionEnd ) ;
+
       /**
        * @brief Provide a console based ui to the user.
        */
@@ -68,12 +164,78 @@ namespace ESM
        */
       bool executeCommand( const std::string &command ) ;
 
-#ifndef UDP_MARKET_DATA
-      void setMarketDataApplication(MarketDataApplication* app)
+      /**
+       * @brief A hash of every order book, by security id, to compare the
+       *        state of two runs.
+       *
+       * @param The number of order books is stored here.
+       */
+      size_t getChecksum( size_t &orderBooks ) ;
+
+      /**
+       * @brief Copy the last snapshot of an order book, without waiting for
+       *        the book.
+       *
+       * @param The security id.
+       * @param The snapshot is copied here.
+       *
+       * @return False if the book does not exist yet.
+       */
+      bool getMarketPictureRecord( const std::string &securityId,
+                                   MarketPicture::Record &record ) ;
+
+      /**
+       * @brief Send the snapshots to a publisher. Without one the order
+       *        books are not snapshot.
+       */
+      void setMarketDataPublisher( MarketDataPublisher *marketDataPublisher )
       {
-        _mdApplication = app;
+        _marketDataPublisher = marketDataPublisher ;
+        _barAggregator.setPublisher( marketDataPublisher ) ;
+      }
+
+      /**
+       * @brief Build and send the snapshots from several threads, each
+       *        taking its own partitions of the order books, so that the
+       *        books of one instrument are always sent in order. 1 by
+       *        default; may be changed at any time.
+       *
+       * @param The number of threads, at most MaxMarketDataThreads.
+       */
+      void setMarketDataThreads( int marketDataThreads ) ;
+
+      /**
+       * The order books are split in this many partitions for the market
+       * picture, each numbering its own messages.
+       */
+      enum { MarketDataPartitions = 64, MaxMarketDataThreads = 64 } ;
+
+      /**
+       * @brief Keep bars of the trades of every instrument, sent to the
+       *        market data publisher as they close. Call before the first
+       *        order.
+       *
+       * @param The intervals in seconds.
+       * @param How many bars are kept for each instrument & interval.
+       */
+      void setBarIntervals( const std::vector< long > &intervals,
+                            size_t history ) ;
+
+      /**
+       * @brief Copy the last bars of an instrument, oldest first.
+       *
+       * @param The security id.
+       * @param The interval in seconds.
+       * @param The bars are appended here.
+       *
+       * @return False if there are none.
+       */
+      bool getBars( const std::string &securityId,
+                    long interval,
+                    std::vector< Bars::Record > &bars )
+      {
+        return _barAggregator.getBars( securityId, interval, bars ) ;
       }
-#endif
 
       /**
        * @brief Start accepting orders.
@@ -88,9 +250,9 @@ namespace ESM
 
     private :
       /**
-       * The application which will send the confirmations to the client.
+       * Where the confirmations to the client are sent.
        */
-      ReplyApplication &_replyApplication ;
+      ExecutionSink &_executionSink ;
 
       /**
        * The list of order books maintained by this market.
@@ -99,15 +261,39 @@ namespace ESM
       OrderBooksMap _orderBooks ;
 
       /**
-       * A market picture a.k.a snapshot which will be sent out periodically.
+       * The circuit limits of every instrument, created with the order book
+       * or when the risk gate first asks for them.
+       */
+      typedef boost::unordered_map< std::string, PriceBandPtr > PriceBandsMap ;
+      PriceBandsMap _priceBands ;
+
+      /**
+       * The phase new order books start in.
+       */
+      TradingPhase _tradingPhase ;
+
+      TradingSchedule _tradingSchedule ;
+
+      boost::posix_time::time_duration _sessionEnd ;
+
+      /**
+       * The expire time given to DAY orders, the next session end in
+       * seconds since the epoch. 0 if there is no session end.
        */
-      MarketPicture _marketPicture ;
+      boost::atomic< long > _dayExpireTime ;
 
       /**
        * Make sure that two threads do not try to create the same order book.
+       * Also protects _priceBands & _tradingPhase.
        */
       boost::mutex _mutexForNewBook ;
 
+      /**
+       * @brief Find or create the price band of an instrument.
+       *        The caller must hold _mutexForNewBook.
+       */
+      PriceBand &findOrCreatePriceBand( const std::string &securityId ) ;
+
       /**
        * A pointer to the order books which will be used to create the
        * snapshot.
@@ -115,15 +301,133 @@ namespace ESM
       std::vector< OrderBookPtr > _orderBooksForMarketPicture ;
 
       /**
-       * @brief Send the market picture to the server on the port.
+       * A partition of the order books for the market picture: the books
+       * whose snapshot changed since it was last sent, and the sequence
+       * number of its messages. Only the thread holding busy sends it.
+       */
+      struct MarketDataPartition
+      {
+        MarketDataPartition() : busy( false ), sequenceNo( 0 ) {}
+
+        UT::DirtyQueue< OrderBook > dirtyBooks ;
+        boost::atomic< bool > busy ;
+        short sequenceNo ;
+      };
+      MarketDataPartition _marketDataPartitions[ MarketDataPartitions ] ;
+
+      /**
+       * The order books in which each sender has placed orders, so that the
+       * orders of a session can be cancelled without visiting every book.
+       */
+      typedef std::set< OrderBookPtr > OrderBookSet ;
+      typedef boost::unordered_map< std::string, OrderBookSet >
+        OrderBooksBySessionMap ;
+      OrderBooksBySessionMap _orderBooksBySession ;
+
+      /**
+       * Senders stopped by the kill switch.
+       */
+      boost::unordered_set< std::string > _killedSessions ;
+
+      /**
+       * Protects _orderBooksBySession & _killedSessions.
        */
-      void sendMarketPicture() ;
+      boost::mutex _mutexForSessions ;
 
-#ifdef UDP_MARKET_DATA
-      UdpSender _udpSender ;
-#else
-      MarketDataApplication* _mdApplication;
-#endif
+      /**
+       * @brief Remember that a sender uses an order book.
+       *
+       * @param The sender of a new order.
+       * @param The order book of the order.
+       *
+       * @return False if the sender has been killed and the order must be
+       *         rejected.
+       */
+      bool addSessionOrderBook( const std::string &senderId,
+                                const OrderBookPtr &orderBook ) ;
+
+      /**
+       * @brief Cancel the orders of a sender in all the order books it uses.
+       */
+      long cancelSessionOrders( const std::string &senderId,
+                                bool buys,
+                                bool sells,
+                                const std::string &reason ) ;
+
+      /**
+       * @brief Find the order book of an order, creating it if it does not
+       *        exist.
+       *
+       * @param The order whose book we need.
+       */
+      OrderBookPtr findOrCreateOrderBook( OrderPtr order ) ;
+
+      /**
+       * @brief The loop following the trading schedule.
+       */
+      void runTradingSchedule() ;
+
+      /**
+       * The order books whose next expiry came earlier, taken by the
+       * expiry thread.
+       */
+      ExpiryQueue _expiryBooks ;
+
+      /**
+       * @brief The loop expiring orders, once a second, in the books with
+       *        orders due only.
+       */
+      void runExpiry() ;
+
+      /**
+       * @brief The next session end after a time.
+       *
+       * @param Seconds since the epoch.
+       */
+      long getNextSessionEnd( long now ) const ;
+
+      /**
+       * @brief Give a DAY order the expire time of the session.
+       */
+      void setDayExpireTime( const OrderPtr &order ) ;
+
+      /**
+       * @brief The loop of a market picture thread. The first one starts
+       *        the others.
+       *
+       * @param The number of the thread, from 0.
+       */
+      void sendMarketPicture( int marketDataThread ) ;
+
+      /**
+       * @brief Send the changed books of a partition, unless another
+       *        thread is sending it.
+       *
+       * @param Where the market picture goes.
+       * @param The partition.
+       * @param The market picture to fill.
+       * @param Scratch space for the books.
+       */
+      void sendPartition( MarketDataPublisher &publisher,
+                          MarketDataPartition &partition,
+                          MarketPicture &marketPicture,
+                          std::vector< OrderBook * > &dirtyBooks ) ;
+
+      MarketDataPublisher *_marketDataPublisher ;
+
+      BarAggregator _barAggregator ;
+
+      /**
+       * @brief Print the bars of an instrument on the console.
+       */
+      void printBars( const std::string &securityId, long interval ) ;
+
+      boost::atomic< int > _marketDataThreads ;
+
+      /**
+       * The market picture threads started so far, by the first one.
+       */
+      int _marketDataThreadsStarted ;
   };
 }
 #endif // ESM_MARKET_H
@@ -0,0 +1,36 @@
+#ifndef ESM_MARKET_DATA_PUBLISHER_H
+#define ESM_MARKET_DATA_PUBLISHER_H
+
+#include "structures.h"
+
+namespace ESM
+{
+  /**
+   * \class MarketDataPublisher
+   *
+   * Where the market sends its snapshots: on UDP, to FIX market data
+   * sessions, or anywhere an embedding application wants them.
+   *
+   */
+  class MarketDataPublisher
+  {
+    public :
+      virtual ~MarketDataPublisher() {}
+
+      /**
+       * @brief Publish the records of the order books that changed.
+       *
+       * @param The snapshot, reset once this returns.
+       */
+      virtual void send( const MarketPicture &message ) = 0 ;
+
+      /**
+       * @brief Publish the bars which closed. Ignored unless overridden.
+       *
+       * @param The bars, reset once this returns.
+       */
+      virtual void sendBars( const Bars & ) {}
+  };
+}
+
+#endif // ESM_MARKET_DATA_PUBLISHER_H
@@ -2,16 +2,43 @@
 #ifndef ESM_ORDER_H
 #define ESM_ORDER_H
 
+#include <iomanip>
 #include <string>
+#include <boost/atomic.hpp>
+#include <boost/intrusive/list.hpp>
 
 #include "../common/errorlog.h"
 #include "exceptions.h"
+#include "instrument.h"
+#include "riskGate.h"
 #include "structures.h"
 
 #include "../common/uniqueOrderId.h"
 
 namespace ESM
 {
+  /**
+   * Numeric inside the engine, formatted only for the clients.
+   */
+  typedef UT::OrderId OrderId ;
+
+  /**
+   * Links an order into the list of live orders of its session, kept by the
+   * order list it rests in. The order unlinks itself if it is destroyed
+   * while still on the list.
+   */
+  typedef boost::intrusive::list_base_hook<
+            boost::intrusive::link_mode< boost::intrusive::auto_unlink >
+          > SessionOrderHook ;
+
+  /**
+   * Links an order into a slot of its order book's expiry wheel while it
+   * rests with an expire time.
+   */
+  typedef boost::intrusive::list_member_hook<
+            boost::intrusive::link_mode< boost::intrusive::auto_unlink >
+          > ExpiryHook ;
+
   /**
    * \class Order
    *
@@ -19,10 +46,10 @@ namespace ESM
    *
    */
 
-  class Order
+  class Order : public SessionOrderHook
   {
     public :
-      Order( const std::string &orderId,
+      Order( OrderId orderId,
              const std::string &securityId,
              const std::string &clientOrderId,
              const std::string &senderId,
@@ -39,14 +66,21 @@ namespace ESM
           _orderType( orderType ),
           _orderQty( orderQty ),
           _timeInForce( TimeInForce_DAY ),
+          _instrument( &Instruments::get( securityId ) ),
           _price( 0 ),
+          _tick( 0 ),
           _stopPrice( 0 ),
           _filledQty( 0 ),
           _disclosedPendingQty( orderQty ) ,
           _avgPrice( 0 ),
           _lastPrice( 0 ),
           _lastShares( 0 ),
-          _disclosedQty( orderQty )
+          _disclosedQty( orderQty ),
+          _isAccepted( false ),
+          _risk( 0 ),
+          _isFinished( false ),
+          _expireTime( 0 ),
+          _minQty( 0 )
       {
       }
 
@@ -58,6 +92,10 @@ namespace ESM
       void fill( long price, long qty);
 
       void trigger()  ;
+      void accept() { _isAccepted = true ; }
+      void finish() ;
+      bool isFinished() const { return _isFinished.load( boost::memory_order_relaxed ) ; }
+      void setRisk( InstrumentRisk *risk ) ;
       void setMarketToLimit( long price ) ;
       void print() ;
 
@@ -69,11 +107,29 @@ namespace ESM
       long getOrderQty() const { return _orderQty ; }
       TimeInForce getTimeInForce() const { return _timeInForce; }
 
-      const std::string &getOrderId() const { return _orderId ; }
+      /**
+       * Seconds since the epoch at which a resting order is cancelled,
+       * 0 if it does not expire.
+       */
+      long getExpireTime() const { return _expireTime ; }
+
+      /**
+       * The quantity that must trade on entry for the order to be
+       * accepted: the order quantity for FOK, MinQty if set, else 0.
+       */
+      long getMinQty() const
+      {
+        return _timeInForce == TimeInForce_FOK ? _orderQty : _minQty ;
+      }
+
+      OrderId getOrderId() const { return _orderId ; }
       const std::string &getOriginalClientOrderId() const { return _originalClientOrderId ; }
 
+      const Instrument &getInstrument() const { return *_instrument ; }
+
       //primary keys
       long getPrice() const { return _price; }
+      long getTick() const { return _tick; }
       long getStopPrice() const { return _stopPrice; }
       long getAvgPrice() const { return _avgPrice; }
       long getLastPrice() const { return _lastPrice; }
@@ -82,10 +138,31 @@ namespace ESM
       long getPendingQty() const { return _disclosedPendingQty ; }
       long getActualPendingQty() const { return _orderQty - _filledQty ; }
       long getDisclosedQty() const { return _disclosedQty ; }
-
-      void setPrice( long price ) { _price = price ; }
-      void setStopPrice( long stopPrice ) { _stopPrice = stopPrice ; }
+      bool isAccepted() const { return _isAccepted ; }
+      OrderStatus getStatus() const ;
+
+      /**
+       * Prices are fixed-point, in the price scale of the instrument. They
+       * must be on the instrument's tick table, else InvalidPrice is thrown.
+       */
+      void setPrice( long price )
+      {
+        _tick = _instrument->toTick( price ) ;
+        _price = price ;
+      }
+      void setStopPrice( long stopPrice )
+      {
+        _instrument->toTick( stopPrice ) ;
+        _stopPrice = stopPrice ;
+      }
       void setTimeInForce( TimeInForce timeInForce ) { _timeInForce = timeInForce ; }
+      void setExpireTime( long expireTime ) { _expireTime = expireTime ; }
+      void setMinQty( long minQty ) { _minQty = minQty ; }
+
+      /**
+       * @brief Take the order off the expiry wheel, if it is on it.
+       */
+      void disarm() { _expiryHook.unlink() ; }
       void addOrderQty( long orderQty ) { _orderQty += orderQty ; }
       void setDisclosedQty( long disclosedQty )
       {
@@ -96,7 +173,7 @@ namespace ESM
     protected :
       std::string _originalClientOrderId ;
     private :
-      std::string _orderId ;
+      OrderId _orderId ;
       std::string _securityId ;
       std::string _clientOrderId ;
       std::string _senderId ;
@@ -105,8 +182,11 @@ namespace ESM
       long _orderQty ;
       TimeInForce _timeInForce ;
 
+      const Instrument *_instrument ;
+
       //primary keys
       long _price ;
+      long _tick ;
       long _stopPrice ;
       long _filledQty ;
       long _disclosedPendingQty ;
@@ -115,6 +195,31 @@ namespace ESM
       long _lastShares ;
       long _disclosedQty ;
 
+      /**
+       * Set when the order book confirms the order.
+       */
+      bool _isAccepted ;
+
+      /**
+       * The counters of the risk gate, set when the order passed it.
+       * _isFinished makes sure the order is taken out of the open orders
+       * only once, and is read by the session to forget the order.
+       */
+      InstrumentRisk *_risk ;
+      boost::atomic< bool > _isFinished ;
+
+      long _expireTime ;
+      ExpiryHook _expiryHook ;
+      friend class TimingWheel ;
+
+      long _minQty ;
+
+      /**
+       * @brief Add to the open quantity of the order's side in the risk
+       * counters, if it passed the risk gate.
+       */
+      void addOpenQty( long qty ) ;
+
       void setPendingQty()
       {
         _disclosedPendingQty = ( _disclosedQty > 0 &&
@@ -137,6 +242,7 @@ namespace ESM
       throw RejectReplace( "New order qty is less than filled qty" ) ;
     }
 
+    addOpenQty( order.getOrderQty() - _orderQty ) ;
     _orderQty = order.getOrderQty() ;
     _disclosedQty = order.getDisclosedQty() ;
     setPendingQty() ;
@@ -144,6 +250,7 @@ namespace ESM
     _originalClientOrderId = _clientOrderId ;
     _clientOrderId = order.getClientOrderId() ;
     _timeInForce = order.getTimeInForce() ;
+    _expireTime = order.getExpireTime() ;
 
     bool lostPriority = false ;
     if ( order.getOrderType() == OrderType_MARKET ||
@@ -156,6 +263,7 @@ namespace ESM
     {
       lostPriority = true ;
       _price = order.getPrice() ;
+      _tick = order.getTick() ;
     }
 
     if ( _orderType != order.getOrderType() )
@@ -188,6 +296,41 @@ namespace ESM
 
     setPendingQty() ;
 
+    if( _risk != 0 )
+    {
+      _risk->position.value.fetch_add( _side == Side_BUY ? qty : -qty,
+                                       boost::memory_order_relaxed ) ;
+      addOpenQty( -qty ) ;
+    }
+
+  }
+
+  /**
+   * Called when the client is told the order is done: filled, cancelled
+   * or rejected.
+   */
+  inline void Order::finish()
+  {
+    if( !_isFinished.exchange( true, boost::memory_order_relaxed ) && _risk != 0 )
+    {
+      _risk->openOrders.value.fetch_sub( 1, boost::memory_order_relaxed ) ;
+      addOpenQty( _filledQty - _orderQty ) ;
+    }
+  }
+
+  inline void Order::setRisk( InstrumentRisk *risk )
+  {
+    _risk = risk ;
+    addOpenQty( _orderQty - _filledQty ) ;
+  }
+
+  inline void Order::addOpenQty( long qty )
+  {
+    if( _risk != 0 )
+    {
+      ( _side == Side_BUY ? _risk->openBuyQty : _risk->openSellQty )
+        .value.fetch_add( qty, boost::memory_order_relaxed ) ;
+    }
   }
 
   inline void Order::trigger()
@@ -205,7 +348,24 @@ namespace ESM
   inline void Order::setMarketToLimit( long price )
   {
     _orderType = OrderType_LIMIT ;
-    _price = price ;
+    setPrice( price ) ;
+  }
+
+  /**
+   * Only valid while holding the order book of this order. An order is
+   * linked into its session list for as long as it rests in the book.
+   */
+  inline OrderStatus Order::getStatus() const
+  {
+    if( !_isAccepted )
+    {
+      return OrderStatus_REJECTED ;
+    }
+    if( is_linked() )
+    {
+      return _filledQty > 0 ? OrderStatus_PARTIALLY_FILLED : OrderStatus_NEW ;
+    }
+    return _filledQty == _orderQty ? OrderStatus_FILLED : OrderStatus_CANCELED ;
   }
 
   inline void Order::print()
@@ -250,7 +410,7 @@ namespace ESM
   class CancelReplaceOrder : public Order
   {
     public :
-      CancelReplaceOrder( const std::string &orderId,
+      CancelReplaceOrder( OrderId orderId,
                    const std::string &originalClientOrderId,
                    const std::string &securityId,
                    const std::string &clientOrderId,
@@ -273,6 +433,13 @@ namespace ESM
   typedef CancelReplaceOrder CancelOrder ;
   typedef CancelReplaceOrder ReplaceOrder ;
 
+  /**
+   * The live orders of one session in an order list.
+   */
+  typedef boost::intrusive::list< Order,
+            boost::intrusive::constant_time_size< false >
+          > SessionOrderList ;
+
   typedef boost::shared_ptr< Order > OrderPtr ;
   typedef boost::shared_ptr< NewOrder > NewOrderPtr ;
   typedef boost::shared_ptr< CancelOrder > CancelOrderPtr ;
@@ -1,7 +1,32 @@
+#include <ctime>
+#include <limits>
+#include <boost/functional/hash.hpp>
+
 #include "orderBook.h"
+#include "../common/latency.h"
 
 namespace ESM
 {
+  namespace
+  {
+    template< class List >
+    void hashOrders( size_t &seed, const List &orders )
+    {
+      for( typename List::const_iterator iOrder = orders.begin() ;
+           iOrder != orders.end() ;
+           ++iOrder )
+      {
+        const Order &order = *iOrder->second ;
+        boost::hash_combine( seed, iOrder->first ) ;
+        boost::hash_combine( seed, static_cast< int >( order.getSide() ) ) ;
+        boost::hash_combine( seed, order.getActualPendingQty() ) ;
+        boost::hash_combine( seed, order.getFilledQty() ) ;
+        boost::hash_combine( seed, order.getClientOrderId() ) ;
+        boost::hash_combine( seed, order.getSenderId() ) ;
+      }
+    }
+  }
+
   void OrderBook::print()
   {
     std::cout << "============== buy ============= " << std::endl ;
@@ -10,10 +35,26 @@ namespace ESM
     _sellOrders.print() ;
   }
 
-  OrderBook::OrderBook( ReplyApplication &replyApplication, OrderPtr order )
-    : _replyApplication( replyApplication ),
+  OrderBook::OrderBook( ExecutionSink &executionSink,
+                        OrderPtr order,
+                        PriceBand &priceBand,
+                        TradingPhase tradingPhase,
+                        UT::DirtyQueue< OrderBook > *dirtyBooks,
+                        BarAggregator *barAggregator,
+                        ExpiryQueue *expiryBooks )
+    : _executionSink( executionSink ),
     _hasChanged( false ),
-    _isActive( true )
+    _dirtyBooks( dirtyBooks ),
+    _barAggregator( barAggregator ),
+    _barSeries( barAggregator != 0
+                ? barAggregator->getSeries( order->getSecurityId() ) : 0 ),
+    _isActive( tradingPhase != TradingPhase_CLOSED ),
+    _tradingPhase( tradingPhase ),
+    _isIndicativeStale( tradingPhase == TradingPhase_CALL_AUCTION ),
+    _instrument( order->getInstrument() ),
+    _expiryWheel( time( 0 ) ),
+    _expiryBooks( expiryBooks ),
+    _nextExpiry( 0 )
   {
     _marketPictureRecord.setScripCodeFromString( order->getSecurityId() ) ;
 
@@ -23,12 +64,86 @@ namespace ESM
     _marketPictureRecord.setLowPrice( order->getPrice() ) ;
     _marketPictureRecord.setLowerCktLimit( order->getPrice() * 9 / 10) ;
     _marketPictureRecord.setUpperCktLimit( order->getPrice() * 11 / 10) ;
+
+    priceBand.lower.value.store( _marketPictureRecord.getLowerCktLimit() ) ;
+    priceBand.upper.value.store( _marketPictureRecord.getUpperCktLimit() ) ;
+
+    _marketPictureRecord.setTradingPhase( tradingPhase ) ;
+
+    _hasChanged = true ;
+    publish() ;
   }
 
   void OrderBook::insert( OrderPtr order )
+  {
+    Transaction transaction( *this ) ;
+
+    LATENCY_SCOPE( MATCH ) ;
+    insertOrder( order ) ;
+  }
+
+  void OrderBook::insert( const std::vector< OrderPtr > &orders )
+  {
+    Transaction transaction( *this ) ;
+
+    for( std::vector< OrderPtr >::const_iterator iOrder = orders.begin() ;
+         iOrder != orders.end() ;
+         ++iOrder )
+    {
+      LATENCY_SCOPE( MATCH ) ;
+      insertOrder( *iOrder ) ;
+    }
+  }
+
+  void OrderBook::insertOrder( OrderPtr order )
   {
     if( _isActive )
     {
+      if( _tradingPhase == TradingPhase_CALL_AUCTION
+          && ( order->getOrderType() == OrderType_MARKET
+               || order->getTimeInForce() == TimeInForce_IOC
+               || order->getMinQty() > 0 ) )
+      {
+        _executionSink.sendNewReject( order,
+            "Market, IOC, FOK & MinQty orders are not accepted during the "
+            "call auction" ) ;
+        return ;
+      }
+
+      if( order->getTimeInForce() == TimeInForce_GTD
+          && order->getExpireTime() == 0 )
+      {
+        _executionSink.sendNewReject( order, "GTD Order Without ExpireTime" ) ;
+        return ;
+      }
+      if( order->getExpireTime() > 0 && order->getExpireTime() <= time( 0 ) )
+      {
+        _executionSink.sendNewReject( order, "Order Has Already Expired" ) ;
+        return ;
+      }
+
+      if( order->getMinQty() > 0 )
+      {
+        if( order->getMinQty() > order->getOrderQty() )
+        {
+          _executionSink.sendNewReject( order, "MinQty Is More Than OrderQty" ) ;
+          return ;
+        }
+        if( order->getOrderType() == OrderType_STOP
+            || order->getOrderType() == OrderType_STOP_LIMIT )
+        {
+          _executionSink.sendNewReject( order,
+              "FOK & MinQty are not accepted on stop orders" ) ;
+          return ;
+        }
+        if( !isMinQtyAvailable( order ) )
+        {
+          _executionSink.sendNewReject( order,
+              "Not Enough Quantity Available To Fill MinQty" ) ;
+          return ;
+        }
+      }
+
       try
       {
         switch( order->getOrderType() )
@@ -39,16 +154,18 @@ namespace ESM
               switch( order->getSide() )
               {
                 case Side_BUY :
-                  _replyApplication.sendNewConfirm( order ) ;
+                  order->accept() ;
+                  _executionSink.sendNewConfirm( order ) ;
                   insertBuy( order ) ;
                   break ;
                 case Side_SELL_SHORT :
                 case Side_SELL :
-                  _replyApplication.sendNewConfirm( order ) ;
+                  order->accept() ;
+                  _executionSink.sendNewConfirm( order ) ;
                   insertSell( order ) ;
                   break ;
                 default :
-                  _replyApplication.sendNewReject( order, "Unknown Side" ) ;
+                  _executionSink.sendNewReject( order, "Unknown Side" ) ;
               }
             }
             break ;
@@ -59,41 +176,58 @@ namespace ESM
               switch( order->getSide() )
               {
                 case Side_BUY :
-                  _replyApplication.sendNewConfirm( order ) ;
+                  order->accept() ;
+                  _executionSink.sendNewConfirm( order ) ;
                   insertStopLossBuy( order ) ;
                   break ;
                 case Side_SELL_SHORT :
                 case Side_SELL :
-                  _replyApplication.sendNewConfirm( order ) ;
+                  order->accept() ;
+                  _executionSink.sendNewConfirm( order ) ;
                   insertStopLossSell( order ) ;
                   break ;
                 default :
-                  _replyApplication.sendNewReject( order, "Unknown Side" ) ;
+                  _executionSink.sendNewReject( order, "Unknown Side" ) ;
               }
             }
             break ;
           default:
-            _replyApplication.sendNewReject( order, "Unknown Order Type" ) ;
+            _executionSink.sendNewReject( order, "Unknown Order Type" ) ;
         }
       }
       catch( std::exception &e )
       {
-        _replyApplication.sendNewReject( order, e.what() ) ;
+        _executionSink.sendNewReject( order, e.what() ) ;
       }
 
       _hasChanged = true ;
     }
     else
     {
-      _replyApplication.sendNewReject( order,
+      _executionSink.sendNewReject( order,
           "You cant place new orders as the market is closed" ) ;
     }
   }
 
   void OrderBook::replace( OrderPtr order )
   {
+    Transaction transaction( *this ) ;
+    LATENCY_SCOPE( MATCH ) ;
+
     if( _isActive )
     {
+      if( order->getTimeInForce() == TimeInForce_GTD
+          && order->getExpireTime() == 0 )
+      {
+        _executionSink.sendReplaceReject( order, "GTD Order Without ExpireTime" ) ;
+        return ;
+      }
+      if( order->getTimeInForce() == TimeInForce_FOK )
+      {
+        _executionSink.sendReplaceReject( order, "Cannot Replace To FOK" ) ;
+        return ;
+      }
+
       try
       {
         switch( order->getOrderType() )
@@ -113,29 +247,32 @@ namespace ESM
                   replaceSell( order ) ;
                   break ;
                 default :
-                  _replyApplication.sendReplaceReject( order, "Unknown Side" ) ;
+                  _executionSink.sendReplaceReject( order, "Unknown Side" ) ;
               }
             }
             break ;
           default :
-            _replyApplication.sendReplaceReject( order, "Unknown Order Type" ) ;
+            _executionSink.sendReplaceReject( order, "Unknown Order Type" ) ;
         }
       }
       catch( std::exception &e )
       {
-        _replyApplication.sendReplaceReject( order, e.what() ) ;
+        _executionSink.sendReplaceReject( order, e.what() ) ;
       }
       _hasChanged = true ;
     }
     else
     {
-      _replyApplication.sendNewReject( order,
+      _executionSink.sendNewReject( order,
           "You cant replace orders as the market is closed" ) ;
     }
   }
 
   void OrderBook::cancel( OrderPtr order )
   {
+    Transaction transaction( *this ) ;
+    LATENCY_SCOPE( MATCH ) ;
+
     try
     {
       OrderPtr canceledOrder ;
@@ -149,17 +286,17 @@ namespace ESM
             {
               case Side_BUY :
                 canceledOrder = _buyOrders.cancel( order ) ;
-                _replyApplication.sendCancelConfirm( canceledOrder,
+                _executionSink.sendCancelConfirm( canceledOrder,
                     "Order Cancelled Successfully" ) ;
                 break ;
               case Side_SELL_SHORT :
               case Side_SELL :
                 canceledOrder = _sellOrders.cancel( order ) ;
-                _replyApplication.sendCancelConfirm( canceledOrder,
+                _executionSink.sendCancelConfirm( canceledOrder,
                     "Order Cancelled Successfully" ) ;
                 break ;
               default :
-                _replyApplication.sendCancelReject( order, "Unknown Side" ) ;
+                _executionSink.sendCancelReject( order, "Unknown Side" ) ;
             }
           }
           break ;
@@ -171,42 +308,171 @@ namespace ESM
             {
               case Side_BUY :
                 canceledOrder = _stopLossBuyOrders.cancel( order ) ;
-                _replyApplication.sendCancelConfirm( canceledOrder,
+                _executionSink.sendCancelConfirm( canceledOrder,
                     "Order Cancelled Successfully" ) ;
                 break ;
               case Side_SELL_SHORT :
               case Side_SELL :
                 canceledOrder = _stopLossSellOrders.cancel( order ) ;
-                _replyApplication.sendCancelConfirm( canceledOrder,
+                _executionSink.sendCancelConfirm( canceledOrder,
                     "Order Cancelled Successfully" ) ;
                 break ;
               default :
-                _replyApplication.sendCancelReject( order, "Unknown Side" ) ;
+                _executionSink.sendCancelReject( order, "Unknown Side" ) ;
             }
           }
           break ;
         default:
-          _replyApplication.sendCancelReject( order, "Unknown Order Type" ) ;
+          _executionSink.sendCancelReject( order, "Unknown Order Type" ) ;
       }
     }
     catch( std::exception &e )
     {
-      _replyApplication.sendCancelReject( order, e.what() ) ;
+      _executionSink.sendCancelReject( order, e.what() ) ;
     }
     _hasChanged = true ;
   }
 
+  size_t OrderBook::getChecksum()
+  {
+    boost::mutex::scoped_lock lock( _mutexOnMatch ) ;
+
+    size_t seed = 0 ;
+    hashOrders( seed, _buyOrders ) ;
+    hashOrders( seed, _sellOrders ) ;
+    hashOrders( seed, _stopLossBuyOrders ) ;
+    hashOrders( seed, _stopLossSellOrders ) ;
+    return seed ;
+  }
+
+  long OrderBook::massCancel( const std::string &senderId,
+                              bool buys,
+                              bool sells,
+                              const std::string &reason )
+  {
+    Transaction transaction( *this ) ;
+
+    std::vector< OrderPtr > canceledOrders ;
+    if( buys )
+    {
+      _buyOrders.eraseBySender( senderId, canceledOrders ) ;
+      _stopLossBuyOrders.eraseBySender( senderId, canceledOrders ) ;
+    }
+    if( sells )
+    {
+      _sellOrders.eraseBySender( senderId, canceledOrders ) ;
+      _stopLossSellOrders.eraseBySender( senderId, canceledOrders ) ;
+    }
+
+    sendCancelConfirms( canceledOrders, reason ) ;
+
+    if( !canceledOrders.empty() )
+    {
+      _hasChanged = true ;
+    }
+    return canceledOrders.size() ;
+  }
+
+  void OrderBook::sendStatus( OrderPtr order )
+  {
+    boost::mutex::scoped_lock lock( _mutexOnMatch ) ;
+
+    _executionSink.sendOrderStatus( order ) ;
+  }
+
+  bool OrderBook::isMinQtyAvailable( const OrderPtr &order ) const
+  {
+    bool isMarket = order->getOrderType() == OrderType_MARKET ;
+    if( order->getSide() == Side_BUY )
+    {
+      long tick = isMarket ? std::numeric_limits< long >::max() : order->getTick() ;
+      return _sellOrders.getQtyUpTo( tick, order->getMinQty() ) >= order->getMinQty() ;
+    }
+    long tick = isMarket ? std::numeric_limits< long >::min() : order->getTick() ;
+    return _buyOrders.getQtyUpTo( tick, order->getMinQty() ) >= order->getMinQty() ;
+  }
+
+  void OrderBook::armExpiry( const OrderPtr &order )
+  {
+    if( order->getExpireTime() > 0 )
+    {
+      _expiryWheel.arm( *order ) ;
+
+      long nextExpiry = _nextExpiry.load( boost::memory_order_relaxed ) ;
+      if( nextExpiry == 0 || order->getExpireTime() < nextExpiry )
+      {
+        _nextExpiry.store( order->getExpireTime() ) ;
+        if( _expiryBooks != 0 )
+        {
+          _expiryBooks->push( this ) ;
+        }
+      }
+    }
+    else
+    {
+      order->disarm() ;
+    }
+  }
+
+  void OrderBook::expireOrders( long now )
+  {
+    Transaction transaction( *this ) ;
+
+    _expiredOrders.clear() ;
+    _expiryWheel.advance( now, _expiredOrders ) ;
+    _nextExpiry.store( _expiryWheel.getNextDue() ) ;
+
+    for( std::vector< Order * >::const_iterator iOrder = _expiredOrders.begin() ;
+         iOrder != _expiredOrders.end() ;
+         ++iOrder )
+    {
+      // The wheel holds no reference, the list hands back the one it had.
+      const Order &order = **iOrder ;
+      bool isStop = order.getOrderType() == OrderType_STOP
+                    || order.getOrderType() == OrderType_STOP_LIMIT ;
+      OrderPtr expiredOrder ;
+      if( order.getSide() == Side_BUY )
+      {
+        expiredOrder = isStop ? _stopLossBuyOrders.erase( order.getOrderId() )
+                              : _buyOrders.erase( order.getOrderId() ) ;
+      }
+      else
+      {
+        expiredOrder = isStop ? _stopLossSellOrders.erase( order.getOrderId() )
+                              : _sellOrders.erase( order.getOrderId() ) ;
+      }
+      _executionSink.sendCancelConfirm( expiredOrder, "Order Expired" ) ;
+    }
+
+    if( !_expiredOrders.empty() )
+    {
+      _hasChanged = true ;
+    }
+  }
+
+  void OrderBook::sendCancelConfirms( const std::vector< OrderPtr > &orders,
+                                      const std::string &reason )
+  {
+    for( std::vector< OrderPtr >::const_iterator iOrder = orders.begin() ;
+         iOrder != orders.end() ;
+         ++iOrder )
+    {
+      _executionSink.sendCancelConfirm( *iOrder, reason ) ;
+    }
+  }
+
   void OrderBook::insertStopLossBuy( OrderPtr order )
   {
     if( _marketPictureRecord.getLastTradePrice() >= order->getStopPrice() )
     {
       order->trigger();
-      _replyApplication.sendTriggered( order ) ;
+      _executionSink.sendTriggered( order ) ;
       insertBuy( order ) ;
     }
     else
     {
       _stopLossBuyOrders.insert( order->getStopPrice(), order ) ;
+      armExpiry( order ) ;
     }
   }
 
@@ -215,12 +481,13 @@ namespace ESM
     if( _marketPictureRecord.getLastTradePrice() <= order->getStopPrice() )
     {
       order->trigger();
-      _replyApplication.sendTriggered( order ) ;
+      _executionSink.sendTriggered( order ) ;
       insertSell( order ) ;
     }
     else
     {
       _stopLossSellOrders.insert( order->getStopPrice(), order ) ;
+      armExpiry( order ) ;
     }
   }
 
@@ -232,12 +499,13 @@ namespace ESM
       try
       {
         replacedOrder = _buyOrders.replace( newOrder ) ;
-        _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+        armExpiry( replacedOrder ) ;
+        _executionSink.sendReplaceConfirm( replacedOrder ) ;
       }
       catch( OrderHasChanged &e )
       {
         replacedOrder = _buyOrders.erase( newOrder->getOrderId() ) ;
-        _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+        _executionSink.sendReplaceConfirm( replacedOrder ) ;
 
         if( replacedOrder->getOrderType() == OrderType_STOP
             || replacedOrder->getOrderType() == OrderType_STOP_LIMIT )
@@ -252,13 +520,14 @@ namespace ESM
       catch( OrderIdNotFound &e )
       {
         replacedOrder = _stopLossBuyOrders.replace( newOrder );
-        _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+        armExpiry( replacedOrder ) ;
+        _executionSink.sendReplaceConfirm( replacedOrder ) ;
       }
     }
     catch( OrderHasChanged &e )
     {
       replacedOrder = _stopLossBuyOrders.erase( newOrder->getOrderId() ) ;
-      _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+      _executionSink.sendReplaceConfirm( replacedOrder ) ;
 
       if( replacedOrder->getOrderType() == OrderType_STOP
           || replacedOrder->getOrderType() == OrderType_STOP_LIMIT )
@@ -268,13 +537,13 @@ namespace ESM
     }
     catch( std::exception &e )
     {
-      _replyApplication.sendReplaceReject( newOrder, e.what() ) ;
+      _executionSink.sendReplaceReject( newOrder, e.what() ) ;
     }
 
     if( newOrder->getTimeInForce() == TimeInForce_IOC )
     {
       OrderPtr canceledOrder = _buyOrders.cancel( newOrder ) ;
-      _replyApplication.sendCancelConfirm(
+      _executionSink.sendCancelConfirm(
         canceledOrder,
         "IOC Order Cancelled Successfully"
         ) ;
@@ -289,12 +558,13 @@ namespace ESM
       try
       {
         replacedOrder = _sellOrders.replace( newOrder ) ;
-        _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+        armExpiry( replacedOrder ) ;
+        _executionSink.sendReplaceConfirm( replacedOrder ) ;
       }
       catch( OrderHasChanged &e )
       {
         replacedOrder = _sellOrders.erase( newOrder->getOrderId() ) ;
-        _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+        _executionSink.sendReplaceConfirm( replacedOrder ) ;
 
         if( replacedOrder->getOrderType() == OrderType_STOP
             || replacedOrder->getOrderType() == OrderType_STOP_LIMIT )
@@ -305,13 +575,14 @@ namespace ESM
       catch( OrderIdNotFound &e )
       {
         replacedOrder = _stopLossSellOrders.replace( newOrder );
-        _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+        armExpiry( replacedOrder ) ;
+        _executionSink.sendReplaceConfirm( replacedOrder ) ;
       }
     }
     catch( OrderHasChanged &e )
     {
       replacedOrder = _stopLossSellOrders.erase( newOrder->getOrderId() ) ;
-      _replyApplication.sendReplaceConfirm( replacedOrder ) ;
+      _executionSink.sendReplaceConfirm( replacedOrder ) ;
 
       if( replacedOrder->getOrderType() == OrderType_STOP
           || replacedOrder->getOrderType() == OrderType_STOP_LIMIT )
@@ -321,20 +592,20 @@ namespace ESM
     }
     catch( std::exception &e )
     {
-      _replyApplication.sendReplaceReject( newOrder, e.what() ) ;
+      _executionSink.sendReplaceReject( newOrder, e.what() ) ;
     }
 
     if( newOrder->getTimeInForce() == TimeInForce_IOC )
     {
       OrderPtr canceledOrder = _sellOrders.cancel( newOrder ) ;
-      _replyApplication.sendCancelConfirm(
+      _executionSink.sendCancelConfirm(
         canceledOrder,
         "IOC Order Cancelled Successfully"
         ) ;
     }
   }
 
-  void OrderBook::updateMarketData( int price, int qty )
+  void OrderBook::updateMarketData( long price, long qty )
   {
     _marketPictureRecord.setNoOfTrades( _marketPictureRecord.getNoOfTrades() + 1 ) ;
     _marketPictureRecord.setVolume( _marketPictureRecord.getVolume() + qty ) ;
@@ -352,42 +623,108 @@ namespace ESM
     {
       _marketPictureRecord.setLowPrice( price ) ;
     }
+
+    if( _barSeries != 0 )
+    {
+      _barAggregator->addTrade( _barSeries, price, qty,
+                                _marketPictureRecord.getNoOfTrades() ) ;
+    }
   }
 
-  void OrderBook::insertBuy( OrderPtr buyOrder )
+  void OrderBook::fill( const OrderPtr &incomingOrder,
+                        const OrderPtr &restingOrder,
+                        long qty )
+  {
+    incomingOrder->fill( restingOrder->getPrice(), qty ) ;
+    _executionSink.sendFillConfirm( restingOrder ) ;
+    _executionSink.sendFillConfirm( incomingOrder ) ;
+
+    updateMarketData( restingOrder->getPrice(), qty ) ;
+  }
+
+  template< class AllocationPolicy >
+  void OrderBook::matchBuy( const OrderPtr &buyOrder )
   {
     try
     {
-      boost::mutex::scoped_lock lock( _mutexOnMatch ) ;
-
-      while( buyOrder->getPendingQty() > 0 &&
+      while( _tradingPhase == TradingPhase_CONTINUOUS &&
+             buyOrder->getPendingQty() > 0 &&
              ( buyOrder->getOrderType() == OrderType_MARKET
-               || buyOrder->getPrice() >= _sellOrders.first()->getPrice() ) )
+               || buyOrder->getTick() >= _sellOrders.first()->getTick() ) )
       {
-        OrderPtr sellOrder = _sellOrders.first() ;
+        FillHandler handler( *this, buyOrder ) ;
+        AllocationPolicy::fill( _sellOrders, buyOrder->getPendingQty(),
+                          _instrument.getAllocation(), handler ) ;
 
-        int qty = ( buyOrder->getPendingQty() < sellOrder->getPendingQty() )
-                    ? buyOrder->getPendingQty() : sellOrder->getPendingQty() ;
+        if( buyOrder->getMinQty() == 0 )
+        {
+          checkTriggeredOrders() ;
+        }
+      }
+    }
+    catch( ListIsEmpty &e )
+    {
+    }
 
-        _sellOrders.fill( sellOrder->getPrice(), qty ) ;
-        buyOrder->fill( sellOrder->getPrice(), qty ) ;
-        _replyApplication.sendFillConfirm( sellOrder ) ;
-        _replyApplication.sendFillConfirm( buyOrder ) ;
+    // Stop orders triggered by a FOK / MinQty order must not take the
+    // liquidity it was accepted against, they go after it.
+    if( buyOrder->getMinQty() > 0 )
+    {
+      checkTriggeredOrders() ;
+    }
+  }
 
-        updateMarketData( sellOrder->getPrice(), qty ) ;
+  template< class AllocationPolicy >
+  void OrderBook::matchSell( const OrderPtr &sellOrder )
+  {
+    try
+    {
+      while( _tradingPhase == TradingPhase_CONTINUOUS
+             && sellOrder->getPendingQty() > 0
+             && ( sellOrder->getOrderType() == OrderType_MARKET
+                  || sellOrder->getTick() <= _buyOrders.first()->getTick() ) )
+      {
+        FillHandler handler( *this, sellOrder ) ;
+        AllocationPolicy::fill( _buyOrders, sellOrder->getPendingQty(),
+                          _instrument.getAllocation(), handler ) ;
 
-        checkTriggeredOrders() ;
+        if( sellOrder->getMinQty() == 0 )
+        {
+          checkTriggeredOrders() ;
+        }
       }
     }
     catch( ListIsEmpty &e )
     {
     }
 
+    if( sellOrder->getMinQty() > 0 )
+    {
+      checkTriggeredOrders() ;
+    }
+  }
+
+  void OrderBook::insertBuy( OrderPtr buyOrder )
+  {
+    switch( _instrument.getAllocation().type )
+    {
+      case AllocationType_PRO_RATA :
+        matchBuy< ProRataAllocation >( buyOrder ) ;
+        break ;
+      case AllocationType_LMM :
+        matchBuy< LmmAllocation >( buyOrder ) ;
+        break ;
+      case AllocationType_FIFO :
+        matchBuy< FifoAllocation >( buyOrder ) ;
+        break ;
+    }
+
     if( buyOrder->getPendingQty() > 0 )
     {
-      if( buyOrder->getTimeInForce() == TimeInForce_IOC )
+      if( buyOrder->getTimeInForce() == TimeInForce_IOC
+          || buyOrder->getTimeInForce() == TimeInForce_FOK )
       {
-        _replyApplication.sendCancelConfirm(
+        _executionSink.sendCancelConfirm(
           buyOrder,
           "IOC Order Cancelled Successfully"
           ) ;
@@ -399,55 +736,44 @@ namespace ESM
           if( _marketPictureRecord.getLastTradePrice() > 0 )
           {
             buyOrder->setMarketToLimit( _marketPictureRecord.getLastTradePrice() ) ;
-            _replyApplication.sendMarketToLimit( buyOrder ) ;
+            _executionSink.sendMarketToLimit( buyOrder ) ;
           }
           else
           {
-            _replyApplication.sendCancelConfirm(
+            _executionSink.sendCancelConfirm(
               buyOrder,
               "Market Order Cancelled since we do not have a LTP"
               ) ;
             return ;
           }
         }
-        _buyOrders.insert( buyOrder->getPrice(), buyOrder ) ;
+        _buyOrders.insert( buyOrder->getTick(), buyOrder ) ;
+        armExpiry( buyOrder ) ;
       }
     }
   }
 
   void OrderBook::insertSell( OrderPtr sellOrder )
   {
-    try
-    {
-      while( sellOrder->getPendingQty() > 0
-             && ( sellOrder->getOrderType() == OrderType_MARKET
-                  || sellOrder->getPrice() <= _buyOrders.first()->getPrice() ) )
-      {
-        OrderPtr buyOrder = _buyOrders.first() ;
-
-        int qty = ( buyOrder->getPendingQty() < sellOrder->getPendingQty() )
-                    ? buyOrder->getPendingQty()
-                    : sellOrder->getPendingQty() ;
-
-        _buyOrders.fill( buyOrder->getPrice(), qty ) ;
-        sellOrder->fill( buyOrder->getPrice(), qty ) ;
-        _replyApplication.sendFillConfirm( buyOrder ) ;
-        _replyApplication.sendFillConfirm( sellOrder ) ;
-
-        updateMarketData( buyOrder->getPrice(), qty ) ;
-
-        checkTriggeredOrders() ;
-      }
-    }
-    catch( ListIsEmpty &e )
+    switch( _instrument.getAllocation().type )
     {
+      case AllocationType_PRO_RATA :
+        matchSell< ProRataAllocation >( sellOrder ) ;
+        break ;
+      case AllocationType_LMM :
+        matchSell< LmmAllocation >( sellOrder ) ;
+        break ;
+      case AllocationType_FIFO :
+        matchSell< FifoAllocation >( sellOrder ) ;
+        break ;
     }
 
     if( sellOrder->getPendingQty() > 0 )
     {
-      if( sellOrder->getTimeInForce() == TimeInForce_IOC )
+      if( sellOrder->getTimeInForce() == TimeInForce_IOC
+          || sellOrder->getTimeInForce() == TimeInForce_FOK )
       {
-        _replyApplication.sendCancelConfirm(
+        _executionSink.sendCancelConfirm(
           sellOrder,
           "IOC Order Cancelled Successfully"
           ) ;
@@ -459,18 +785,19 @@ namespace ESM
           if( _marketPictureRecord.getLastTradePrice() > 0 )
           {
             sellOrder->setMarketToLimit( _marketPictureRecord.getLastTradePrice() ) ;
-            _replyApplication.sendMarketToLimit( sellOrder ) ;
+            _executionSink.sendMarketToLimit( sellOrder ) ;
           }
           else
           {
-            _replyApplication.sendCancelConfirm(
+            _executionSink.sendCancelConfirm(
               sellOrder,
               "Market Order Cancelled since we do not have a LTP"
               ) ;
             return ;
           }
         }
-        _sellOrders.insert( sellOrder->getPrice(), sellOrder ) ;
+        _sellOrders.insert( sellOrder->getTick(), sellOrder ) ;
+        armExpiry( sellOrder ) ;
       }
     }
   }
@@ -486,7 +813,7 @@ namespace ESM
         OrderPtr buyOrder = _stopLossBuyOrders.first() ;
         _stopLossBuyOrders.cancel( buyOrder ) ;
         buyOrder->trigger() ;
-        _replyApplication.sendTriggered( buyOrder ) ;
+        _executionSink.sendTriggered( buyOrder ) ;
 
         insertBuy( buyOrder ) ;
       }
@@ -500,15 +827,155 @@ namespace ESM
         OrderPtr sellOrder = _stopLossSellOrders.first() ;
         _stopLossSellOrders.cancel( sellOrder ) ;
         sellOrder->trigger() ;
-        _replyApplication.sendTriggered( sellOrder ) ;
+        _executionSink.sendTriggered( sellOrder ) ;
 
         insertSell( sellOrder ) ;
       }
     } catch( ListIsEmpty &e ) {}
   }
 
-  const MarketPicture::Record &OrderBook::getMarketPictureRecord( )
+  bool OrderBook::computeUncross( AuctionResult &result )
   {
+    OrderPtr bestBuy ;
+    OrderPtr bestSell ;
+    try
+    {
+      bestBuy = _buyOrders.first() ;
+      bestSell = _sellOrders.first() ;
+    }
+    catch( ListIsEmpty &e )
+    {
+      return false ;
+    }
+
+    long lowTick = bestSell->getTick() ;
+    long highTick = bestBuy->getTick() ;
+    if( highTick < lowTick )
+    {
+      return false ;
+    }
+
+    // The curves are built from the level totals, which the lists keep up
+    // to date, so the cost does not grow with the orders collected. Buys
+    // below the best sell & sells above the best buy cannot trade, the
+    // walks stop there.
+    _auction.reset( lowTick, highTick ) ;
+    for( DescOrderList::level_iterator iBuy = _buyOrders.levelsBegin() ;
+         iBuy != _buyOrders.levelsEnd() && iBuy->first >= lowTick ;
+         ++iBuy )
+    {
+      _auction.addBuy( iBuy->first, iBuy->second.totalQty ) ;
+    }
+    for( AscOrderList::level_iterator iSell = _sellOrders.levelsBegin() ;
+         iSell != _sellOrders.levelsEnd() && iSell->first <= highTick ;
+         ++iSell )
+    {
+      _auction.addSell( iSell->first, iSell->second.totalQty ) ;
+    }
+
+    long referencePrice = _marketPictureRecord.getLastTradePrice() > 0
+                          ? _marketPictureRecord.getLastTradePrice()
+                          : _marketPictureRecord.getClosePrice() ;
+    long referenceTick ;
+    try
+    {
+      referenceTick = _instrument.toTick( referencePrice ) ;
+    }
+    catch( InvalidPrice &e )
+    {
+      referenceTick = lowTick + ( highTick - lowTick ) / 2 ;
+    }
+
+    result = _auction.uncross( referenceTick ) ;
+    return result.volume > 0 ;
+  }
+
+  void OrderBook::uncross()
+  {
+    AuctionResult result ;
+    if( !computeUncross( result ) )
+    {
+      return ;
+    }
+
+    // The best orders of each side are the ones that trade, so the uncross
+    // is the same walk down both lists as continuous matching, at a single
+    // price.
+    long price = _instrument.tickToPrice( result.tick ) ;
+    long remaining = result.volume ;
+    while( remaining > 0 )
+    {
+      OrderPtr buyOrder = _buyOrders.first() ;
+      OrderPtr sellOrder = _sellOrders.first() ;
+
+      long qty = buyOrder->getActualPendingQty() < sellOrder->getActualPendingQty()
+                 ? buyOrder->getActualPendingQty()
+                 : sellOrder->getActualPendingQty() ;
+      qty = qty < remaining ? qty : remaining ;
+
+      _buyOrders.fill( price, qty ) ;
+      _sellOrders.fill( price, qty ) ;
+      _executionSink.sendFillConfirm( buyOrder ) ;
+      _executionSink.sendFillConfirm( sellOrder ) ;
+
+      updateMarketData( price, qty ) ;
+      remaining -= qty ;
+    }
+  }
+
+  void OrderBook::setTradingPhase( TradingPhase tradingPhase )
+  {
+    Transaction transaction( *this ) ;
+
+    if( tradingPhase == _tradingPhase )
+    {
+      return ;
+    }
+
+    if( _tradingPhase == TradingPhase_CALL_AUCTION )
+    {
+      uncross() ;
+    }
+    _tradingPhase = tradingPhase ;
+    _marketPictureRecord.setTradingPhase( tradingPhase ) ;
+
+    switch( tradingPhase )
+    {
+      case TradingPhase_CONTINUOUS :
+        _isActive = true ;
+        checkTriggeredOrders() ;
+        break ;
+      case TradingPhase_CALL_AUCTION :
+        _isActive = true ;
+        break ;
+      case TradingPhase_CLOSED :
+        _isActive = false ;
+        break ;
+    }
+
+    _hasChanged = true ;
+  }
+
+  void OrderBook::publish()
+  {
+    if( !_hasChanged )
+    {
+      return ;
+    }
+
+    // The uncross walks every crossing level, too much for each order of
+    // the call; refreshIndicative() does it once for the lot.
+    if( _tradingPhase == TradingPhase_CALL_AUCTION )
+    {
+      _isIndicativeStale.store( true, boost::memory_order_relaxed ) ;
+    }
+    else
+    {
+      _marketPictureRecord.setIndicativePrice( 0 ) ;
+      _marketPictureRecord.setIndicativeQty( 0 ) ;
+      _marketPictureRecord.setImbalance( 0 ) ;
+    }
+
     MarketData &buyMarketData = _buyOrders.getMarketData( ) ;
     for( int j = 0 ; j < 5 ; j++ )
     {
@@ -523,8 +990,36 @@ namespace ESM
       _marketPictureRecord.getDepthAt( j ).setTotalSellQty( sellMarketData.qty[j] ) ;
     }
 
+    _snapshot.write( _marketPictureRecord ) ;
     _hasChanged = false ;
-    return _marketPictureRecord ;
+
+    if( _dirtyBooks != 0 )
+    {
+      _dirtyBooks->push( this ) ;
+    }
+  }
+
+  void OrderBook::refreshIndicative()
+  {
+    if( !_isIndicativeStale.load( boost::memory_order_relaxed ) )
+    {
+      return ;
+    }
+
+    boost::mutex::scoped_lock lock( _mutexOnMatch ) ;
+    if( !_isIndicativeStale.exchange( false, boost::memory_order_relaxed )
+        || _tradingPhase != TradingPhase_CALL_AUCTION )
+    {
+      return ;
+    }
+
+    AuctionResult indicative ;
+    _marketPictureRecord.setIndicativePrice(
+        computeUncross( indicative )
+        ? _instrument.tickToPrice( indicative.tick ) : 0 ) ;
+    _marketPictureRecord.setIndicativeQty( indicative.volume ) ;
+    _marketPictureRecord.setImbalance( indicative.imbalance ) ;
+    _snapshot.write( _marketPictureRecord ) ;
   }
 
   void OrderBook::start()
@@ -534,6 +1029,8 @@ namespace ESM
 
   void OrderBook::stop()
   {
+    Transaction transaction( *this ) ;
+
     _isActive = false ;
 
     cancelAll< DescOrderList >( _buyOrders ) ;
@@ -3,11 +3,26 @@
 
 #include <boost/thread.hpp>
 
+#include "../common/dirtyQueue.h"
+#include "../common/seqLock.h"
+#include "allocation.h"
+#include "auction.h"
+#include "barAggregator.h"
 #include "orderList.h"
-#include "replyApplication.h"
+#include "executionSink.h"
+#include "timingWheel.h"
 
 namespace ESM
 {
+  class OrderBook ;
+
+  /**
+   * The order books whose next expiry came earlier, for the market to
+   * visit when it is due. Tags the queue apart from the dirty books.
+   */
+  struct ExpiryQueueTag ;
+  typedef UT::DirtyQueue< OrderBook, ExpiryQueueTag > ExpiryQueue ;
+
   /**
    *
    * \class OrderBook
@@ -16,20 +31,60 @@ namespace ESM
    * and does the matching. Additionally, it prepares the market data
    * snapshot which is to be send out.
    *
+   * A fill against a price level is shared between its orders by the
+   * allocation policy of the instrument, chosen when the book is created.
+   *
+   * During a call auction orders collect without matching, and market &
+   * IOC orders are rejected. The snapshot carries the indicative price,
+   * quantity & imbalance of the call, worked out by refreshIndicative()
+   * at the pace of the market picture rather than by every order. When
+   * the call ends, all the crossing orders execute at the equilibrium
+   * price in one uncross.
+   *
+   * FOK & MinQty orders are accepted only if the other side has the
+   * quantity at acceptable prices, found from the level totals before
+   * anything trades.
+   *
+   * Resting orders with an expire time (GTD, and DAY orders once the
+   * session end is known) are armed on a timing wheel of the book. They
+   * are cancelled by expireOrders(), all the orders due in one pass. A
+   * book whose next expiry comes earlier queues itself on the expiry queue
+   * it was given, so that only the books with orders due are visited.
+   *
+   * A book which publishes a new snapshot queues itself on the dirty
+   * queue it was given, so that the market picture visits only the books
+   * which changed.
+   *
    */
-  class OrderBook
+  class OrderBook : public UT::DirtyQueue< OrderBook >::Node,
+                    public ExpiryQueue::Node
   {
     public :
       /**
-       * @brief The constructor accepts the reply application which will be
+       * @brief The constructor accepts the execution sink which will be
        * used to send responses and the first order which will be used to
        * calculate the open, close, upper & lower limits.
        *
-       * @param The reply application which will send confirmations.
+       * @param The execution sink which will send confirmations.
        *
        * @param The first order used to caculate open, close & limits.
+       *
+       * @param Where the circuit limits are published for the risk gate.
+       *
+       * @param The trading phase of the market.
+       *
+       * @param Where the book queues itself when its snapshot changes.
+       *        None if 0.
+       *
+       * @param Where the book hands its trades for bars. None if 0.
        */
-      OrderBook( ReplyApplication &replyApplication, OrderPtr order ) ;
+      OrderBook( ExecutionSink &executionSink,
+                 OrderPtr order,
+                 PriceBand &priceBand,
+                 TradingPhase tradingPhase,
+                 UT::DirtyQueue< OrderBook > *dirtyBooks = 0,
+                 BarAggregator *barAggregator = 0,
+                 ExpiryQueue *expiryBooks = 0 ) ;
 
       /**
        * @brief Insert a new order into the order book.
@@ -38,6 +93,14 @@ namespace ESM
        */
       void insert( OrderPtr order ) ;
 
+      /**
+       * @brief Insert a batch of new orders, holding the order book only
+       * once for the whole batch.
+       *
+       * @param The orders to be inserted, all for this instrument.
+       */
+      void insert( const std::vector< OrderPtr > &orders ) ;
+
       /**
        * @brief Replace an order in the order book.
        *
@@ -53,18 +116,80 @@ namespace ESM
       void cancel( OrderPtr order ) ;
 
       /**
-       * @brief Convert the buy & sell books into a snapshot and return it.
+       * @brief Cancel all the orders of a sender in one pass.
+       *
+       * @param The sender whose orders will be cancelled.
+       * @param Cancel the buy orders.
+       * @param Cancel the sell orders.
+       * @param The text sent with the cancel confirmations.
+       *
+       * @return The number of orders cancelled.
+       */
+      long massCancel( const std::string &senderId,
+                       bool buys,
+                       bool sells,
+                       const std::string &reason ) ;
+
+      /**
+       * @brief Send the current status of an order of this book to its
+       * sender. The price levels are not visited.
        *
-       * @return A market picture of the current buy & sell books.
+       * @param The order, as found in the sender's ClOrdID index.
        */
-      const MarketPicture::Record &getMarketPictureRecord( ) ;
+      void sendStatus( OrderPtr order ) ;
 
       /**
-       * @brief Has the snapshot changed since the last getMarketPictureRecord ?
+       * @brief Copy the snapshot published at the end of the last
+       * transaction which changed the book. Any thread may call this at
+       * any time, without taking the lock of the book.
        *
-       * @return True if snapshot has changed.
+       * @return The version of the snapshot, which grows with every change.
+       */
+      uint64_t getMarketPictureRecord( MarketPicture::Record &record ) const
+      {
+        return _snapshot.read( record ) ;
+      }
+
+      /**
+       * @brief Work out the indicative price, quantity & imbalance of the
+       * call again, if orders came since, and publish them in the
+       * snapshot. Takes the lock of the book only then.
+       */
+      void refreshIndicative() ;
+
+      /**
+       * @brief The version getMarketPictureRecord would return now.
        */
-      bool hasChanged() { return _hasChanged ; }
+      uint64_t getSnapshotVersion() const { return _snapshot.getVersion() ; }
+
+      /**
+       * @brief A hash of the resting orders, in priority order: their
+       * prices, sides, quantities, ClOrdIDs & senders. Two runs of the same
+       * order flow end with the same checksum, whatever the OrderIDs.
+       */
+      size_t getChecksum() ;
+
+      /**
+       * @brief Cancel the orders whose expire time has come.
+       *
+       * @param The current time, in seconds since the epoch.
+       */
+      void expireOrders( long now ) ;
+
+      /**
+       * @brief When expireOrders() next needs to be called, in seconds
+       * since the epoch. May be early, never late. 0 if no order expires.
+       */
+      long getNextExpiry() const { return _nextExpiry.load() ; }
+
+      /**
+       * @brief Move to another trading phase. Leaving a call auction
+       * uncrosses the book first. Orders are kept while the market is
+       * closed; DAY orders expire at the session end.
+       *
+       * @param The new phase.
+       */
+      void setTradingPhase( TradingPhase tradingPhase ) ;
 
       /**
        * @brief Start accepting orders.
@@ -98,24 +223,40 @@ namespace ESM
       DescOrderList _stopLossSellOrders ;
 
       /**
-       * The application which will send the replies to the client
+       * Where the replies to the client are sent.
        */
-      ReplyApplication &_replyApplication ;
+      ExecutionSink &_executionSink ;
 
       /**
-       * Variable to notify if the order book has changed since the last
-       * getMarketData request.
+       * Set by a transaction which changed the book, so that it publishes
+       * a new snapshot when it ends.
        */
       bool _hasChanged ;
 
       /**
-       * Current snapshot of this order book.
+       * The snapshot of this order book, updated under _mutexOnMatch. The
+       * statistics are kept up to date with every trade, the depth &
+       * indicative price are filled in when it is published.
        */
       MarketPicture::Record _marketPictureRecord ;
 
+      /**
+       * The snapshot last published, for the readers.
+       */
+      UT::SeqLock< MarketPicture::Record > _snapshot ;
+
+      UT::DirtyQueue< OrderBook > *_dirtyBooks ;
+
+      /**
+       * The bars of this book, 0 if bars are not kept.
+       */
+      BarAggregator *_barAggregator ;
+      BarSeries *_barSeries ;
+
       /**
        * A mutex to make sure only one transaction occurs on this order book
-       * at a time.
+       * at a time. Orders arrive from the FIX session threads and the shared
+       * memory gateway, so every public entry point holds it.
        */
       boost::mutex _mutexOnMatch ;
 
@@ -124,6 +265,150 @@ namespace ESM
        */
       bool _isActive ;
 
+      TradingPhase _tradingPhase ;
+
+      /**
+       * Set when the call changed since its indicative price was worked
+       * out.
+       */
+      boost::atomic< bool > _isIndicativeStale ;
+
+      /**
+       * The curves of the call auction, kept to reuse their memory.
+       */
+      Auction _auction ;
+
+      /**
+       * The instrument of this book, to go between ticks & prices.
+       */
+      const Instrument &_instrument ;
+
+      /**
+       * The expire times of the resting orders.
+       */
+      TimingWheel _expiryWheel ;
+
+      /**
+       * The time last announced on the expiry queue, updated under
+       * _mutexOnMatch.
+       */
+      ExpiryQueue *_expiryBooks ;
+      boost::atomic< long > _nextExpiry ;
+
+      /**
+       * The orders handed back by the wheel, kept to reuse its memory.
+       */
+      std::vector< Order * > _expiredOrders ;
+
+      /**
+       * Holds _mutexOnMatch for a transaction on the book, and publishes
+       * the snapshot at the end of it if the book changed.
+       */
+      class Transaction
+      {
+        public :
+          Transaction( OrderBook &orderBook )
+            : _lock( orderBook._mutexOnMatch ),
+              _orderBook( orderBook )
+          {}
+
+          ~Transaction() { _orderBook.publish() ; }
+
+        private :
+          boost::mutex::scoped_lock _lock ;
+          OrderBook &_orderBook ;
+      };
+      friend class Transaction ;
+
+      /**
+       * @brief Fill in the depth of the snapshot and publish it, if the
+       *        book changed. The indicative price is only marked stale.
+       *        The caller must hold _mutexOnMatch.
+       */
+      void publish() ;
+
+      /**
+       * @brief Can the other side fill the MinQty of an order, FOK or not,
+       *        at its price. Only the price levels are walked.
+       */
+      bool isMinQtyAvailable( const OrderPtr &order ) const ;
+
+      /**
+       * @brief Put a resting order on the expiry wheel if it has an expire
+       *        time, take it off if it no longer has one.
+       */
+      void armExpiry( const OrderPtr &order ) ;
+
+      /**
+       * Called by the allocation policy for every resting order filled by
+       * an incoming order.
+       */
+      struct FillHandler
+      {
+        FillHandler( OrderBook &orderBook, const OrderPtr &incomingOrder )
+          : orderBook( orderBook ),
+            incomingOrder( incomingOrder )
+        {}
+
+        void operator()( const OrderPtr &restingOrder, long qty )
+        {
+          orderBook.fill( incomingOrder, restingOrder, qty ) ;
+        }
+
+        OrderBook &orderBook ;
+        const OrderPtr &incomingOrder ;
+      };
+      friend struct FillHandler ;
+
+      /**
+       * @brief Fill an incoming order against a resting order, already
+       *        filled by its list, at the resting order's price.
+       */
+      void fill( const OrderPtr &incomingOrder,
+                 const OrderPtr &restingOrder,
+                 long qty ) ;
+
+      /**
+       * @brief Match an incoming buy / sell against the other side for as
+       *        long as they cross, sharing fills by the allocation policy.
+       */
+      template< class AllocationPolicy >
+        void matchBuy( const OrderPtr &buyOrder ) ;
+      template< class AllocationPolicy >
+        void matchSell( const OrderPtr &sellOrder ) ;
+
+      /**
+       * @brief Find the equilibrium of the orders in the book.
+       *
+       * @param Set to the equilibrium.
+       *
+       * @return False if the book does not cross.
+       */
+      bool computeUncross( AuctionResult &result ) ;
+
+      /**
+       * @brief Execute all the crossing orders at the equilibrium price.
+       *        The caller must hold _mutexOnMatch.
+       */
+      void uncross() ;
+
+      /**
+       * @brief Route a new order to the buy / sell / stop loss books.
+       *        The caller must hold _mutexOnMatch.
+       *
+       * @param The order to be inserted.
+       */
+      void insertOrder( OrderPtr order ) ;
+
+      /**
+       * @brief Send cancel confirmations for orders removed from the book.
+       *
+       * @param The cancelled orders.
+       * @param The text sent with the cancel confirmations.
+       */
+      void sendCancelConfirms( const std::vector< OrderPtr > &orders,
+                               const std::string &reason ) ;
+
       /**
        * @brief Try to match a buy order. 
        *        If corresponding sell is unavailable, insert it into the buy
@@ -181,7 +466,7 @@ namespace ESM
       /**
        * @brief Update the market data.
        */
-      void updateMarketData( int price, int qty ) ;
+      void updateMarketData( long price, long qty ) ;
 
       void print() ;
 
@@ -205,7 +490,7 @@ namespace ESM
             {
               canceledOrder = list.first() ;
               canceledOrder = list.cancel( canceledOrder ) ;
-              _replyApplication.sendCancelConfirm(
+              _executionSink.sendCancelConfirm(
                 canceledOrder,
                 "Order Cancelled As System Is Shutting Down"
                 ) ;
@@ -2,6 +2,7 @@
 #define ESM_ORDER_LISTH_H
 
 #include <map>
+#include <vector>
 #include <boost/unordered_map.hpp>
 
 #include "../common/definesForCreateEndianless.h"
@@ -15,22 +16,74 @@ namespace ESM
       UT::LONG qty[5] ;
   };
 
+  /**
+   * The orders resting at one key of an order list.
+   */
+  struct PriceLevel
+  {
+    PriceLevel() : price( 0 ), qty( 0 ), totalQty( 0 ), orders( 0 ) {}
+
+    /**
+     * The price of the first order at this level.
+     */
+    long price ;
+
+    /**
+     * The sum of the pending quantities.
+     */
+    long qty ;
+
+    /**
+     * The sum of the pending quantities including the hidden part of
+     * disclosed quantity orders, all of which can trade.
+     */
+    long totalQty ;
+
+    long orders ;
+  };
+
   /**
    *
    * \class OrderList
    *
    * OrderList to store the buy and sell orders
    *
+   * Orders are kept in price & time priority. The list also keeps the
+   * total of every price level, so that the allocation policies can share
+   * a fill across a level in one pass and market data does not visit every
+   * order.
+   *
    */
   template< class Compare >
   class OrderList
   {
     typedef std::multimap < long, OrderPtr, Compare > OrdersByPriceMap;
-    typedef boost::unordered_map< std::string,
+    typedef std::map < long, PriceLevel, Compare > PriceLevelsMap;
+    typedef boost::unordered_map< OrderId,
             typename OrdersByPriceMap::iterator > OrdersByOrderIdMap ;
+    typedef boost::unordered_map< std::string,
+            SessionOrderList > OrdersBySenderMap ;
 
     public :
 
+    typedef typename OrdersByPriceMap::iterator iterator ;
+    typedef typename OrdersByPriceMap::const_iterator const_iterator ;
+
+    /**
+     * @brief Walk the orders in priority order, keyed by tick.
+     */
+    const_iterator begin() const { return _ordersByPrice.begin() ; }
+    const_iterator end() const { return _ordersByPrice.end() ; }
+
+    typedef typename PriceLevelsMap::const_iterator level_iterator ;
+
+    /**
+     * @brief Walk the totals of the price levels, best first, keyed by
+     * tick.
+     */
+    level_iterator levelsBegin() const { return _priceLevels.begin() ; }
+    level_iterator levelsEnd() const { return _priceLevels.end() ; }
+
     /**
      * @brief Get the first order from the list which will be used to match
      * against a new order.
@@ -50,7 +103,8 @@ namespace ESM
     /**
      * @brief Insert a new order into this list.
      *
-     * @param The price at which the order should be inserted.
+     * @param The key at which the order should be inserted: the tick of
+     * its price, or its stop price for the stop loss lists.
      *
      * @param The order to be inserted.
      *
@@ -64,6 +118,15 @@ namespace ESM
       _ordersByOrderId.insert (
           std::make_pair ( order->getOrderId(),  _iOrdersByPrice )
           ) ;
+      _ordersBySender[ order->getSenderId() ].push_back( *order ) ;
+
+      PriceLevel &level = _priceLevels[ price ] ;
+      if( level.orders++ == 0 )
+      {
+        level.price = order->getPrice() ;
+      }
+      level.qty += order->getPendingQty() ;
+      level.totalQty += order->getActualPendingQty() ;
       return true ;
     }
 
@@ -79,11 +142,14 @@ namespace ESM
       _iOrdersByOrderId = _ordersByOrderId.find( order->getOrderId() ) ;
       if( _iOrdersByOrderId == _ordersByOrderId.end() )
       {
-        throw OrderIdNotFound( order->getOrderId() ) ;
+        throw OrderIdNotFound( UT::UniqueOrderId::toString( order->getOrderId() ) ) ;
       }
       OrderPtr oldOrder = _iOrdersByOrderId->second->second ;
       oldOrder->cancel( *order ) ;
+      oldOrder->unlink() ;
+      oldOrder->disarm() ;
 
+      removeFromLevel( _iOrdersByOrderId->second ) ;
       _ordersByPrice.erase( _iOrdersByOrderId->second ) ;
       _ordersByOrderId.erase( _iOrdersByOrderId ) ;
 
@@ -103,12 +169,27 @@ namespace ESM
       _iOrdersByOrderId = _ordersByOrderId.find( order->getOrderId() ) ;
       if( _iOrdersByOrderId == _ordersByOrderId.end() )
       {
-        throw OrderIdNotFound( order->getOrderId() ) ;
+        throw OrderIdNotFound( UT::UniqueOrderId::toString( order->getOrderId() ) ) ;
       }
 
       OrderPtr oldOrder = _iOrdersByOrderId->second->second ;
+      PriceLevel &level = _priceLevels[ _iOrdersByOrderId->second->first ] ;
+      long pendingQty = oldOrder->getPendingQty() ;
+      long totalQty = oldOrder->getActualPendingQty() ;
 
-      oldOrder->replace( *order ) ;
+      try
+      {
+        oldOrder->replace( *order ) ;
+      }
+      catch( OrderHasChanged &e )
+      {
+        // The order is still on its level until the caller erases it.
+        level.qty += oldOrder->getPendingQty() - pendingQty ;
+        level.totalQty += oldOrder->getActualPendingQty() - totalQty ;
+        throw ;
+      }
+      level.qty += oldOrder->getPendingQty() - pendingQty ;
+      level.totalQty += oldOrder->getActualPendingQty() - totalQty ;
 
       return oldOrder ;
     }
@@ -132,31 +213,13 @@ namespace ESM
       _marketData.qty[4] = 0 ;
 
       _counter = 0 ;
-      _iOrdersByPriceForMarketData = _ordersByPrice.begin() ;
-
-      if ( _iOrdersByPriceForMarketData != _ordersByPrice.end() )
+      for( typename PriceLevelsMap::const_iterator iLevel = _priceLevels.begin() ;
+           iLevel != _priceLevels.end() && _counter < 5 ;
+           ++iLevel, ++_counter )
       {
-        _marketData.price[_counter] = _iOrdersByPriceForMarketData->first ;
-        _marketData.qty[_counter] = _iOrdersByPriceForMarketData->second->getPendingQty() ;
-
-        while ( ++_iOrdersByPriceForMarketData != _ordersByPrice.end() )
-        {
-          if( _marketData.price[_counter] == _iOrdersByPriceForMarketData->first )
-          {
-            _marketData.qty[_counter] += _iOrdersByPriceForMarketData->second->getPendingQty() ;
-          }
-          else
-          {
-            if( ++_counter == 5 ) break ;
-
-            _marketData.price[_counter] = _iOrdersByPriceForMarketData->first ;
-            _marketData.qty[_counter] = _iOrdersByPriceForMarketData->second->getPendingQty() ;
-          }
-        }
-      }
-      else
-      {
-        //std::cout << "i didnt find any market data" << std::endl ;
+        // Levels are keyed by tick, the snapshot carries the price.
+        _marketData.price[_counter] = iLevel->second.price ;
+        _marketData.qty[_counter] = iLevel->second.qty ;
       }
 
       return _marketData ;
@@ -189,19 +252,48 @@ namespace ESM
     /**
      * @brief Remove an order from the map.
      */
-    OrderPtr erase( const std::string &orderId )
+    OrderPtr erase( OrderId orderId )
     {
       _iOrdersByOrderId = _ordersByOrderId.find( orderId ) ;
 
       if( _iOrdersByOrderId != _ordersByOrderId.end() )
       {
         OrderPtr order = _iOrdersByOrderId->second->second ;
+        order->unlink() ;
+        order->disarm() ;
 
+        removeFromLevel( _iOrdersByOrderId->second ) ;
         _ordersByPrice.erase( _iOrdersByOrderId->second ) ;
         _ordersByOrderId.erase( _iOrdersByOrderId ) ;
         return order ;
       }
-      throw OrderIdNotFound( orderId ) ;
+      throw OrderIdNotFound( UT::UniqueOrderId::toString( orderId ) ) ;
+    }
+
+    /**
+     * @brief Remove all the orders of a sender from the list. Only the
+     * orders of that sender are visited.
+     *
+     * @param The sender whose orders will be removed.
+     *
+     * @param The removed orders are appended here.
+     */
+    void eraseBySender( const std::string &senderId,
+                        std::vector< OrderPtr > &erased )
+    {
+      typename OrdersBySenderMap::iterator iSender =
+        _ordersBySender.find( senderId ) ;
+      if( iSender == _ordersBySender.end() )
+      {
+        return ;
+      }
+
+      SessionOrderList &orders = iSender->second ;
+      while( !orders.empty() )
+      {
+        // erase() unlinks the order from the session list.
+        erased.push_back( erase( orders.front().getOrderId() ) ) ;
+      }
     }
 
     /**
@@ -209,26 +301,115 @@ namespace ESM
      */
     void fill( long price, long qty )
     {
-      OrderPtr order = first() ;
+      first() ;
+      fill( _iOrdersByPrice, price, qty ) ;
+    }
+
+    /**
+     * @brief Fill an order of the list and erase it if it's filled.
+     *
+     * @param The order.
+     *
+     * @return The next order in the list.
+     */
+    iterator fill( iterator iOrder, long price, long qty )
+    {
+      OrderPtr order = iOrder->second ;
+      PriceLevel &level = _priceLevels[ iOrder->first ] ;
+      long pendingQty = order->getPendingQty() ;
+
       order->fill( price, qty ) ;
-      if( order->getPendingQty() == 0)
+      level.qty += order->getPendingQty() - pendingQty ;
+      level.totalQty -= qty ;
+
+      iterator iNext = iOrder ;
+      ++iNext ;
+      if( order->getPendingQty() == 0 )
       {
         erase( order ) ;
       }
+      return iNext ;
+    }
+
+    /**
+     * @brief The orders of the best price level.
+     *
+     * @return The first order of the level, end() if the list is empty.
+     */
+    iterator levelBegin() { return _ordersByPrice.begin() ; }
+
+    /**
+     * @brief The order after the last one of a level.
+     */
+    iterator levelEnd( iterator iOrder )
+    {
+      return _ordersByPrice.upper_bound( iOrder->first ) ;
+    }
+
+    /**
+     * @brief The total pending quantity at a level.
+     */
+    long getLevelQty( long price ) const
+    {
+      typename PriceLevelsMap::const_iterator iLevel = _priceLevels.find( price ) ;
+      return iLevel == _priceLevels.end() ? 0 : iLevel->second.qty ;
+    }
+
+    /**
+     * @brief The quantity that can trade against the list up to a key,
+     * found by walking the levels only.
+     *
+     * @param The worst key to count, included.
+     * @param Stop counting once this much is found.
+     *
+     * @return The quantity found, at most a level more than asked.
+     */
+    long getQtyUpTo( long price, long wantedQty ) const
+    {
+      long qty = 0 ;
+      for( typename PriceLevelsMap::const_iterator iLevel = _priceLevels.begin() ;
+           iLevel != _priceLevels.end()
+           && qty < wantedQty
+           && !_priceLevels.key_comp()( price, iLevel->first ) ;
+           ++iLevel )
+      {
+        qty += iLevel->second.totalQty ;
+      }
+      return qty ;
+    }
+
+    /**
+     * @brief Is this level still the best one of the list.
+     */
+    bool isBest( long price ) const
+    {
+      return !_ordersByPrice.empty() && _ordersByPrice.begin()->first == price ;
     }
 
     private :
     /**
-     * A map which maintans the price & time priority.
+     * A map which maintans the price & time priority, keyed by tick.
      */
     OrdersByPriceMap _ordersByPrice ;
 
+    /**
+     * The total of every level, in the order of _ordersByPrice.
+     */
+    PriceLevelsMap _priceLevels ;
+
     /**
      * A map which maintains the orderis and the order.
      * Used for replace & cancel.
      */
     OrdersByOrderIdMap _ordersByOrderId ;
 
+    /**
+     * The live orders of every sender, in the order they were inserted.
+     * Used to cancel all the orders of a session without walking the
+     * whole list.
+     */
+    OrdersBySenderMap _ordersBySender ;
+
     /**
      * The snapshot in memory.
      */
@@ -237,8 +418,21 @@ namespace ESM
     typename OrdersByPriceMap::iterator _iOrdersByPrice;
     typename OrdersByOrderIdMap::iterator _iOrdersByOrderId;
 
-    typename OrdersByPriceMap::iterator _iOrdersByPriceForMarketData;
     int _counter ;
+
+    /**
+     * @brief Take an order off its price level before it is erased.
+     */
+    void removeFromLevel( typename OrdersByPriceMap::iterator iOrder )
+    {
+      typename PriceLevelsMap::iterator iLevel = _priceLevels.find( iOrder->first ) ;
+      iLevel->second.qty -= iOrder->second->getPendingQty() ;
+      iLevel->second.totalQty -= iOrder->second->getActualPendingQty() ;
+      if( --iLevel->second.orders == 0 )
+      {
+        _priceLevels.erase( iLevel ) ;
+      }
+    }
   };
 
   /* Order book sorted by price Ascending */
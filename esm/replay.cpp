@@ -0,0 +1,345 @@
+#include "../config.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "quickfix/DataDictionary.h"
+
+#include "../common/binaryLog.h"
+#include "../common/exceptions.h"
+#include "constants.h"
+#include "executionSinks.h"
+#include "requestApplication.h"
+
+/**
+ * Replay the inbound order flow of QuickFIX message logs through the
+ * engine: the FIX parsing & checks of the RequestApplication, the risk gate
+ * and the market. Execution reports are dropped, or written to a file of
+ * ExecutionRecords.
+ *
+ * The logs are the *.messages.log files written under FileLogPath. The
+ * stores under FileStorePath only keep the outbound messages, for resends.
+ * Messages of all the logs are merged in the order of their timestamps and
+ * sent as fast as possible, or at the pace they were logged. Cancels and
+ * replaces find their order by OrigClOrdID, as the OrderIDs logged are not
+ * those the replay gives.
+ *
+ * The checksum of the order books at the end tells whether two runs, e.g.
+ * before & after an engine change, left the same orders resting.
+ */
+namespace
+{
+  struct LoggedMessage
+  {
+    long long time ;
+    std::string text ;
+
+    bool operator<( const LoggedMessage &message ) const
+    {
+      return time < message.time ;
+    }
+  };
+
+  long long now()
+  {
+    timespec time ;
+    clock_gettime( CLOCK_MONOTONIC, &time ) ;
+    return time.tv_sec * 1000000000LL + time.tv_nsec ;
+  }
+
+  /**
+   * @brief Convert a UTC timestamp, YYYYMMDD-HH:MM:SS[.sss], to
+   * nanoseconds since the epoch.
+   *
+   * @return false if this is not a timestamp.
+   */
+  bool toTime( const std::string &timestamp, long long &time )
+  {
+    tm utc = tm() ;
+    int milliseconds = 0 ;
+    int fields = sscanf( timestamp.c_str(), "%4d%2d%2d-%2d:%2d:%2d.%3d",
+                         &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+                         &utc.tm_hour, &utc.tm_min, &utc.tm_sec,
+                         &milliseconds ) ;
+    if( fields < 6 )
+    {
+      return false ;
+    }
+    utc.tm_year -= 1900 ;
+    utc.tm_mon -= 1 ;
+    time = ( timegm( &utc ) * 1000LL + milliseconds ) * 1000000LL ;
+    return true ;
+  }
+
+  /**
+   * @brief The value of a tag in a raw FIX message, or "".
+   */
+  std::string getTag( const std::string &text, const std::string &tag )
+  {
+    std::string start = '\001' + tag + "=" ;
+    size_t begin = text.find( start ) ;
+    if( begin == std::string::npos )
+    {
+      return "" ;
+    }
+    begin += start.size() ;
+    return text.substr( begin, text.find( '\001', begin ) - begin ) ;
+  }
+
+  bool isReplayed( const std::string &msgType )
+  {
+    return msgType == "D"     // NewOrderSingle
+      || msgType == "E"       // NewOrderList
+      || msgType == "F"       // OrderCancelRequest
+      || msgType == "G"       // OrderCancelReplaceRequest
+      || msgType == "H"       // OrderStatusRequest
+      || msgType == ESM::FIX_MsgType_ORDER_MASS_CANCEL_REQUEST ;
+  }
+
+  /**
+   * @brief Read the orders sent to us from a message log. A line is a
+   * message, after the time it was logged if the log has timestamps.
+   *
+   * @return The number of messages kept.
+   */
+  long readLog( const std::string &fileName,
+                const std::string &compId,
+                std::vector< LoggedMessage > &messages )
+  {
+    std::ifstream log( fileName.c_str() ) ;
+    if( !log )
+    {
+      throw UT::FileNotFound( fileName ) ;
+    }
+
+    long kept = 0 ;
+    std::string line ;
+    while( std::getline( log, line ) )
+    {
+      size_t begin = line.find( "8=FIX" ) ;
+      if( begin == std::string::npos )
+      {
+        continue ;
+      }
+
+      LoggedMessage message ;
+      message.text = line.substr( begin ) ;
+      if( getTag( message.text, "56" ) != compId
+          || !isReplayed( getTag( message.text, "35" ) ) )
+      {
+        continue ;
+      }
+      if( !toTime( line.substr( 0, begin ), message.time )
+          && !toTime( getTag( message.text, "52" ), message.time ) )
+      {
+        message.time = 0 ;
+      }
+
+      messages.push_back( message ) ;
+      ++kept ;
+    }
+    return kept ;
+  }
+
+  void printChecksum( ESM::Market &market, long messages )
+  {
+    size_t orderBooks = 0 ;
+    size_t checksum = market.getChecksum( orderBooks ) ;
+    std::cout << "After " << messages << " messages : " << orderBooks
+              << " order books, checksum " << std::hex << std::setw( 16 )
+              << std::setfill( '0' ) << checksum << std::dec
+              << std::setfill( ' ' ) << std::endl ;
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  namespace bpo = boost::program_options ;
+
+  std::vector< std::string > logs ;
+  std::string dictionaryFile, compId, executionsFile, instrumentsFile ;
+  std::string udpAddress, udpPort ;
+  double speed = 0 ;
+  long checksumInterval = 0 ;
+
+  bpo::options_description visible( "Allowed options" ) ;
+  visible.add_options()
+    ( "help,h", "produce help message" )
+    ( "dictionary,d",
+      bpo::value< std::string >( &dictionaryFile ),
+      "FIX data dictionary of the sessions, needed for NewOrderList" )
+    ( "comp-id",
+      bpo::value< std::string >( &compId )->default_value( "ESM" ),
+      "SenderCompID of uMatch, the messages sent to it are replayed" )
+    ( "speed",
+      bpo::value< double >( &speed )->default_value( 0 ),
+      "Pace of the replay, 1 as logged, 2 twice as fast. 0 for as fast as "
+      "possible" )
+    ( "checksum-interval",
+      bpo::value< long >( &checksumInterval )->default_value( 0 ),
+      "Also print the checksum every so many messages" )
+    ( "executions",
+      bpo::value< std::string >( &executionsFile ),
+      "Write the execution reports to this file, as ExecutionRecords" )
+    ( "instruments",
+      bpo::value< std::string >( &instrumentsFile ),
+      "Price scale & tick table of the instruments" )
+#ifdef UDP_MARKET_DATA
+    ( "udp-host",
+      bpo::value< std::string >( &udpAddress )->default_value( "127.0.0.1" ),
+      "udp host for market data" )
+    ( "udp-port",
+      bpo::value< std::string >( &udpPort )->default_value( "30100" ),
+      "Udp Port For MarketData" )
+#endif
+    ;
+
+  bpo::options_description hidden ;
+  hidden.add_options()
+    ( "log", bpo::value< std::vector< std::string > >( &logs ), "" ) ;
+
+  bpo::options_description options ;
+  options.add( visible ).add( hidden ) ;
+
+  bpo::positional_options_description positional ;
+  positional.add( "log", -1 ) ;
+
+  try
+  {
+    bpo::variables_map vm ;
+    store( bpo::command_line_parser( argc, argv ).options( options )
+           .positional( positional ).run(), vm ) ;
+    notify( vm ) ;
+
+    if( vm.count( "help" ) || logs.empty() )
+    {
+      std::cout << "Usage : umatch_replay [options] message logs...\n"
+                << visible << std::endl ;
+      return 1 ;
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cout << "Found error in the options : " << e.what() << std::endl ;
+    return 1 ;
+  }
+
+  try
+  {
+    if( !instrumentsFile.empty() )
+    {
+      ESM::Instruments::load( instrumentsFile ) ;
+    }
+
+    boost::scoped_ptr< FIX::DataDictionary > dictionary ;
+    if( !dictionaryFile.empty() )
+    {
+      dictionary.reset( new FIX::DataDictionary( dictionaryFile ) ) ;
+    }
+
+    std::vector< LoggedMessage > messages ;
+    for( std::vector< std::string >::const_iterator iLog = logs.begin() ;
+         iLog != logs.end() ;
+         ++iLog )
+    {
+      std::cout << *iLog << " : " << readLog( *iLog, compId, messages )
+                << " messages" << std::endl ;
+    }
+    std::stable_sort( messages.begin(), messages.end() ) ;
+
+    ESM::NullExecutionSink nullSink ;
+    boost::scoped_ptr< ESM::FileExecutionSink > fileSink ;
+    ESM::ExecutionSink *executionSink = &nullSink ;
+    if( !executionsFile.empty() )
+    {
+      fileSink.reset( new ESM::FileExecutionSink( executionsFile ) ) ;
+      executionSink = fileSink.get() ;
+    }
+
+    ESM::RequestApplication requestApplication( udpAddress, udpPort,
+                                                executionSink ) ;
+    // The OrderIDs logged are those of production, never of this run.
+    requestApplication.setIgnoreOrderIds( true ) ;
+
+    std::set< std::string > sessions ;
+    long replayed = 0 ;
+    long failed = 0 ;
+    long long start = now() ;
+    for( std::vector< LoggedMessage >::const_iterator iMessage = messages.begin() ;
+         iMessage != messages.end() ;
+         ++iMessage )
+    {
+      if( speed > 0 && messages.front().time != 0 )
+      {
+        long long due = start + static_cast< long long >(
+            ( iMessage->time - messages.front().time ) / speed ) ;
+        long long wait = due - now() ;
+        if( wait > 0 )
+        {
+          boost::this_thread::sleep( boost::posix_time::microseconds( wait / 1000 ) ) ;
+        }
+      }
+
+      try
+      {
+        FIX::Message message ;
+        message.setString( iMessage->text, false, dictionary.get() ) ;
+
+        const FIX::Header &header = message.getHeader() ;
+        FIX::SessionID sessionId( header.getField( FIX::FIELD::BeginString ),
+                                  header.getField( FIX::FIELD::TargetCompID ),
+                                  header.getField( FIX::FIELD::SenderCompID ) ) ;
+        if( sessions.insert( sessionId.toString() ).second )
+        {
+          requestApplication.onCreate( sessionId ) ;
+        }
+
+        requestApplication.fromApp( message, sessionId ) ;
+        ++replayed ;
+      }
+      catch( std::exception &e )
+      {
+        std::cout << "Cannot replay " << iMessage->text << " : "
+                  << e.what() << std::endl ;
+        ++failed ;
+      }
+
+      if( checksumInterval > 0 && ( replayed + failed ) % checksumInterval == 0 )
+      {
+        printChecksum( requestApplication.getMarket(), replayed + failed ) ;
+      }
+    }
+    long long elapsed = now() - start ;
+
+    std::cout << "Replayed " << replayed << " messages from "
+              << sessions.size() << " sessions in " << elapsed / 1000000
+              << " ms, " << ( elapsed > 0 ? replayed * 1000000000LL / elapsed : 0 )
+              << " messages/s. " << failed << " could not be replayed"
+              << std::endl ;
+    printChecksum( requestApplication.getMarket(), replayed + failed ) ;
+
+    if( fileSink )
+    {
+      fileSink->flush() ;
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cout << "stopping due to error " << e.what() << std::endl ;
+    UT::BinaryLog::flush() ;
+    return 1 ;
+  }
+
+  // The threads of the market never end. Statements still in the rings
+  // of the threads would be lost.
+  UT::BinaryLog::flush() ;
+  _exit( 0 ) ;
+}
@@ -5,13 +5,40 @@
 #include "replyApplication.h"
 #include "constants.h"
 #include "fixToOrder.h"
+#include "shmGateway.h"
+#include "../common/latency.h"
 
 namespace ESM {
-  void ReplyApplication::sendNewConfirm( OrderPtr order )
+  bool ReplyApplication::isSharedMemorySession( const OrderPtr &order ) const
   {
+    return _shmGateway != 0
+      && ShmGateway::isSharedMemorySession( order->getSenderId() ) ;
+  }
+
+  void ReplyApplication::send( FIX::Message &message, const OrderPtr &order )
+  {
+    FIX::SessionID session ;
+    session.fromString( order->getSenderId() ) ;
+    LATENCY_STOP( ENCODE ) ;
+
+    LATENCY_START( SEND ) ;
+    FIX::Session::sendToTarget ( message, session ) ;
+    LATENCY_STOP( SEND ) ;
+  }
+
+  void ReplyApplication::onNewConfirm( const OrderPtr &order )
+  {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX::ExecType_NEW, FIX::OrdStatus_NEW ) ;
+      return ;
+    }
+
     //DEBUG_1( "New confirm " ) ;
 
-    FIX42::ExecutionReport fixReport ( FIX::OrderID ( order->getOrderId() ),
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       FIX::ExecType ( FIX::ExecType_NEW ),
@@ -20,22 +47,28 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
     fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
   }
 
-  void ReplyApplication::sendReplaceConfirm( OrderPtr order )
+  void ReplyApplication::onReplaceConfirm( const OrderPtr &order )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX::ExecType_REPLACE, FIX::OrdStatus_REPLACED ) ;
+      return ;
+    }
+
     //DEBUG_1( "Replace confirm " ) ;
 
-    FIX42::ExecutionReport fixReport( FIX::OrderID ( order->getOrderId() ),
+    FIX42::ExecutionReport fixReport( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       FIX::ExecType ( FIX::ExecType_REPLACE ),
@@ -44,22 +77,28 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
     fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
   }
 
-  void ReplyApplication::sendCancelConfirm( OrderPtr order,
-                                            const std::string &reason )
+  void ReplyApplication::onCancelConfirm( const OrderPtr &order,
+                                          const std::string &reason )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX::ExecType_CANCELED, FIX::OrdStatus_CANCELED, reason ) ;
+      return ;
+    }
+
     //DEBUG_1( "cancel confirm " ) ;
-    FIX42::ExecutionReport fixReport ( FIX::OrderID ( order->getOrderId() ),
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       FIX::ExecType ( FIX::ExecType_CANCELED ),
@@ -68,7 +107,7 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
@@ -79,18 +118,24 @@ namespace ESM {
       fixReport.set( FIX::Text( reason ) ) ;
     }
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
   }
 
 
-  void ReplyApplication::sendNewReject( OrderPtr order,
-                                        const std::string &reason )
+  void ReplyApplication::onNewReject( const OrderPtr &order,
+                                      const std::string &reason )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX::ExecType_NEW, FIX::OrdStatus_REJECTED, reason ) ;
+      return ;
+    }
+
     DEBUG_2( "New reject ", reason ) ;
 
-    FIX42::ExecutionReport fixReport ( FIX::OrderID ( order->getOrderId() ),
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       FIX::ExecType ( FIX::ExecType_NEW ),
@@ -99,24 +144,30 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
     fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
     fixReport.set( FIX::Text( reason ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
   }
 
-  void ReplyApplication::sendReplaceReject( OrderPtr order,
-                                            const std::string &reason )
+  void ReplyApplication::onReplaceReject( const OrderPtr &order,
+                                          const std::string &reason )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendCancelReject( order,
+          FIX::CxlRejResponseTo_ORDER_CANCEL_REPLACE_REQUEST, reason ) ;
+      return ;
+    }
+
     // DEBUG_2( "Replace reject", reason ) ;
     FIX42::OrderCancelReject replaceReject (
-                                            order->getOrderId() ,
+                                            ToFix::convert( order->getOrderId() ) ,
                                             order->getClientOrderId(),
                                             order->getOriginalClientOrderId(),
                                             FIX::OrdStatus ( FIX::OrdStatus_CALCULATED ),
@@ -124,17 +175,23 @@ namespace ESM {
 
     replaceReject.set ( FIX::Text ( reason ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( replaceReject, session ) ;
+    send( replaceReject, order ) ;
   }
 
-  void ReplyApplication::sendCancelReject( OrderPtr order,
-                                           const std::string &reason )
+  void ReplyApplication::onCancelReject( const OrderPtr &order,
+                                         const std::string &reason )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendCancelReject( order,
+          FIX::CxlRejResponseTo_ORDER_CANCEL_REQUEST, reason ) ;
+      return ;
+    }
+
     // DEBUG_2( "Cancel reject ", reason  ) ;
     FIX42::OrderCancelReject cancelReject (
-                                            order->getOrderId() ,
+                                            ToFix::convert( order->getOrderId() ) ,
                                             order->getClientOrderId(),
                                             order->getOriginalClientOrderId(),
                                             FIX::OrdStatus ( FIX::OrdStatus_CALCULATED ),
@@ -142,16 +199,22 @@ namespace ESM {
 
     cancelReject.set ( FIX::Text ( reason ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( cancelReject, session ) ;
+    send( cancelReject, order ) ;
   }
 
 
-  void ReplyApplication::sendMarketToLimit( OrderPtr order )
+  void ReplyApplication::onMarketToLimit( const OrderPtr &order )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX::ExecType_RESTATED, FIX::OrdStatus_NEW ) ;
+      return ;
+    }
+
     //DEBUG_1( "Market to limit ") ;
-    FIX42::ExecutionReport fixReport ( FIX::OrderID ( order->getOrderId() ),
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       FIX::ExecType ( FIX::ExecType_RESTATED ),
@@ -160,23 +223,29 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
     fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
-    fixReport.set( FIX::Price( order->getPrice() ) ) ;
+    fixReport.set( FIX::Price( order->getInstrument().toDouble( order->getPrice() ) ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
 
   }
 
-  void ReplyApplication::sendTriggered( OrderPtr order )
+  void ReplyApplication::onTriggered( const OrderPtr &order )
   {
+    LATENCY_START( ENCODE ) ;
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX_ExecType_TRIGGERED, FIX::OrdStatus_NEW ) ;
+      return ;
+    }
+
     //DEBUG_1( "Triggered" ) ;
-    FIX42::ExecutionReport fixReport ( FIX::OrderID ( order->getOrderId() ),
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       FIX::ExecType ( FIX_ExecType_TRIGGERED ),
@@ -185,20 +254,19 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
     fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
 
   }
 
-  void ReplyApplication::sendFillConfirm( OrderPtr order )
+  void ReplyApplication::onFillConfirm( const OrderPtr &order )
   {
+    LATENCY_START( ENCODE ) ;
     //DEBUG_1( "Fill confirm " ) ;
     FIX::ExecType lExecType ;
     FIX::OrdStatus lOrdStatus ;
@@ -213,7 +281,13 @@ namespace ESM {
       lOrdStatus = FIX::OrdStatus_PARTIALLY_FILLED ;
     }
 
-    FIX42::ExecutionReport fixReport ( FIX::OrderID ( order->getOrderId() ),
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order, lExecType, lOrdStatus ) ;
+      return ;
+    }
+
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
                                       FIX::ExecID ( "1" ),
                                       FIX::ExecTransType ( FIX::ExecTransType_NEW ),
                                       lExecType,
@@ -222,17 +296,58 @@ namespace ESM {
                                       ToFix::convert( order->getSide() ),
                                       FIX::LeavesQty ( order->getActualPendingQty() ),
                                       FIX::CumQty ( order->getFilledQty() ),
-                                      FIX::AvgPx ( order->getAvgPrice() )
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
                                       );
     fixReport.set( FIX::TransactTime() ) ;
     fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
     fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
     fixReport.set( FIX::LastShares( order->getLastShares() ) ) ;
-    fixReport.set( FIX::LastPx( order->getLastPrice() ) ) ;
+    fixReport.set( FIX::LastPx( order->getInstrument().toDouble( order->getLastPrice() ) ) ) ;
 
-    FIX::SessionID session ;
-    session.fromString( order->getSenderId() ) ;
-    FIX::Session::sendToTarget ( fixReport, session ) ;
+    send( fixReport, order ) ;
+  }
+
+  void ReplyApplication::onOrderStatus( const OrderPtr &order,
+                                        const std::string &text )
+  {
+    LATENCY_START( ENCODE ) ;
+    FIX::OrdStatus lOrdStatus = ToFix::convert( order->getStatus() ) ;
+
+    if( isSharedMemorySession( order ) )
+    {
+      _shmGateway->sendExecutionReport( order,
+          FIX_ExecType_ORDER_STATUS, lOrdStatus, text ) ;
+      return ;
+    }
+
+    // In FIX 4.2 a status reply carries ExecTransType STATUS and repeats
+    // the order status in ExecType.
+    FIX42::ExecutionReport fixReport ( ToFix::convert( order->getOrderId() ),
+                                      FIX::ExecID ( "1" ),
+                                      FIX::ExecTransType ( FIX::ExecTransType_STATUS ),
+                                      FIX::ExecType ( lOrdStatus ),
+                                      lOrdStatus,
+                                      FIX::Symbol ( order->getSecurityId () ),
+                                      ToFix::convert( order->getSide() ),
+                                      FIX::LeavesQty ( order->getActualPendingQty() ),
+                                      FIX::CumQty ( order->getFilledQty() ),
+                                      FIX::AvgPx ( order->getInstrument().toDouble( order->getAvgPrice() ) )
+                                      );
+    fixReport.set( FIX::TransactTime() ) ;
+    fixReport.set( FIX::ClOrdID( order->getClientOrderId() ) ) ;
+    fixReport.set( FIX::SecurityID( order->getSecurityId () ) ) ;
+    fixReport.set( FIX::OrderQty( order->getOrderQty() ) ) ;
+    if( order->getPrice() != 0 )
+    {
+      fixReport.set( FIX::Price( order->getInstrument().toDouble( order->getPrice() ) ) ) ;
+    }
+
+    if( text != "" )
+    {
+      fixReport.set( FIX::Text( text ) ) ;
+    }
+
+    send( fixReport, order ) ;
   }
 
 }
@@ -2,83 +2,63 @@
 #define ESM_REPLY_APPLICATION_H
 
 #include <boost/thread.hpp>
-#include "order.h"
+#include <quickfix/Message.h>
+#include "executionSink.h"
 
 namespace ESM {
 
+  class ShmGateway ;
+
   /**
    * \class ReplyApplication
    *
    * This class is used to generate and send the execution reports back to the
    * FIX client
    *
+   * It is the execution sink of the FIX engine. Orders of shared memory
+   * sessions are answered on their response ring instead.
+   *
    */
-  class ReplyApplication
+  class ReplyApplication : public ExecutionSink
   {
     public :
-      /**
-       * @brief Send a new order confirmation to the client.
-       *
-       * @param The order we will use to generate the confirmation.
-       */
-      void sendNewConfirm( OrderPtr order ) ;
+      ReplyApplication() : _shmGateway( 0 ) {}
 
       /**
-       * @brief Send a replace order confirmation to the client.
+       * @brief Route replies for shared memory sessions to this gateway
+       * instead of FIX.
        *
-       * @param The order we will use to generate the confirmation.
+       * @param The gateway owning the shared memory sessions.
        */
-      void sendReplaceConfirm( OrderPtr order ) ;
+      void setSharedMemoryGateway( ShmGateway *shmGateway )
+      {
+        _shmGateway = shmGateway ;
+      }
 
-      /**
-       * @brief Send a cancel order confirmation to the client.
-       *
-       * @param The order we will use to generate the confirmation.
-       */
-      void sendCancelConfirm( OrderPtr order, const std::string &reason ) ;
+    protected :
+      void onNewConfirm( const OrderPtr &order ) ;
+      void onReplaceConfirm( const OrderPtr &order ) ;
+      void onCancelConfirm( const OrderPtr &order, const std::string &reason ) ;
+      void onNewReject( const OrderPtr &order, const std::string &reason ) ;
+      void onReplaceReject( const OrderPtr &order, const std::string &reason ) ;
+      void onCancelReject( const OrderPtr &order, const std::string &reason ) ;
+      void onMarketToLimit( const OrderPtr &order ) ;
+      void onTriggered( const OrderPtr &order ) ;
+      void onFillConfirm( const OrderPtr &order ) ;
+      void onOrderStatus( const OrderPtr &order, const std::string &text ) ;
 
-      /**
-       * @brief Send a New Order Reject to the client.
-       *
-       * @param The order we will use to generate the reject.
-       */
-      void sendNewReject( OrderPtr order, const std::string &reason );
+    private :
+      ShmGateway *_shmGateway ;
 
       /**
-       * @brief Send a Replace Order Reject to the client.
-       *
-       * @param The order we will use to generate the reject.
+       * @brief Does the order belong to a shared memory session.
        */
-      void sendReplaceReject( OrderPtr order, const std::string &reason );
+      bool isSharedMemorySession( const OrderPtr &order ) const ;
 
       /**
-       * @brief Send a Cancel Order Reject to the client.
-       *
-       * @param The order we will use to generate the reject.
-       */
-      void sendCancelReject( OrderPtr order, const std::string &reason );
-
-      /**
-       * @brief A market order that could not be filled was converted to
-       * limit. Send the confirmation to the client.
-       *
-       * @param The order we will use to generate the confirmation.
-       */
-      void sendMarketToLimit( OrderPtr order ) ;
-
-      /**
-       * @brief Send a stop loss trigger confirmation to the client.
-       *
-       * @param The order we will use to generate the confirmation.
-       */
-      void sendTriggered( OrderPtr order ) ;
-
-      /**
-       * @brief Send trade confirmation to the client.
-       *
-       * @param The order we will use to send the trade confirmation.
+       * @brief Send a report to the FIX session of an order.
        */
-      void sendFillConfirm( OrderPtr order ) ;
+      void send( FIX::Message &message, const OrderPtr &order ) ;
   };
 }
 #endif // ESM_REPLY_APPLICATION_H
@@ -2,26 +2,66 @@
 #include <quickfix/fix42/Reject.h>
 #include "requestApplication.h"
 #include "fixToOrder.h"
-#include <dismantleFix.h>
+#include "constants.h"
+#include "../common/latency.h"
 
 namespace ESM {
+  namespace
+  {
+    const std::string DuplicateClOrdIdText( "Duplicate ClOrdID" ) ;
+  }
+
   RequestApplication::RequestApplication( const std::string &address,
-                                          const std::string &port )
-    : _market( _replyApplication, address, port ),
-      _orderGeneratorId( "orderGenerator" )
+                                          const std::string &port,
+                                          ExecutionSink *executionSink )
+#ifdef UDP_MARKET_DATA
+    : _executionSink( executionSink ? *executionSink : _replyApplication ),
+      _market( _executionSink ),
+      _riskGate( _market ),
+      _udpSender( address, port ),
+      _orderGeneratorId( "orderGenerator" ),
+      _cancelOnDisconnect( true ),
+      _ignoreOrderIds( false ),
+      _capture( 0 )
+  {
+    std::cout << "Sending market data on  : " << address << ":" << port << std::endl ;
+    _market.setMarketDataPublisher( &_udpSender ) ;
+  }
+#else
+    : _executionSink( executionSink ? *executionSink : _replyApplication ),
+      _market( _executionSink ),
+      _riskGate( _market ),
+      _orderGeneratorId( "orderGenerator" ),
+      _cancelOnDisconnect( true ),
+      _ignoreOrderIds( false ),
+      _capture( 0 )
   {
   }
+#endif
+
+  void RequestApplication::onLogout( const FIX::SessionID &sessionId )
+  {
+    if( _cancelOnDisconnect )
+    {
+      long canceled = _market.cancelAll( sessionId.toString(),
+          "Order Cancelled As Session Disconnected" ) ;
+      if( canceled > 0 )
+      {
+        std::cout << "Cancelled " << canceled << " orders of "
+                  << sessionId.toString() << " on disconnect" << std::endl ;
+      }
+    }
+  }
 
   void RequestApplication::toApp( FIX::Message&message, const FIX::SessionID& )
     throw( FIX::DoNotSend )
   {
-#ifndef NDEBUG
-    if(  message.getHeader().getField( FIX::FIELD::TargetCompID )
+    if( _capture != 0
+        && message.getHeader().getField( FIX::FIELD::TargetCompID )
             .find( _orderGeneratorId ) == std::string::npos  )
     {
-      UT::DismantleFix::dismantle( "OUTBOUND", message.toString() ) ;
+      _capture->append( UT::CaptureDirection_OUTBOUND, message.toString() ) ;
     }
-#endif
   }
 
   void RequestApplication::fromApp(const FIX::Message& message,
@@ -32,17 +72,29 @@ namespace ESM {
            FIX::UnsupportedMessageType )
 
   {
-#ifndef NDEBUG
-    if ( message.getHeader().getField( FIX::FIELD::SenderCompID )
+    LATENCY_SCOPE( RECEIVE ) ;
+    LATENCY_SCOPE( CRACK ) ;
+
+    if ( _capture != 0
+         && message.getHeader().getField( FIX::FIELD::SenderCompID )
             .find( _orderGeneratorId ) == std::string::npos )
     {
-      UT::DismantleFix::dismantle( "INBOUND", message.toString() ) ;
+      _capture->append( UT::CaptureDirection_INBOUND, message.toString() ) ;
     }
-#endif
 
     try
     {
-      crack( message, sessionId );
+      // OrderMassCancelRequest is not part of FIX 4.2, so the cracker does
+      // not know it. It is added to our data dictionary instead.
+      if( message.getHeader().getField( FIX::FIELD::MsgType )
+            == FIX_MsgType_ORDER_MASS_CANCEL_REQUEST )
+      {
+        onOrderMassCancelRequest( message, sessionId ) ;
+      }
+      else
+      {
+        crack( message, sessionId );
+      }
     }
     catch( std::exception &e )
     {
@@ -71,6 +123,176 @@ namespace ESM {
   void RequestApplication::onMessage (
       const FIX42::NewOrderSingle &newOrder,
       const FIX::SessionID &sessionId )
+  {
+    NewOrderPtr order = makeNewOrder( newOrder, sessionId ) ;
+
+    if( !getClientOrderIndex( sessionId ).insert( order->getClientOrderId(),
+                                                  order ) )
+    {
+      _executionSink.sendNewReject( order, DuplicateClOrdIdText ) ;
+      return ;
+    }
+
+    try
+    {
+      _riskGate.check( *order, getSessionRisk( sessionId ) ) ;
+    }
+    catch( RiskRejected &e )
+    {
+      _executionSink.sendNewReject( order, e.what() ) ;
+      return ;
+    }
+
+    LATENCY_STOP( CRACK ) ;
+    _market.insert( order ) ;
+  }
+
+  void RequestApplication::onMessage (
+      const FIX42::NewOrderList &newOrderList,
+      const FIX::SessionID &sessionId )
+  {
+    // Convert the whole list before sending anything to the market, so that
+    // a bad entry rejects the list without leaving part of it on the books.
+    std::vector< NewOrderPtr > orders ;
+    FIX42::NewOrderList::NoOrders group ;
+
+    size_t noOrders = newOrderList.groupCount( FIX::FIELD::NoOrders ) ;
+    orders.reserve( noOrders ) ;
+    for( size_t i = 1 ; i <= noOrders ; ++i )
+    {
+      newOrderList.getGroup( i, group ) ;
+      orders.push_back( makeNewOrder( group, sessionId ) ) ;
+    }
+
+    // Entries reusing a ClOrdID or failing a risk check are rejected on
+    // their own, the rest of the list goes through.
+    ClientOrderIndex &clientOrders = getClientOrderIndex( sessionId ) ;
+    SessionRisk &sessionRisk = getSessionRisk( sessionId ) ;
+    std::vector< NewOrderPtr > newOrders ;
+    newOrders.reserve( orders.size() ) ;
+    for( std::vector< NewOrderPtr >::iterator iOrder = orders.begin() ;
+         iOrder != orders.end() ;
+         ++iOrder )
+    {
+      if( !clientOrders.insert( ( *iOrder )->getClientOrderId(), *iOrder ) )
+      {
+        _executionSink.sendNewReject( *iOrder, DuplicateClOrdIdText ) ;
+        continue ;
+      }
+
+      try
+      {
+        _riskGate.check( **iOrder, sessionRisk ) ;
+        newOrders.push_back( *iOrder ) ;
+      }
+      catch( RiskRejected &e )
+      {
+        _executionSink.sendNewReject( *iOrder, e.what() ) ;
+      }
+    }
+
+    LATENCY_STOP( CRACK ) ;
+    _market.insert( newOrders ) ;
+  }
+
+  void RequestApplication::onMessage (
+      const FIX42::OrderStatusRequest &statusRequest,
+      const FIX::SessionID &sessionId )
+  {
+    std::string clientOrderId = statusRequest.getField( FIX::FIELD::ClOrdID ) ;
+    OrderPtr order = getClientOrderIndex( sessionId ).find( clientOrderId ) ;
+
+    if( !order )
+    {
+      FIX::Side lSide ;
+      statusRequest.getField( lSide ) ;
+
+      FIX::OrderID lOrderId( "NONE" ) ;
+      if( statusRequest.isSetField( lOrderId ) )
+      {
+        statusRequest.getField( lOrderId ) ;
+      }
+
+      // Never accepted, so the status sent back is rejected.
+      OrderPtr unknownOrder( new CancelReplaceOrder( FromFix::convert( lOrderId ),
+            "",
+            statusRequest.getField( FIX::FIELD::Symbol ),
+            clientOrderId,
+            sessionId.toString(),
+            FromFix::convert( lSide ),
+            OrderType_LIMIT,
+            0 ) ) ;
+      _executionSink.sendOrderStatus( unknownOrder, "Unknown ClOrdID" ) ;
+      return ;
+    }
+
+    _market.sendStatus( order ) ;
+  }
+
+  void RequestApplication::onOrderMassCancelRequest(
+      const FIX::Message &massCancel,
+      const FIX::SessionID &sessionId )
+  {
+    FIX::MassCancelRequestType lRequestType ;
+    massCancel.getField( lRequestType ) ;
+
+    bool buys = true ;
+    bool sells = true ;
+    FIX::Side lSide ;
+    if( massCancel.isSetField( lSide ) )
+    {
+      massCancel.getField( lSide ) ;
+      buys = FromFix::convert( lSide ) == Side_BUY ;
+      sells = !buys ;
+    }
+
+    FIX::MsgType lReportType( FIX_MsgType_ORDER_MASS_CANCEL_REPORT ) ;
+    FIX42::Message report( lReportType ) ;
+    report.setField( FIX::ClOrdID( massCancel.getField( FIX::FIELD::ClOrdID ) ) ) ;
+    report.setField( ToFix::convert( UT::UniqueOrderId::get() ) ) ;
+    report.setField( lRequestType ) ;
+    if( massCancel.isSetField( lSide ) )
+    {
+      report.setField( lSide ) ;
+    }
+
+    try
+    {
+      long canceled ;
+      switch( lRequestType )
+      {
+        case FIX::MassCancelRequestType_CANCEL_ORDERS_FOR_A_SECURITY :
+          {
+            std::string securityId = massCancel.getField( FIX::FIELD::SecurityID ) ;
+            report.setField( FIX::SecurityID( securityId ) ) ;
+            canceled = _market.massCancel( sessionId.toString(), securityId,
+                                           buys, sells ) ;
+          }
+          break ;
+        case FIX::MassCancelRequestType_CANCEL_ALL_ORDERS :
+          canceled = _market.massCancel( sessionId.toString(), "",
+                                         buys, sells ) ;
+          break ;
+        default :
+          throw OrderError( "MassCancelRequestType not handled" ) ;
+      }
+
+      report.setField( FIX::MassCancelResponse( lRequestType ) ) ;
+      report.setField( FIX::TotalAffectedOrders( canceled ) ) ;
+    }
+    catch( std::exception &e )
+    {
+      report.setField( FIX::MassCancelResponse(
+            FIX::MassCancelResponse_CANCEL_REQUEST_REJECTED ) ) ;
+      report.setField( FIX::Text( e.what() ) ) ;
+    }
+
+    FIX::Session::sendToTarget( report, sessionId ) ;
+  }
+
+  NewOrderPtr RequestApplication::makeNewOrder(
+      const FIX::FieldMap &newOrder,
+      const FIX::SessionID &sessionId )
   {
     FIX::Side lSide ;
     newOrder.getField( lSide ) ;
@@ -100,6 +322,13 @@ namespace ESM {
       }
     }catch( std::exception &e ) {}
 
+    FIX::ExpireTime lExpireTime ;
+    if( newOrder.isSetField( lExpireTime ) )
+    {
+      newOrder.getField( lExpireTime ) ;
+      order->setExpireTime( lExpireTime.getValue().getTimeT() ) ;
+    }
+
     FIX::MaxFloor lMaxFloor ;
     if( newOrder.isSetField( lMaxFloor ) )
     {
@@ -107,34 +336,41 @@ namespace ESM {
       order->setDisclosedQty( lMaxFloor ) ;
     }
 
+    FIX::MinQty lMinQty ;
+    if( newOrder.isSetField( lMinQty ) )
+    {
+      newOrder.getField( lMinQty ) ;
+      order->setMinQty( lMinQty ) ;
+    }
+
     switch( order->getOrderType() )
     {
       case OrderType_LIMIT :
         {
           FIX::Price lPrice ;
           newOrder.getField( lPrice ) ;
-          order->setPrice( lPrice ) ;
+          order->setPrice( order->getInstrument().toPrice( lPrice ) ) ;
         }
         break ;
       case OrderType_STOP_LIMIT :
         {
           FIX::Price lPrice ;
           newOrder.getField( lPrice ) ;
-          order->setPrice( lPrice ) ;
+          order->setPrice( order->getInstrument().toPrice( lPrice ) ) ;
         }
         // No break here
       case OrderType_STOP :
         {
           FIX::StopPx lStopPx ;
           newOrder.getField( lStopPx ) ;
-          order->setStopPrice( lStopPx ) ;
+          order->setStopPrice( order->getInstrument().toPrice( lStopPx ) ) ;
         }
         break ;
       case OrderType_MARKET :
         break ;
     }
 
-    _market.insert( order ) ;
+    return order ;
   }
 
   void RequestApplication::onMessage (
@@ -150,8 +386,12 @@ namespace ESM {
     FIX::OrderQty lOrderQty ;
     cancelOrder.getField( lOrderQty ) ;
 
+    ClientOrderIndex &clientOrders = getClientOrderIndex( sessionId ) ;
+    OrderPtr target = clientOrders.find(
+        cancelOrder.getField( FIX::FIELD::OrigClOrdID ) ) ;
+
     CancelOrderPtr order( new CancelOrder(
-          cancelOrder.getField( FIX::FIELD::OrderID ),
+          getOrderId( cancelOrder, target ),
           cancelOrder.getField( FIX::FIELD::OrigClOrdID ),
           cancelOrder.getField( FIX::FIELD::SecurityID ),
           cancelOrder.getField( FIX::FIELD::ClOrdID ),
@@ -160,8 +400,13 @@ namespace ESM {
           FromFix::convert( lOrdType ),
           lOrderQty ) ) ;
 
+    if( !clientOrders.insert( order->getClientOrderId(), target ) )
+    {
+      _executionSink.sendCancelReject( order, DuplicateClOrdIdText ) ;
+      return ;
+    }
 
-
+    LATENCY_STOP( CRACK ) ;
     _market.cancel( order ) ;
   }
 
@@ -178,8 +423,12 @@ namespace ESM {
     FIX::OrderQty lOrderQty ;
     replaceOrder.getField( lOrderQty ) ;
 
+    ClientOrderIndex &clientOrders = getClientOrderIndex( sessionId ) ;
+    OrderPtr target = clientOrders.find(
+        replaceOrder.getField( FIX::FIELD::OrigClOrdID ) ) ;
+
     ReplaceOrderPtr order( new ReplaceOrder(
-                               replaceOrder.getField( FIX::FIELD::OrderID ),
+                               getOrderId( replaceOrder, target ),
                                replaceOrder.getField( FIX::FIELD::OrigClOrdID ),
                                replaceOrder.getField( FIX::FIELD::SecurityID ),
                                replaceOrder.getField( FIX::FIELD::ClOrdID ),
@@ -199,6 +448,13 @@ namespace ESM {
       }
     }catch( std::exception &e ) {}
 
+    FIX::ExpireTime lExpireTime ;
+    if( replaceOrder.isSetField( lExpireTime ) )
+    {
+      replaceOrder.getField( lExpireTime ) ;
+      order->setExpireTime( lExpireTime.getValue().getTimeT() ) ;
+    }
+
     FIX::MaxFloor lMaxFloor ;
     if( replaceOrder.isSetField( lMaxFloor ) )
     {
@@ -212,21 +468,21 @@ namespace ESM {
         {
           FIX::Price lPrice ;
           replaceOrder.getField( lPrice ) ;
-          order->setPrice( lPrice ) ;
+          order->setPrice( order->getInstrument().toPrice( lPrice ) ) ;
         }
         break ;
       case OrderType_STOP_LIMIT :
         {
           FIX::Price lPrice ;
           replaceOrder.getField( lPrice ) ;
-          order->setPrice( lPrice ) ;
+          order->setPrice( order->getInstrument().toPrice( lPrice ) ) ;
         }
         // No break here
       case OrderType_STOP :
         {
           FIX::StopPx lStopPx ;
           replaceOrder.getField( lStopPx ) ;
-          order->setStopPrice( lStopPx ) ;
+          order->setStopPrice( order->getInstrument().toPrice( lStopPx ) ) ;
         }
         break ;
       case OrderType_MARKET :
@@ -237,12 +493,80 @@ namespace ESM {
     replaceOrder.getField( lCumQty ) ;
     order->addOrderQty( lCumQty ) ;
 
+    if( !clientOrders.insert( order->getClientOrderId(), target ) )
+    {
+      _executionSink.sendReplaceReject( order, DuplicateClOrdIdText ) ;
+      return ;
+    }
+
+    try
+    {
+      _riskGate.checkReplace( *order, target.get(), getSessionRisk( sessionId ) ) ;
+    }
+    catch( RiskRejected &e )
+    {
+      _executionSink.sendReplaceReject( order, e.what() ) ;
+      return ;
+    }
+
+    LATENCY_STOP( CRACK ) ;
     _market.replace( order ) ;
   }
 
+  void RequestApplication::onCreate( const FIX::SessionID &sessionId )
+  {
+    _clientOrderIndexes[ sessionId.toString() ].reset( new ClientOrderIndex ) ;
+    _sessionRisks[ sessionId.toString() ].reset( new SessionRisk ) ;
+  }
+
+  SessionRisk &RequestApplication::getSessionRisk(
+      const FIX::SessionID &sessionId )
+  {
+    SessionRiskMap::iterator iRisk = _sessionRisks.find( sessionId.toString() ) ;
+    if( iRisk == _sessionRisks.end() )
+    {
+      throw OrderError( "Unknown session " + sessionId.toString() ) ;
+    }
+    return *iRisk->second ;
+  }
+
+  ClientOrderIndex &RequestApplication::getClientOrderIndex(
+      const FIX::SessionID &sessionId )
+  {
+    ClientOrderIndexMap::iterator iIndex =
+      _clientOrderIndexes.find( sessionId.toString() ) ;
+    if( iIndex == _clientOrderIndexes.end() )
+    {
+      throw OrderError( "Unknown session " + sessionId.toString() ) ;
+    }
+    return *iIndex->second ;
+  }
+
+  OrderId RequestApplication::getOrderId( const FIX::FieldMap &request,
+                                          const OrderPtr &target )
+  {
+    FIX::OrderID lOrderId ;
+    if( !_ignoreOrderIds && request.isSetField( lOrderId ) )
+    {
+      request.getField( lOrderId ) ;
+      return FromFix::convert( lOrderId ) ;
+    }
+    // An unknown OrigClOrdID leaves this 0 and the order book rejects the
+    // request.
+    return target ? target->getOrderId() : 0 ;
+  }
+
   void RequestApplication::readCommands()
   {
     _market.readCommands() ;
   }
 
+  void RequestApplication::startSharedMemoryGateway(
+      const std::vector< std::string > &clients )
+  {
+    _shmGateway.reset( new ShmGateway( _market, _riskGate, clients ) ) ;
+    _replyApplication.setSharedMemoryGateway( _shmGateway.get() ) ;
+    _shmGateway->start() ;
+  }
+
 }
@@ -4,11 +4,19 @@
 #include <quickfix/Application.h>
 #include <quickfix/MessageCracker.h>
 #include <quickfix/fix42/NewOrderSingle.h>
+#include <quickfix/fix42/NewOrderList.h>
 #include <quickfix/fix42/OrderCancelRequest.h>
 #include <quickfix/fix42/OrderCancelReplaceRequest.h>
+#include <quickfix/fix42/OrderStatusRequest.h>
 
+#include "../common/fixCapture.h"
+#include "clientOrderIndex.h"
+#include "fixMarketDataHandler.h"
 #include "market.h"
 #include "replyApplication.h"
+#include "riskGate.h"
+#include "shmGateway.h"
+#include "udpSender.h"
 
 namespace ESM {
   /**
@@ -16,8 +24,16 @@ namespace ESM {
    *
    * QuickFIX Application class to handle the following messages:
    * * NewOrderSingle
+   * * NewOrderList
    * * OrderCancelReplaceRequest
    * * OrderCancelRequest
+   * * OrderMassCancelRequest
+   * * OrderStatusRequest
+   *
+   * ClOrdIDs may not be reused within a session. Cancels and replaces may
+   * name their order by OrigClOrdID alone.
+   *
+   * New orders and replaces pass the risk gate before reaching the market.
    *
    */
   class RequestApplication :
@@ -25,12 +41,18 @@ namespace ESM {
     public FIX::MessageCracker
   {
     public :
+      /**
+       * @param The UDP host & port of the market data, if sent on UDP.
+       * @param Where the execution reports go instead of the FIX sessions,
+       * e.g. when replaying a log.
+       */
       RequestApplication( const std::string &address,
-                          const std::string &port ) ;
+                          const std::string &port,
+                          ExecutionSink *executionSink = 0 ) ;
 
-      void onCreate(const FIX::SessionID&) {}
+      void onCreate(const FIX::SessionID& ) ;
       void onLogon(const FIX::SessionID&) {}
-      void onLogout(const FIX::SessionID&) {}
+      void onLogout(const FIX::SessionID& ) ;
       void toAdmin(FIX::Message&, const FIX::SessionID&) {}
       void fromAdmin( const FIX::Message&, const FIX::SessionID& )
         throw( FIX::FieldNotFound,
@@ -48,25 +70,119 @@ namespace ESM {
 
       void onMessage ( const FIX42::NewOrderSingle&,
                        const FIX::SessionID& );
+      void onMessage ( const FIX42::NewOrderList&,
+                       const FIX::SessionID& );
       void onMessage ( const FIX42::OrderCancelRequest&,
                        const FIX::SessionID& );
       void onMessage ( const FIX42::OrderCancelReplaceRequest&,
                        const FIX::SessionID& );
+      void onMessage ( const FIX42::OrderStatusRequest&,
+                       const FIX::SessionID& );
 
       void readCommands() ;
 
+      Market &getMarket() { return _market ; }
+
+      /**
+       * @brief Accept orders from co-located clients over shared memory.
+       *
+       * @param The names of the clients.
+       */
+      void startSharedMemoryGateway( const std::vector< std::string > &clients ) ;
+
+      /**
+       * @brief Cancel the resting orders of a FIX session when it logs out
+       * or disconnects. On by default.
+       */
+      void setCancelOnDisconnect( bool cancelOnDisconnect )
+      {
+        _cancelOnDisconnect = cancelOnDisconnect ;
+      }
+
+      /**
+       * @brief Find the order of a cancel / replace by its OrigClOrdID
+       * only, ignoring the OrderID of the request. Used by replays, whose
+       * orders do not get the OrderIDs of the run logged.
+       */
+      void setIgnoreOrderIds( bool ignoreOrderIds )
+      {
+        _ignoreOrderIds = ignoreOrderIds ;
+      }
+
+      /**
+       * @brief Capture the messages of every session but the order
+       * generator. None are captured by default.
+       */
+      void setCapture( UT::FixCapture *capture )
+      {
+        _capture = capture ;
+      }
+
+      /**
+       * @brief Set the pre-trade risk limits of every session, FIX and
+       * shared memory.
+       */
+      void setRiskLimits( const RiskLimits &limits )
+      {
+        _riskGate.setLimits( limits ) ;
+      }
+
+      /**
+       * @brief Follow a schedule of call auctions & continuous trading.
+       */
+      void setTradingSchedule( const TradingSchedule &tradingSchedule )
+      {
+        _market.setTradingSchedule( tradingSchedule ) ;
+      }
+
+      /**
+       * @brief Expire DAY orders at a local time of day.
+       */
+      void setSessionEnd( const boost::posix_time::time_duration &sessionEnd )
+      {
+        _market.setSessionEnd( sessionEnd ) ;
+      }
+
+      /**
+       * @brief Send the market data from this many threads.
+       */
+      void setMarketDataThreads( int marketDataThreads )
+      {
+        _market.setMarketDataThreads( marketDataThreads ) ;
+      }
+
+      /**
+       * @brief Keep bars of the trades at these intervals, in seconds.
+       */
+      void setBarIntervals( const std::vector< long > &intervals,
+                            size_t history )
+      {
+        _market.setBarIntervals( intervals, history ) ;
+      }
+
 #ifndef UDP_MARKET_DATA
       void setMarketDataApplication(MarketDataApplication* md)
       {
-        _market.setMarketDataApplication( md );
+        _market.setMarketDataPublisher( md );
+        md->setMarket( &_market ) ;
       }
 #endif
 
     private :
       ReplyApplication _replyApplication ;
 
+      ExecutionSink &_executionSink ;
+
       Market _market ;
 
+      RiskGate _riskGate ;
+
+      boost::scoped_ptr< ShmGateway > _shmGateway ;
+
+#ifdef UDP_MARKET_DATA
+      UdpSender _udpSender ;
+#endif
+
       void reject( const FIX::SessionID &sessionId,
                    const FIX::MsgSeqNum &msgSeqNum,
                    const FIX::MsgType &msgType,
@@ -76,6 +192,54 @@ namespace ESM {
                    ) {}
 
       std::string _orderGeneratorId ;
+
+      bool _cancelOnDisconnect ;
+
+      bool _ignoreOrderIds ;
+
+      UT::FixCapture *_capture ;
+
+      /**
+       * The ClOrdID index of every session. Sessions are all created by
+       * the acceptor before any of them starts, after which this map is
+       * only read.
+       */
+      typedef boost::unordered_map< std::string, ClientOrderIndexPtr >
+        ClientOrderIndexMap ;
+      ClientOrderIndexMap _clientOrderIndexes ;
+
+      ClientOrderIndex &getClientOrderIndex( const FIX::SessionID &sessionId ) ;
+
+      /**
+       * The risk state of every session, created with the ClOrdID index.
+       */
+      typedef boost::unordered_map< std::string, SessionRiskPtr >
+        SessionRiskMap ;
+      SessionRiskMap _sessionRisks ;
+
+      SessionRisk &getSessionRisk( const FIX::SessionID &sessionId ) ;
+
+      /**
+       * @brief The OrderID of the order a cancel / replace refers to: the
+       * one in the request if present and not ignored, else the one of the
+       * order found by OrigClOrdID.
+       */
+      OrderId getOrderId( const FIX::FieldMap &request,
+                          const OrderPtr &target ) ;
+
+      /**
+       * @brief Cancel all the orders of the session, optionally restricted
+       * to one security and / or side.
+       */
+      void onOrderMassCancelRequest( const FIX::Message&,
+                                     const FIX::SessionID& ) ;
+
+      /**
+       * @brief Build a new order from a NewOrderSingle or from one entry of
+       * a NewOrderList.
+       */
+      NewOrderPtr makeNewOrder( const FIX::FieldMap &newOrder,
+                                const FIX::SessionID &sessionId ) ;
   };
 }
 #endif // ESM_REQUEST_APPLICATION_H
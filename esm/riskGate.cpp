@@ -0,0 +1,115 @@
+#include "riskGate.h"
+#include "market.h"
+
+#include <boost/lexical_cast.hpp>
+
+namespace ESM
+{
+  void RiskGate::check( Order &order, SessionRisk &session )
+  {
+    InstrumentRisk *risk = session.find( order.getSecurityId() ) ;
+    if( risk == 0 )
+    {
+      // First order of the session in this instrument, the only time the
+      // market is asked for anything.
+      risk = session.add( order.getSecurityId(),
+                          _market.getPriceBand( order.getSecurityId() ) ) ;
+    }
+
+    checkOrder( order, &risk->priceBand ) ;
+
+    if( _limits.maxOpenOrders > 0 &&
+        session.getOpenOrders().value.load( boost::memory_order_relaxed )
+          >= _limits.maxOpenOrders )
+    {
+      throw RiskRejected( "Too many open orders" ) ;
+    }
+
+    checkPosition( *risk, order.getSide() == Side_BUY, order.getOrderQty() ) ;
+
+    session.getOpenOrders().value.fetch_add( 1, boost::memory_order_relaxed ) ;
+    order.setRisk( risk ) ;
+  }
+
+  void RiskGate::checkReplace( const Order &order,
+                               const Order *target,
+                               SessionRisk &session )
+  {
+    InstrumentRisk *risk = session.find( order.getSecurityId() ) ;
+    checkOrder( order, risk ? &risk->priceBand : 0 ) ;
+
+    // The order book rejects a replace of an unknown order anyway.
+    if( risk != 0 && target != 0 )
+    {
+      checkPosition( *risk, target->getSide() == Side_BUY,
+                     order.getOrderQty() - target->getOrderQty() ) ;
+    }
+  }
+
+  void RiskGate::checkPosition( const InstrumentRisk &risk,
+                                bool isBuy,
+                                long qty )
+  {
+    if( _limits.maxPosition <= 0 || qty <= 0 )
+    {
+      return ;
+    }
+
+    long position = risk.position.value.load( boost::memory_order_relaxed ) ;
+    if( isBuy )
+    {
+      position += risk.openBuyQty.value.load( boost::memory_order_relaxed ) + qty ;
+    }
+    else
+    {
+      position -= risk.openSellQty.value.load( boost::memory_order_relaxed ) + qty ;
+    }
+
+    // Only the side the order adds to is checked, so that an order
+    // reducing a position over the limit goes through.
+    if( isBuy ? position > _limits.maxPosition
+              : position < -_limits.maxPosition )
+    {
+      throw RiskRejected( "Position limit would be exceeded" ) ;
+    }
+  }
+
+  void RiskGate::checkOrder( const Order &order, const PriceBand *priceBand )
+  {
+    if( _limits.maxOrderQty > 0 && order.getOrderQty() > _limits.maxOrderQty )
+    {
+      throw RiskRejected( "Order quantity above "
+          + boost::lexical_cast< std::string >( _limits.maxOrderQty ) ) ;
+    }
+
+    long lower = 0 ;
+    long upper = 0 ;
+    if( priceBand != 0 )
+    {
+      lower = priceBand->lower.value.load( boost::memory_order_relaxed ) ;
+      upper = priceBand->upper.value.load( boost::memory_order_relaxed ) ;
+    }
+
+    bool hasPrice = order.getOrderType() == OrderType_LIMIT
+                    || order.getOrderType() == OrderType_STOP_LIMIT ;
+
+    if( hasPrice && upper > 0 &&
+        ( order.getPrice() < lower || order.getPrice() > upper ) )
+    {
+      throw RiskRejected( "Price outside of circuit limits" ) ;
+    }
+
+    if( _limits.maxOrderNotional > 0 )
+    {
+      // Market orders are valued at the upper circuit limit, if known.
+      long price = hasPrice ? order.getPrice() : upper ;
+      double notional = order.getOrderQty()
+                        * order.getInstrument().toDouble( price ) ;
+      if( notional > _limits.maxOrderNotional )
+      {
+        throw RiskRejected( "Order notional above "
+            + boost::lexical_cast< std::string >( _limits.maxOrderNotional ) ) ;
+      }
+    }
+  }
+}
@@ -0,0 +1,191 @@
+#ifndef ESM_RISK_GATE_H
+#define ESM_RISK_GATE_H
+
+#include <string>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "../common/spscRing.h"
+
+namespace ESM
+{
+  class Order ;
+  class Market ;
+
+  /**
+   * A counter alone on its cache line, so that counters written by
+   * different threads do not slow each other down.
+   */
+  struct RiskCounter
+  {
+    RiskCounter() : value( 0 ) {}
+
+    boost::atomic< long > value ;
+    char padding[ UT::CACHE_LINE_SIZE - sizeof( boost::atomic< long > ) ] ;
+  };
+
+  /**
+   * The circuit limits of an instrument. Written by its order book, read by
+   * the risk gate. 0 means not known yet.
+   */
+  struct PriceBand
+  {
+    RiskCounter lower ;
+    RiskCounter upper ;
+  };
+  typedef boost::shared_ptr< PriceBand > PriceBandPtr ;
+
+  /**
+   * The exposure of one session in one instrument. Reached from the orders
+   * of that session, so that the matching thread updates it without any
+   * lookup.
+   */
+  struct InstrumentRisk
+  {
+    InstrumentRisk( RiskCounter &openOrders, const PriceBand &priceBand )
+      : openOrders( openOrders ),
+        priceBand( priceBand )
+    {}
+
+    /**
+     * Filled buys - filled sells.
+     */
+    RiskCounter position ;
+
+    /**
+     * The quantity of the open buy & sell orders still to be filled, which
+     * the position may yet reach.
+     */
+    RiskCounter openBuyQty ;
+    RiskCounter openSellQty ;
+
+    /**
+     * The open orders of the session, in all instruments.
+     */
+    RiskCounter &openOrders ;
+
+    const PriceBand &priceBand ;
+  };
+  typedef boost::shared_ptr< InstrumentRisk > InstrumentRiskPtr ;
+
+  /**
+   * \class SessionRisk
+   *
+   * The risk state of a session. The instrument map is only used by the
+   * thread reading the session. The counters are also updated by the
+   * matching threads.
+   *
+   */
+  class SessionRisk
+  {
+    public :
+      RiskCounter &getOpenOrders() { return _openOrders ; }
+
+      /**
+       * @return The exposure in an instrument, 0 if the session has not
+       *         traded it yet.
+       */
+      InstrumentRisk *find( const std::string &securityId )
+      {
+        InstrumentRisksMap::iterator iRisk = _instrumentRisks.find( securityId ) ;
+        return iRisk == _instrumentRisks.end() ? 0 : iRisk->second.get() ;
+      }
+
+      InstrumentRisk *add( const std::string &securityId,
+                           const PriceBand &priceBand )
+      {
+        InstrumentRiskPtr risk( new InstrumentRisk( _openOrders, priceBand ) ) ;
+        _instrumentRisks[ securityId ] = risk ;
+        return risk.get() ;
+      }
+
+    private :
+      RiskCounter _openOrders ;
+
+      typedef boost::unordered_map< std::string, InstrumentRiskPtr >
+        InstrumentRisksMap ;
+      InstrumentRisksMap _instrumentRisks ;
+  };
+  typedef boost::shared_ptr< SessionRisk > SessionRiskPtr ;
+
+  /**
+   * Limits applied to every session. 0 disables a limit.
+   */
+  struct RiskLimits
+  {
+    RiskLimits()
+      : maxOrderQty( 0 ),
+        maxOrderNotional( 0 ),
+        maxOpenOrders( 0 ),
+        maxPosition( 0 )
+    {}
+
+    long maxOrderQty ;
+    double maxOrderNotional ;
+    long maxOpenOrders ;
+    long maxPosition ;
+  };
+
+  /**
+   * \class RiskGate
+   *
+   * Pre-trade checks run by the gateway thread before an order goes to its
+   * order book:
+   * * the limit price is within the circuit limits of the instrument
+   * * order quantity & notional
+   * * open orders of the session
+   * * position of the session in the instrument, if the order and every
+   *   open order of the session on the same side are filled
+   *
+   * The gate only reads counters, it takes no lock. An order that passes
+   * carries a pointer to its counters; the order updates them itself as it
+   * is filled and finished.
+   *
+   */
+  class RiskGate
+  {
+    public :
+      RiskGate( Market &market ) : _market( market ) {}
+
+      void setLimits( const RiskLimits &limits ) { _limits = limits ; }
+
+      /**
+       * @brief Check a new order and count it as open.
+       *
+       * @param The order.
+       * @param The risk state of the order's session.
+       *
+       * Throws RiskRejected if a check fails.
+       */
+      void check( Order &order, SessionRisk &session ) ;
+
+      /**
+       * @brief Check the new price & quantity of a replace, and the
+       *        position if it adds to the quantity of its order.
+       *
+       * @param The replace order.
+       * @param The order it replaces, 0 if not known.
+       * @param The risk state of the order's session.
+       *
+       * Throws RiskRejected if a check fails.
+       */
+      void checkReplace( const Order &order,
+                         const Order *target,
+                         SessionRisk &session ) ;
+
+    private :
+      Market &_market ;
+      RiskLimits _limits ;
+
+      void checkOrder( const Order &order, const PriceBand *priceBand ) ;
+
+      /**
+       * @brief Check the position the session would reach if its open
+       *        orders on a side, and more quantity, were all filled.
+       */
+      void checkPosition( const InstrumentRisk &risk, bool isBuy, long qty ) ;
+  };
+}
+
+#endif // ESM_RISK_GATE_H
@@ -0,0 +1,573 @@
+#include "shmGateway.h"
+
+#include <string.h>
+
+#include "../common/latency.h"
+
+namespace ESM
+{
+  const std::string ShmGateway::SenderIdPrefix = "SHM:" ;
+
+  namespace
+  {
+    /**
+     * Strings in the rings are written by the client, so never trust them
+     * to be terminated.
+     */
+    std::string toString( const char *value )
+    {
+      return std::string( value, strnlen( value, ShmIdLength ) ) ;
+    }
+
+    void copyString( char *destination, const std::string &value, size_t size )
+    {
+      size_t length = value.size() < size ? value.size() : size - 1 ;
+      memcpy( destination, value.data(), length ) ;
+      destination[ length ] = '\0' ;
+    }
+  }
+
+  ShmGateway::ShmGateway( Market &market,
+                          RiskGate &riskGate,
+                          const std::vector< std::string > &clients )
+    : _market( market ),
+      _riskGate( riskGate ),
+      _isRunning( false )
+  {
+    for( std::vector< std::string >::const_iterator iClient = clients.begin() ;
+         iClient != clients.end() ;
+         ++iClient )
+    {
+      ChannelPtr channel( new Channel ) ;
+      channel->senderId = SenderIdPrefix + *iClient ;
+
+      channel->requestMemory.reset( new UT::SharedMemory(
+            shmRequestRingName( *iClient ), sizeof( ShmRequestRing ), true ) ) ;
+      channel->responseMemory.reset( new UT::SharedMemory(
+            shmResponseRingName( *iClient ), sizeof( ShmResponseRing ), true ) ) ;
+
+      channel->requests =
+        static_cast< ShmRequestRing * >( channel->requestMemory->getAddress() ) ;
+      channel->responses =
+        static_cast< ShmResponseRing * >( channel->responseMemory->getAddress() ) ;
+      channel->requests->init() ;
+      channel->responses->init() ;
+
+      channel->expectedSeqNo = 1 ;
+      channel->outSeqNo = 0 ;
+      channel->stalledSince = 0 ;
+      channel->isLogoutPending = false ;
+      channel->isOverflowed.store( false ) ;
+      channel->isDead.store( false ) ;
+
+      _channels.push_back( channel ) ;
+      _channelsBySenderId[ channel->senderId ] = channel ;
+
+      std::cout << "Shared memory order entry for " << *iClient << " on "
+                << channel->requestMemory->getName() << " / "
+                << channel->responseMemory->getName() << std::endl ;
+    }
+  }
+
+  ShmGateway::~ShmGateway()
+  {
+    stop() ;
+
+    for( std::vector< ChannelPtr >::iterator iChannel = _channels.begin() ;
+         iChannel != _channels.end() ;
+         ++iChannel )
+    {
+      ( *iChannel )->requestMemory->unlink() ;
+      ( *iChannel )->responseMemory->unlink() ;
+    }
+  }
+
+  void ShmGateway::start()
+  {
+    if( !_isRunning.exchange( true ) )
+    {
+      _thread = boost::thread( &ShmGateway::poll, this ) ;
+    }
+  }
+
+  void ShmGateway::stop()
+  {
+    if( _isRunning.exchange( false ) )
+    {
+      _thread.join() ;
+    }
+  }
+
+  void ShmGateway::poll()
+  {
+    const ShmRequest *request ;
+
+    while( _isRunning.load( boost::memory_order_relaxed ) )
+    {
+      for( std::vector< ChannelPtr >::iterator iChannel = _channels.begin() ;
+           iChannel != _channels.end() ;
+           ++iChannel )
+      {
+        Channel &channel = **iChannel ;
+        while( ( request = channel.requests->front() ) != 0 )
+        {
+          process( channel, *request ) ;
+          channel.requests->pop() ;
+        }
+        deliverResponses( channel ) ;
+      }
+    }
+  }
+
+  void ShmGateway::process( Channel &channel, const ShmRequest &request )
+  {
+    LATENCY_SCOPE( RECEIVE ) ;
+    LATENCY_SCOPE( CRACK ) ;
+
+    if( request.getMsgType() == ShmMsgType_LOGON )
+    {
+      logon( channel, request ) ;
+      return ;
+    }
+    if( channel.isDead.load( boost::memory_order_relaxed ) )
+    {
+      reject( channel, request, "Logged out, send a Logon" ) ;
+      return ;
+    }
+    if( request.getSeqNo() < channel.expectedSeqNo )
+    {
+      reject( channel, request, "Sequence number too low" ) ;
+      return ;
+    }
+    if( request.getSeqNo() > channel.expectedSeqNo )
+    {
+      // Not processed; the client resends from the expected number.
+      reject( channel, request, "Sequence gap" ) ;
+      return ;
+    }
+    channel.expectedSeqNo = request.getSeqNo() + 1 ;
+
+    try
+    {
+      switch( request.getMsgType() )
+      {
+        case ShmMsgType_NEW_ORDER :
+          insert( channel, request ) ;
+          break ;
+        case ShmMsgType_CANCEL :
+          cancel( channel, request ) ;
+          break ;
+        case ShmMsgType_REPLACE :
+          replace( channel, request ) ;
+          break ;
+        case ShmMsgType_ORDER_STATUS :
+          sendStatus( channel, request ) ;
+          break ;
+        default :
+          reject( channel, request, "Unknown MsgType" ) ;
+      }
+    }
+    catch( std::exception &e )
+    {
+      reject( channel, request, e.what() ) ;
+    }
+  }
+
+  void ShmGateway::logon( Channel &channel, const ShmRequest &request )
+  {
+    if( request.getSeqNo() != 1 )
+    {
+      reject( channel, request, "Logon must have SeqNo 1" ) ;
+      return ;
+    }
+
+    if( channel.isDead.load( boost::memory_order_relaxed ) )
+    {
+      dropResponses( channel ) ;
+      channel.isLogoutPending = false ;
+      channel.isOverflowed.store( false, boost::memory_order_relaxed ) ;
+      channel.isDead.store( false, boost::memory_order_relaxed ) ;
+      std::cout << "Shared memory client " << channel.senderId
+                << " logged on again" << std::endl ;
+    }
+    channel.expectedSeqNo = 2 ;
+
+    // Numbered 1 once delivered, after the replies queued before it.
+    uint64_t ticket ;
+    ShmResponse *response = claimResponse( channel, ticket ) ;
+    if( response == 0 )
+    {
+      return ;
+    }
+    memset( response, 0, sizeof( ShmResponse ) ) ;
+    response->setMsgType( ShmMsgType_LOGON ) ;
+    response->setRefSeqNo( request.getSeqNo() ) ;
+    publishResponse( channel, ticket ) ;
+  }
+
+  void ShmGateway::insert( Channel &channel, const ShmRequest &request )
+  {
+    NewOrderPtr order( new NewOrder( toString( request.getSecurityId() ),
+                                     toString( request.getClOrdId() ),
+                                     channel.senderId,
+                                     static_cast< Side >( request.getSide() ),
+                                     static_cast< OrderType >( request.getOrdType() ),
+                                     request.getOrderQty() ) ) ;
+
+    order->setTimeInForce( static_cast< TimeInForce >( request.getTimeInForce() ) ) ;
+    order->setExpireTime( request.getExpireTime() ) ;
+    order->setMinQty( request.getMinQty() ) ;
+    if( request.getDisclosedQty() > 0 )
+    {
+      order->setDisclosedQty( request.getDisclosedQty() ) ;
+    }
+    setPrices( *order, request ) ;
+
+    if( !channel.clientOrders.insert( order->getClientOrderId(), order ) )
+    {
+      reject( channel, request, "Duplicate ClOrdID " + order->getClientOrderId() ) ;
+      return ;
+    }
+
+    try
+    {
+      _riskGate.check( *order, channel.risk ) ;
+    }
+    catch( RiskRejected &e )
+    {
+      // Never live, so the index may drop it.
+      order->finish() ;
+      reject( channel, request, e.what() ) ;
+      return ;
+    }
+
+    LATENCY_STOP( CRACK ) ;
+    _market.insert( order ) ;
+  }
+
+  void ShmGateway::cancel( Channel &channel, const ShmRequest &request )
+  {
+    OrderId orderId ;
+    OrderPtr target ;
+    if( !resolve( channel, request, orderId, target ) )
+    {
+      return ;
+    }
+
+    CancelOrderPtr order( new CancelOrder( orderId,
+                                           toString( request.getOrigClOrdId() ),
+                                           toString( request.getSecurityId() ),
+                                           toString( request.getClOrdId() ),
+                                           channel.senderId,
+                                           static_cast< Side >( request.getSide() ),
+                                           static_cast< OrderType >( request.getOrdType() ),
+                                           request.getOrderQty() ) ) ;
+    LATENCY_STOP( CRACK ) ;
+    _market.cancel( order ) ;
+  }
+
+  void ShmGateway::replace( Channel &channel, const ShmRequest &request )
+  {
+    OrderId orderId ;
+    OrderPtr target ;
+    if( !resolve( channel, request, orderId, target ) )
+    {
+      return ;
+    }
+
+    ReplaceOrderPtr order( new ReplaceOrder( orderId,
+                                             toString( request.getOrigClOrdId() ),
+                                             toString( request.getSecurityId() ),
+                                             toString( request.getClOrdId() ),
+                                             channel.senderId,
+                                             static_cast< Side >( request.getSide() ),
+                                             static_cast< OrderType >( request.getOrdType() ),
+                                             request.getOrderQty() ) ) ;
+
+    order->setTimeInForce( static_cast< TimeInForce >( request.getTimeInForce() ) ) ;
+    order->setExpireTime( request.getExpireTime() ) ;
+    if( request.getDisclosedQty() > 0 )
+    {
+      order->setDisclosedQty( request.getDisclosedQty() ) ;
+    }
+    setPrices( *order, request ) ;
+
+    try
+    {
+      _riskGate.checkReplace( *order, target.get(), channel.risk ) ;
+    }
+    catch( RiskRejected &e )
+    {
+      reject( channel, request, e.what() ) ;
+      return ;
+    }
+
+    LATENCY_STOP( CRACK ) ;
+    _market.replace( order ) ;
+  }
+
+  void ShmGateway::setPrices( Order &order, const ShmRequest &request )
+  {
+    switch( order.getOrderType() )
+    {
+      case OrderType_LIMIT :
+        order.setPrice( request.getPrice() ) ;
+        break ;
+      case OrderType_STOP_LIMIT :
+        order.setPrice( request.getPrice() ) ;
+        // No break here
+      case OrderType_STOP :
+        order.setStopPrice( request.getStopPrice() ) ;
+        break ;
+      case OrderType_MARKET :
+        break ;
+    }
+  }
+
+  void ShmGateway::sendStatus( Channel &channel, const ShmRequest &request )
+  {
+    OrderPtr order = channel.clientOrders.find( toString( request.getClOrdId() ) ) ;
+    if( !order )
+    {
+      reject( channel, request, "Unknown ClOrdID" ) ;
+      return ;
+    }
+    _market.sendStatus( order ) ;
+  }
+
+  bool ShmGateway::resolve( Channel &channel,
+                            const ShmRequest &request,
+                            OrderId &orderId,
+                            OrderPtr &target )
+  {
+    target = channel.clientOrders.find( toString( request.getOrigClOrdId() ) ) ;
+
+    std::string clientOrderId = toString( request.getClOrdId() ) ;
+    if( !channel.clientOrders.insert( clientOrderId, target ) )
+    {
+      reject( channel, request, "Duplicate ClOrdID " + clientOrderId ) ;
+      return false ;
+    }
+
+    orderId = UT::UniqueOrderId::fromString( toString( request.getOrderId() ) ) ;
+    if( orderId == 0 && target )
+    {
+      orderId = target->getOrderId() ;
+    }
+    return true ;
+  }
+
+  void ShmGateway::reject( Channel &channel,
+                           const ShmRequest &request,
+                           const std::string &reason )
+  {
+    bool isDead = channel.isDead.load( boost::memory_order_relaxed ) ;
+    uint64_t ticket ;
+    ShmResponse *slot ;
+    if( isDead )
+    {
+      // After the Logout, if the client reads at all.
+      slot = channel.isLogoutPending ? 0 : channel.responses->claim() ;
+    }
+    else
+    {
+      slot = claimResponse( channel, ticket ) ;
+    }
+    if( slot == 0 )
+    {
+      return ;
+    }
+    ShmResponse &response = *slot ;
+    memset( &response, 0, sizeof( ShmResponse ) ) ;
+
+    response.setMsgType( ShmMsgType_REJECT ) ;
+    response.setRefSeqNo( request.getSeqNo() ) ;
+    response.setSide( request.getSide() ) ;
+    copyString( response.getRefSecurityId(), toString( request.getSecurityId() ), ShmIdLength ) ;
+    copyString( response.getRefClOrdId(), toString( request.getClOrdId() ), ShmIdLength ) ;
+    copyString( response.getRefOrigClOrdId(), toString( request.getOrigClOrdId() ), ShmIdLength ) ;
+    copyString( response.getRefOrderId(), toString( request.getOrderId() ), ShmIdLength ) ;
+    copyString( response.getRefText(), reason, ShmTextLength ) ;
+
+    if( isDead )
+    {
+      response.setSeqNo( ++channel.outSeqNo ) ;
+      channel.responses->publish() ;
+    }
+    else
+    {
+      publishResponse( channel, ticket ) ;
+    }
+  }
+
+  void ShmGateway::sendExecutionReport( OrderPtr order,
+                                        char execType,
+                                        char ordStatus,
+                                        const std::string &text )
+  {
+    Channel &channel = getChannel( order->getSenderId() ) ;
+    uint64_t ticket ;
+    ShmResponse *slot = claimResponse( channel, ticket ) ;
+    if( slot == 0 )
+    {
+      return ;
+    }
+    ShmResponse &response = *slot ;
+    memset( &response, 0, sizeof( ShmResponse ) ) ;
+
+    response.setMsgType( ShmMsgType_EXECUTION_REPORT ) ;
+    response.setExecType( execType ) ;
+    response.setOrdStatus( ordStatus ) ;
+    response.setSide( order->getSide() ) ;
+    response.setRefSeqNo( 0 ) ;
+    response.setLeavesQty( order->getActualPendingQty() ) ;
+    response.setCumQty( order->getFilledQty() ) ;
+    response.setAvgPrice( order->getAvgPrice() ) ;
+    response.setLastQty( order->getLastShares() ) ;
+    response.setLastPrice( order->getLastPrice() ) ;
+    response.setPrice( order->getPrice() ) ;
+    copyString( response.getRefSecurityId(), order->getSecurityId(), ShmIdLength ) ;
+    copyString( response.getRefClOrdId(), order->getClientOrderId(), ShmIdLength ) ;
+    copyString( response.getRefOrigClOrdId(), order->getOriginalClientOrderId(), ShmIdLength ) ;
+    copyString( response.getRefOrderId(),
+                UT::UniqueOrderId::toString( order->getOrderId() ), ShmIdLength ) ;
+    copyString( response.getRefText(), text, ShmTextLength ) ;
+
+    publishResponse( channel, ticket ) ;
+  }
+
+  void ShmGateway::sendCancelReject( OrderPtr order,
+                                     char responseTo,
+                                     const std::string &text )
+  {
+    Channel &channel = getChannel( order->getSenderId() ) ;
+    uint64_t ticket ;
+    ShmResponse *slot = claimResponse( channel, ticket ) ;
+    if( slot == 0 )
+    {
+      return ;
+    }
+    ShmResponse &response = *slot ;
+    memset( &response, 0, sizeof( ShmResponse ) ) ;
+
+    response.setMsgType( ShmMsgType_CANCEL_REJECT ) ;
+    response.setCxlRejResponseTo( responseTo ) ;
+    response.setSide( order->getSide() ) ;
+    response.setRefSeqNo( 0 ) ;
+    copyString( response.getRefSecurityId(), order->getSecurityId(), ShmIdLength ) ;
+    copyString( response.getRefClOrdId(), order->getClientOrderId(), ShmIdLength ) ;
+    copyString( response.getRefOrigClOrdId(), order->getOriginalClientOrderId(), ShmIdLength ) ;
+    copyString( response.getRefOrderId(),
+                UT::UniqueOrderId::toString( order->getOrderId() ), ShmIdLength ) ;
+    copyString( response.getRefText(), text, ShmTextLength ) ;
+
+    publishResponse( channel, ticket ) ;
+  }
+
+  ShmResponse *ShmGateway::claimResponse( Channel &channel, uint64_t &ticket )
+  {
+    if( channel.isDead.load( boost::memory_order_relaxed ) )
+    {
+      return 0 ;
+    }
+    ShmResponse *response = channel.pendingResponses.claim( ticket ) ;
+    if( response == 0 )
+    {
+      // The gateway thread logs the client out.
+      channel.isOverflowed.store( true, boost::memory_order_relaxed ) ;
+    }
+    return response ;
+  }
+
+  void ShmGateway::deliverResponses( Channel &channel )
+  {
+    if( channel.isOverflowed.load( boost::memory_order_relaxed )
+        && !channel.isDead.load( boost::memory_order_relaxed ) )
+    {
+      disconnect( channel, "Too many responses waiting" ) ;
+    }
+
+    if( channel.isDead.load( boost::memory_order_relaxed ) )
+    {
+      // Replies queued while the client was being logged out.
+      dropResponses( channel ) ;
+      if( channel.isLogoutPending )
+      {
+        ShmResponse *response = channel.responses->claim() ;
+        if( response != 0 )
+        {
+          memset( response, 0, sizeof( ShmResponse ) ) ;
+          response->setMsgType( ShmMsgType_LOGOUT ) ;
+          copyString( response->getRefText(), channel.logoutText, ShmTextLength ) ;
+          response->setSeqNo( ++channel.outSeqNo ) ;
+          channel.responses->publish() ;
+          channel.isLogoutPending = false ;
+        }
+      }
+      return ;
+    }
+
+    const ShmResponse *pending ;
+    while( ( pending = channel.pendingResponses.front() ) != 0 )
+    {
+      ShmResponse *response = channel.responses->claim() ;
+      if( response == 0 )
+      {
+        // Left queued for the next poll, unless the client stopped reading.
+        time_t now = time( 0 ) ;
+        if( channel.stalledSince == 0 )
+        {
+          channel.stalledSince = now ;
+        }
+        else if( now - channel.stalledSince >= StallTimeout )
+        {
+          disconnect( channel, "Responses not read" ) ;
+        }
+        return ;
+      }
+
+      memcpy( response, pending, sizeof( ShmResponse ) ) ;
+      if( response->getMsgType() == ShmMsgType_LOGON )
+      {
+        channel.outSeqNo = 0 ;
+      }
+      response->setSeqNo( ++channel.outSeqNo ) ;
+      channel.responses->publish() ;
+      channel.pendingResponses.pop() ;
+    }
+    channel.stalledSince = 0 ;
+  }
+
+  void ShmGateway::disconnect( Channel &channel, const std::string &reason )
+  {
+    channel.isDead.store( true, boost::memory_order_relaxed ) ;
+    channel.isLogoutPending = true ;
+    channel.logoutText = reason ;
+    channel.stalledSince = 0 ;
+    dropResponses( channel ) ;
+
+    std::cout << "Shared memory client " << channel.senderId
+              << " logged out: " << reason << std::endl ;
+
+    // The cancels are not confirmed, the Logout says so.
+    _market.cancelAll( channel.senderId, reason ) ;
+  }
+
+  void ShmGateway::dropResponses( Channel &channel )
+  {
+    while( channel.pendingResponses.front() != 0 )
+    {
+      channel.pendingResponses.pop() ;
+    }
+  }
+
+  ShmGateway::Channel &ShmGateway::getChannel( const std::string &senderId )
+  {
+    ChannelsBySenderId::iterator iChannel = _channelsBySenderId.find( senderId ) ;
+    if( iChannel == _channelsBySenderId.end() )
+    {
+      throw OrderError( "Unknown shared memory session " + senderId ) ;
+    }
+    return *iChannel->second ;
+  }
+}
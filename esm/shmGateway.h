@@ -0,0 +1,277 @@
+#ifndef ESM_SHM_GATEWAY_H
+#define ESM_SHM_GATEWAY_H
+
+#include <time.h>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "../common/mpscRing.h"
+#include "../common/sharedMemory.h"
+#include "clientOrderIndex.h"
+#include "market.h"
+#include "riskGate.h"
+#include "shmMessages.h"
+
+namespace ESM
+{
+  /**
+   * \class ShmGateway
+   *
+   * Order entry for clients running on the same host as uMatch.
+   *
+   * Each client gets a request and a response ring in /dev/shm. A single
+   * thread polls all the request rings and calls into the Market. Replies
+   * for orders of these clients are routed back here by the
+   * ReplyApplication, queued on the client's channel without waiting and
+   * written to its response ring by the polling thread.
+   *
+   * The matching threads never wait for a client. Replies which do not
+   * fit in the response ring wait in a preallocated queue of the channel
+   * and are written as the client reads. A client is logged out when that
+   * queue fills up, or when it has not read a response for StallTimeout
+   * seconds while replies wait: its orders are cancelled, the replies
+   * waiting are dropped and its requests are rejected until it sends a
+   * Logon (see shmMessages.h).
+   *
+   * Session semantics are the same as on FIX: a client's sequence numbers
+   * must increase by one, a request after a gap is rejected (see
+   * shmMessages.h), and ClOrdIDs may not be reused. Cancels and
+   * replaces may leave the OrderID empty and name their order by
+   * OrigClOrdID.
+   *
+   */
+  class ShmGateway
+  {
+    public :
+      /**
+       * @brief Create the rings for each client.
+       *
+       * @param The market into which orders will be sent.
+       *
+       * @param The risk gate new orders and replaces must pass.
+       *
+       * @param The names of the clients. The rings are created as
+       *        /dev/shm/umatch.<client>.req and /dev/shm/umatch.<client>.rsp
+       */
+      ShmGateway( Market &market,
+                  RiskGate &riskGate,
+                  const std::vector< std::string > &clients ) ;
+
+      ~ShmGateway() ;
+
+      /**
+       * @brief Start the thread polling the request rings.
+       */
+      void start() ;
+
+      /**
+       * @brief Stop the polling thread.
+       */
+      void stop() ;
+
+      /**
+       * @brief Is the sender id of an order one of our clients.
+       */
+      static bool isSharedMemorySession( const std::string &senderId )
+      {
+        return senderId.compare( 0, SenderIdPrefix.size(), SenderIdPrefix ) == 0 ;
+      }
+
+      /**
+       * @brief Send an execution report for an order to its client.
+       *
+       * @param The order.
+       * @param The FIX ExecType of the report.
+       * @param The FIX OrdStatus of the report.
+       * @param Optional text.
+       */
+      void sendExecutionReport( OrderPtr order,
+                                char execType,
+                                char ordStatus,
+                                const std::string &text = "" ) ;
+
+      /**
+       * @brief Send a cancel / replace reject for an order to its client.
+       *
+       * @param The order.
+       * @param The FIX CxlRejResponseTo of the reject.
+       * @param The reason for the reject.
+       */
+      void sendCancelReject( OrderPtr order,
+                             char responseTo,
+                             const std::string &text ) ;
+
+      /**
+       * The replies of a client which may wait for its response ring, and
+       * the seconds it may leave them unread.
+       */
+      enum { PendingCapacity = 32768, StallTimeout = 5 } ;
+
+    private :
+      static const std::string SenderIdPrefix ;
+
+      typedef UT::MpscRing< ShmResponse, PendingCapacity > PendingResponseRing ;
+
+      /**
+       * The state kept for every client.
+       */
+      struct Channel
+      {
+        std::string senderId ;
+
+        boost::scoped_ptr< UT::SharedMemory > requestMemory ;
+        boost::scoped_ptr< UT::SharedMemory > responseMemory ;
+
+        ShmRequestRing *requests ;
+        ShmResponseRing *responses ;
+
+        /**
+         * Only the gateway thread touches these.
+         */
+        long long expectedSeqNo ;
+        ClientOrderIndex clientOrders ;
+        SessionRisk risk ;
+        long long outSeqNo ;
+
+        /**
+         * When the replies waiting last found the response ring full, 0
+         * if they did not.
+         */
+        time_t stalledSince ;
+
+        /**
+         * A Logout is due once the response ring has room.
+         */
+        bool isLogoutPending ;
+        std::string logoutText ;
+
+        /**
+         * Replies can be generated by any thread that matches against an
+         * order of this client, so they are queued here and moved to the
+         * response ring by the gateway thread.
+         */
+        PendingResponseRing pendingResponses ;
+
+        /**
+         * Set by a thread which found pendingResponses full.
+         */
+        boost::atomic< bool > isOverflowed ;
+
+        /**
+         * Set while the client is logged out.
+         */
+        boost::atomic< bool > isDead ;
+      };
+      typedef boost::shared_ptr< Channel > ChannelPtr ;
+
+      std::vector< ChannelPtr > _channels ;
+
+      typedef boost::unordered_map< std::string, ChannelPtr > ChannelsBySenderId ;
+      ChannelsBySenderId _channelsBySenderId ;
+
+      Market &_market ;
+      RiskGate &_riskGate ;
+
+      boost::thread _thread ;
+      boost::atomic< bool > _isRunning ;
+
+      /**
+       * @brief The loop run by the polling thread.
+       */
+      void poll() ;
+
+      /**
+       * @brief Check the session rules and pass a request to the market.
+       */
+      void process( Channel &channel, const ShmRequest &request ) ;
+
+      /**
+       * @brief Start the session of a client again, numbering both ways
+       * from 1.
+       */
+      void logon( Channel &channel, const ShmRequest &request ) ;
+
+      /**
+       * @brief Build a new / cancel / replace order from a request.
+       */
+      void insert( Channel &channel, const ShmRequest &request ) ;
+      void cancel( Channel &channel, const ShmRequest &request ) ;
+      void replace( Channel &channel, const ShmRequest &request ) ;
+
+      /**
+       * @brief Set the prices the order type needs, checking them against
+       * the tick table.
+       */
+      void setPrices( Order &order, const ShmRequest &request ) ;
+
+      /**
+       * @brief Answer a status request for the order with the ClOrdID of
+       * the request.
+       */
+      void sendStatus( Channel &channel, const ShmRequest &request ) ;
+
+      /**
+       * @brief The OrderID of the order a cancel / replace refers to, and
+       * record the ClOrdID of the request against it.
+       *
+       * @param Set to the order found by OrigClOrdID, empty if unknown.
+       *
+       * @return False if the ClOrdID was already used.
+       */
+      bool resolve( Channel &channel,
+                    const ShmRequest &request,
+                    OrderId &orderId,
+                    OrderPtr &target ) ;
+
+      /**
+       * @brief Reject a request which did not reach the market. Written
+       * straight to the response ring, if it has room, while the client is
+       * logged out.
+       */
+      void reject( Channel &channel,
+                   const ShmRequest &request,
+                   const std::string &reason ) ;
+
+      /**
+       * @brief A slot for a new reply of a client, to be filled and then
+       * passed to publishResponse(). Does not wait.
+       *
+       * @param Set to the ticket of the slot.
+       *
+       * @return 0 if the client is logged out or too many replies wait.
+       */
+      ShmResponse *claimResponse( Channel &channel, uint64_t &ticket ) ;
+
+      void publishResponse( Channel &channel, uint64_t ticket )
+      {
+        channel.pendingResponses.publish( ticket ) ;
+      }
+
+      /**
+       * @brief Write the queued replies of a client to its response ring,
+       * in the order they were queued, as far as it has room. Log the
+       * client out if it falls too far behind.
+       */
+      void deliverResponses( Channel &channel ) ;
+
+      /**
+       * @brief Log out a client which does not read its responses and
+       * cancel its orders.
+       *
+       * @param The reason sent in the Logout.
+       */
+      void disconnect( Channel &channel, const std::string &reason ) ;
+
+      /**
+       * @brief Drop the replies waiting for a client.
+       */
+      void dropResponses( Channel &channel ) ;
+
+      Channel &getChannel( const std::string &senderId ) ;
+  };
+}
+
+#endif // ESM_SHM_GATEWAY_H
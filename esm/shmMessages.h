@@ -0,0 +1,106 @@
+#ifndef ESM_SHM_MESSAGES_H
+#define ESM_SHM_MESSAGES_H
+
+#include "../common/definesForCreateEndianless.h"
+#include "../common/spscRing.h"
+
+namespace ESM
+{
+  /**
+   * Messages exchanged with co-located clients over the shared memory
+   * transport. Every client has a request ring which it writes and uMatch
+   * reads, and a response ring which uMatch writes and the client reads.
+   *
+   * Side, OrdType and TimeInForce carry the values of the native enums in
+   * structures.h. Prices are fixed-point: the decimal price multiplied by
+   * the price scale of the instrument (see instruments file). ExpireTime is
+   * in seconds since the epoch, for GTD orders. MinQty is only read on new
+   * orders.
+   *
+   * Requests are numbered from 1 by SeqNo. A request whose SeqNo is not
+   * the next one expected is rejected and not processed, and the number
+   * expected does not move: after a gap the client resends from the
+   * first request missing. Responses are numbered from 1 by SeqNo too;
+   * rejects carry the SeqNo of their request in RefSeqNo.
+   *
+   * A client which leaves too many responses unread is logged out: it
+   * gets a Logout with the reason in Text, its orders are cancelled
+   * without confirmations and its later requests are rejected. A Logon
+   * with SeqNo 1 starts the session again, and may also be sent at any
+   * time to reset the numbers, e.g. by a client which restarted. Its
+   * answer is a Logon numbered 1; the responses before it belong to the
+   * previous session.
+   */
+  const UT::CHAR ShmMsgType_NEW_ORDER = 'D' ;
+  const UT::CHAR ShmMsgType_CANCEL = 'F' ;
+  const UT::CHAR ShmMsgType_REPLACE = 'G' ;
+  const UT::CHAR ShmMsgType_ORDER_STATUS = 'H' ;
+  const UT::CHAR ShmMsgType_LOGON = 'A' ;
+  const UT::CHAR ShmMsgType_LOGOUT = '5' ;
+  const UT::CHAR ShmMsgType_EXECUTION_REPORT = '8' ;
+  const UT::CHAR ShmMsgType_CANCEL_REJECT = '9' ;
+  const UT::CHAR ShmMsgType_REJECT = '3' ;
+
+  const unsigned long ShmRingCapacity = 4096 ;
+  const unsigned long ShmIdLength = 24 ;
+  const unsigned long ShmTextLength = 64 ;
+
+  struct ShmRequest
+  {
+    UT_CREATE_CHAR( MsgType ) ;
+    UT_CREATE_CHAR( Side ) ;
+    UT_CREATE_CHAR( OrdType ) ;
+    UT_CREATE_CHAR( TimeInForce ) ;
+    UT_CREATE_LONGLONG( SeqNo ) ;
+    UT_CREATE_LONGLONG( OrderQty ) ;
+    UT_CREATE_LONGLONG( DisclosedQty ) ;
+    UT_CREATE_LONGLONG( Price ) ;
+    UT_CREATE_LONGLONG( StopPrice ) ;
+    UT_CREATE_LONGLONG( ExpireTime ) ;
+    UT_CREATE_LONGLONG( MinQty ) ;
+    UT_CREATE_STRING( SecurityId, ShmIdLength ) ;
+    UT_CREATE_STRING( ClOrdId, ShmIdLength ) ;
+    UT_CREATE_STRING( OrigClOrdId, ShmIdLength ) ;
+    UT_CREATE_STRING( OrderId, ShmIdLength ) ;
+  };
+
+  struct ShmResponse
+  {
+    UT_CREATE_CHAR( MsgType ) ;
+    UT_CREATE_CHAR( ExecType ) ;
+    UT_CREATE_CHAR( OrdStatus ) ;
+    UT_CREATE_CHAR( Side ) ;
+    UT_CREATE_CHAR( CxlRejResponseTo ) ;
+    UT_CREATE_LONGLONG( SeqNo ) ;
+    UT_CREATE_LONGLONG( RefSeqNo ) ;
+    UT_CREATE_LONGLONG( LeavesQty ) ;
+    UT_CREATE_LONGLONG( CumQty ) ;
+    UT_CREATE_LONGLONG( AvgPrice ) ;
+    UT_CREATE_LONGLONG( LastQty ) ;
+    UT_CREATE_LONGLONG( LastPrice ) ;
+    UT_CREATE_LONGLONG( Price ) ;
+    UT_CREATE_STRING( SecurityId, ShmIdLength ) ;
+    UT_CREATE_STRING( ClOrdId, ShmIdLength ) ;
+    UT_CREATE_STRING( OrigClOrdId, ShmIdLength ) ;
+    UT_CREATE_STRING( OrderId, ShmIdLength ) ;
+    UT_CREATE_STRING( Text, ShmTextLength ) ;
+  };
+
+  typedef UT::SpscRing< ShmRequest, ShmRingCapacity > ShmRequestRing ;
+  typedef UT::SpscRing< ShmResponse, ShmRingCapacity > ShmResponseRing ;
+
+  /**
+   * @brief Name of the segments in /dev/shm used by a client.
+   */
+  inline std::string shmRequestRingName( const std::string &client )
+  {
+    return "/umatch." + client + ".req" ;
+  }
+
+  inline std::string shmResponseRingName( const std::string &client )
+  {
+    return "/umatch." + client + ".rsp" ;
+  }
+}
+
+#endif // ESM_SHM_MESSAGES_H
@@ -41,7 +41,26 @@ namespace ESM
   enum TimeInForce
   {
     TimeInForce_DAY,
-    TimeInForce_IOC
+    TimeInForce_IOC,
+    TimeInForce_GTC,
+    TimeInForce_GTD,
+    TimeInForce_FOK
+  };
+
+  enum OrderStatus
+  {
+    OrderStatus_NEW,
+    OrderStatus_PARTIALLY_FILLED,
+    OrderStatus_FILLED,
+    OrderStatus_CANCELED,
+    OrderStatus_REJECTED
+  };
+
+  enum TradingPhase
+  {
+    TradingPhase_CONTINUOUS,
+    TradingPhase_CALL_AUCTION,
+    TradingPhase_CLOSED
   };
 
   struct Header
@@ -117,6 +136,10 @@ namespace ESM
       UT_CREATE_LONG( UpperCktLimit ) ;
       UT_CREATE_LONG( WeightedAvgPrice ) ;
       UT_INCLUDE_STRUCT_ARRAY( Depth, 5 ) ;
+      UT_CREATE_LONG( TradingPhase ) ;
+      UT_CREATE_LONG( IndicativePrice ) ;
+      UT_CREATE_LONG( IndicativeQty ) ;
+      UT_CREATE_LONG( Imbalance ) ;
 
       public :
       Record()
@@ -124,7 +147,9 @@ namespace ESM
         _LowPrice( -1 ), _NoOfTrades( 0 ), _Volume( 0 ), _Value( 0 ),
         _LastTradeQty( 0 ), _LastTradePrice( 0 ), _TotalBuyQty( 0 ), _TotalSellQty( 0 ),
         _TradeValueFlag( 'N' ), _Trend( '+' ), _SixLakhFlag( 'N' ), _AllNoneFlag( 'N' ),
-        _LowerCktLimit( 0 ), _UpperCktLimit( 0 ), _WeightedAvgPrice( 0 )
+        _LowerCktLimit( 0 ), _UpperCktLimit( 0 ), _WeightedAvgPrice( 0 ),
+        _TradingPhase( TradingPhase_CONTINUOUS ), _IndicativePrice( 0 ),
+        _IndicativeQty( 0 ), _Imbalance( 0 )
       {}
 
       void print() const
@@ -154,6 +179,10 @@ namespace ESM
         {
           _Depth[i].print() ;
         }
+        DEBUG_2( "TradingPhase :  ", _TradingPhase );
+        DEBUG_2( "IndicativePrice :  ", _IndicativePrice );
+        DEBUG_2( "IndicativeQty :  ", _IndicativeQty );
+        DEBUG_2( "Imbalance :  ", _Imbalance );
       }
     };
 
@@ -187,6 +216,86 @@ namespace ESM
     }
   };
 
+
+  /**
+   * Bars of trades over fixed intervals, each record one instrument over
+   * one interval, sent once the interval is over. Only intervals with
+   * trades have a bar.
+   */
+  const UT::LONG MsgType_BARS = 1907 ;
+  struct Bars : public Header //1907
+  {
+    enum MAX { MaxNoOfRecs = 10 } ;
+
+    struct Record
+    {
+      UT_CREATE_LONG( ScripCode ) ;
+      UT_CREATE_LONG( Interval ) ;          // seconds
+      UT_CREATE_LONGLONG( StartTime ) ;     // ms since the epoch
+      UT_CREATE_LONG( OpenPrice ) ;
+      UT_CREATE_LONG( HighPrice ) ;
+      UT_CREATE_LONG( LowPrice ) ;
+      UT_CREATE_LONG( ClosePrice ) ;
+      UT_CREATE_LONG( NoOfTrades ) ;
+      UT_CREATE_LONG( WeightedAvgPrice ) ;
+      UT_CREATE_LONGLONG( Volume ) ;
+      UT_CREATE_LONGLONG( Value ) ;
+
+      public :
+      Record()
+        : _ScripCode( 0 ), _Interval( 0 ), _StartTime( 0 ), _OpenPrice( 0 ),
+        _HighPrice( 0 ), _LowPrice( 0 ), _ClosePrice( 0 ), _NoOfTrades( 0 ),
+        _WeightedAvgPrice( 0 ), _Volume( 0 ), _Value( 0 )
+      {}
+
+      void print() const
+      {
+        DEBUG_1( "MsgType Is BarsDetail ") ;
+
+        DEBUG_2( "ScripCode :  ", _ScripCode );
+        DEBUG_2( "Interval :  ", _Interval );
+        DEBUG_2( "StartTime :  ", _StartTime );
+        DEBUG_2( "OpenPrice :  ", _OpenPrice );
+        DEBUG_2( "HighPrice :  ", _HighPrice );
+        DEBUG_2( "LowPrice :  ", _LowPrice );
+        DEBUG_2( "ClosePrice :  ", _ClosePrice );
+        DEBUG_2( "NoOfTrades :  ", _NoOfTrades );
+        DEBUG_2( "WeightedAvgPrice :  ", _WeightedAvgPrice );
+        DEBUG_2( "Volume :  ", _Volume );
+        DEBUG_2( "Value :  ", _Value );
+      }
+    };
+
+    UT_CREATE_SHORT( SequenceNo ) ;
+    UT_CREATE_SHORT( TradingSession ) ;
+    UT_CREATE_SHORT( NoOfRecs ) ;
+    UT_CREATE_SHORT( Filler ) ;
+    UT_CREATE_RECORD( Bars ) ;
+
+    public :
+    Bars()
+      : Header( sizeof( Bars ) , MsgType_BARS ),
+        _SequenceNo( 0 ), _TradingSession( 3 ),
+        _NoOfRecs( 0 ), _Filler( 0 )
+    {
+      reset();
+    }
+
+    void print() const
+    {
+      DEBUG_1( "MsgType Is BarsHeader ") ;
+
+      DEBUG_2( "SequenceNo :  ", _SequenceNo );
+      DEBUG_2( "TradingSession :  ", _TradingSession );
+      DEBUG_2( "NoOfRecs :  ", _NoOfRecs );
+      DEBUG_2( "Filler :  ", _Filler );
+      for( int i = 0 ; i < _NoOfRecs ; i ++ )
+      {
+        _Records[i].print() ;
+      }
+    }
+  };
+
 }
 
 #endif // ESM_STRUCTURES_H
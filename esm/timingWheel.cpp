@@ -0,0 +1,110 @@
+#include "timingWheel.h"
+
+namespace ESM
+{
+  TimingWheel::TimingWheel( long now )
+    : _time( now )
+  {
+  }
+
+  void TimingWheel::arm( Order &order )
+  {
+    order.disarm() ;
+    place( order, _time + 1 ) ;
+  }
+
+  void TimingWheel::place( Order &order, long earliest )
+  {
+    long expireTime = order.getExpireTime() > earliest ? order.getExpireTime()
+                                                        : earliest ;
+    long delta = expireTime - _time ;
+
+    for( int level = 0 ; level < Levels ; ++level )
+    {
+      if( delta < ( 1L << ( SlotBits * ( level + 1 ) ) ) )
+      {
+        _slots[ level ][ ( expireTime >> ( SlotBits * level ) ) & SlotMask ]
+          .push_back( order ) ;
+        return ;
+      }
+    }
+
+    // Beyond the wheel: wait in the furthest slot, the order is placed
+    // again when it comes round.
+    long furthest = _time + ( 1L << ( SlotBits * Levels ) ) - 1 ;
+    _slots[ Levels - 1 ][ ( furthest >> ( SlotBits * ( Levels - 1 ) ) ) & SlotMask ]
+      .push_back( order ) ;
+  }
+
+  void TimingWheel::cascade( int level )
+  {
+    long index = ( _time >> ( SlotBits * level ) ) & SlotMask ;
+    if( index == 0 && level + 1 < Levels )
+    {
+      cascade( level + 1 ) ;
+    }
+
+    Slot orders ;
+    orders.swap( _slots[ level ][ index ] ) ;
+    while( !orders.empty() )
+    {
+      Order &order = orders.front() ;
+      orders.pop_front() ;
+      // The slot of this second is taken right after the cascade.
+      place( order, _time ) ;
+    }
+  }
+
+  void TimingWheel::advance( long now, std::vector< Order * > &expired )
+  {
+    while( _time < now )
+    {
+      ++_time ;
+      if( ( _time & SlotMask ) == 0 )
+      {
+        cascade( 1 ) ;
+      }
+
+      Slot &due = _slots[ 0 ][ _time & SlotMask ] ;
+      while( !due.empty() )
+      {
+        Order &order = due.front() ;
+        due.pop_front() ;
+        expired.push_back( &order ) ;
+      }
+    }
+  }
+
+  long TimingWheel::getNextDue() const
+  {
+    long nextDue = 0 ;
+    for( long offset = 1 ; offset < Slots ; ++offset )
+    {
+      if( !_slots[ 0 ][ ( _time + offset ) & SlotMask ].empty() )
+      {
+        nextDue = _time + offset ;
+        break ;
+      }
+    }
+
+    // A slot of a level above is spread when the time reaches its start,
+    // which can come before the first slot due below.
+    for( int level = 1 ; level < Levels ; ++level )
+    {
+      long window = _time >> ( SlotBits * level ) ;
+      for( long offset = 1 ; offset <= Slots ; ++offset )
+      {
+        if( !_slots[ level ][ ( window + offset ) & SlotMask ].empty() )
+        {
+          long start = ( window + offset ) << ( SlotBits * level ) ;
+          if( nextDue == 0 || start < nextDue )
+          {
+            nextDue = start ;
+          }
+          break ;
+        }
+      }
+    }
+    return nextDue ;
+  }
+}
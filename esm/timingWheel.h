@@ -0,0 +1,97 @@
+#ifndef ESM_TIMING_WHEEL_H
+#define ESM_TIMING_WHEEL_H
+
+#include <vector>
+#include <boost/intrusive/list.hpp>
+
+#include "order.h"
+
+namespace ESM
+{
+  /**
+   * \class TimingWheel
+   *
+   * The expire times of the resting orders of an order book, in seconds.
+   *
+   * The wheel has 4 levels of 64 slots. Level 0 holds the orders expiring
+   * in the next 64 seconds, one slot per second; each level above covers
+   * 64 times the span of the one below, up to about 194 days. Orders
+   * further out wait in the last level and are placed again as it turns.
+   * When a level wraps, the next slot of the level above is spread over the
+   * levels below.
+   *
+   * Orders are linked into their slot by a hook of their own, so arming and
+   * disarming are O(1) and take no allocation. Advancing hands back every
+   * order due, whatever the number, in a single call.
+   *
+   * The wheel is used under the lock of its order book.
+   *
+   */
+  class TimingWheel
+  {
+    public :
+      /**
+       * @param The current time, in seconds since the epoch.
+       */
+      explicit TimingWheel( long now ) ;
+
+      /**
+       * @brief Put an order on the wheel at its expire time. An order that
+       * is already on the wheel is moved. An expire time that has passed
+       * is due on the next advance.
+       */
+      void arm( Order &order ) ;
+
+      /**
+       * @brief Move the wheel up to a time.
+       *
+       * @param The current time, in seconds since the epoch.
+       * @param The orders that expired are appended here, off the wheel.
+       */
+      void advance( long now, std::vector< Order * > &expired ) ;
+
+      /**
+       * @brief When the wheel next needs to be advanced: the second of the
+       * first order due within 64 seconds, or the time the next orders
+       * further out are spread over the levels below if that is earlier.
+       *
+       * @return 0 if the wheel is empty.
+       */
+      long getNextDue() const ;
+
+    private :
+      enum
+      {
+        SlotBits = 6,
+        Slots = 1 << SlotBits,
+        SlotMask = Slots - 1,
+        Levels = 4
+      };
+
+      typedef boost::intrusive::list< Order,
+                boost::intrusive::member_hook< Order, ExpiryHook,
+                                               &Order::_expiryHook >,
+                boost::intrusive::constant_time_size< false >
+              > Slot ;
+
+      Slot _slots[ Levels ][ Slots ] ;
+
+      /**
+       * The last second processed.
+       */
+      long _time ;
+
+      /**
+       * @brief Link an order into its slot, due no sooner than a time.
+       */
+      void place( Order &order, long earliest ) ;
+
+      /**
+       * @brief Spread the current slot of a level over the levels below,
+       *        after the level above it if that one wraps too.
+       */
+      void cascade( int level ) ;
+  };
+}
+
+#endif // ESM_TIMING_WHEEL_H
@@ -0,0 +1,116 @@
+#include "tradingSchedule.h"
+#include "../common/exceptions.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace ESM
+{
+  TradingSchedule::TradingSchedule( const std::string &schedule )
+  {
+    std::vector< std::string > entries ;
+    boost::split( entries, schedule, boost::is_any_of( "," ) ) ;
+
+    for( std::vector< std::string >::iterator iEntry = entries.begin() ;
+         iEntry != entries.end() ;
+         ++iEntry )
+    {
+      std::string text = boost::trim_copy( *iEntry ) ;
+      if( text.empty() )
+      {
+        continue ;
+      }
+
+      std::vector< std::string > words ;
+      boost::split( words, text, boost::is_any_of( " \t" ),
+                    boost::token_compress_on ) ;
+      if( words.size() != 2 )
+      {
+        throw UT::ConfigError( "Trading schedule entry must be HH:MM phase, not "
+                               + text ) ;
+      }
+
+      Entry entry ;
+      try
+      {
+        entry.from = boost::posix_time::duration_from_string( words[0] ) ;
+      }
+      catch( std::exception &e )
+      {
+        throw UT::ConfigError( "Invalid time in trading schedule : " + words[0] ) ;
+      }
+      entry.tradingPhase = toTradingPhase( words[1] ) ;
+
+      if( !_entries.empty() && _entries.back().from >= entry.from )
+      {
+        throw UT::ConfigError( "Trading schedule times must be ascending" ) ;
+      }
+      _entries.push_back( entry ) ;
+    }
+  }
+
+  TradingPhase TradingSchedule::getPhaseAt(
+      const boost::posix_time::time_duration &timeOfDay ) const
+  {
+    if( _entries.empty() )
+    {
+      return TradingPhase_CONTINUOUS ;
+    }
+
+    TradingPhase tradingPhase = _entries.back().tradingPhase ;
+    for( std::vector< Entry >::const_iterator iEntry = _entries.begin() ;
+         iEntry != _entries.end() && iEntry->from <= timeOfDay ;
+         ++iEntry )
+    {
+      tradingPhase = iEntry->tradingPhase ;
+    }
+    return tradingPhase ;
+  }
+
+  bool TradingSchedule::getSessionEnd(
+      boost::posix_time::time_duration &sessionEnd ) const
+  {
+    for( std::vector< Entry >::const_iterator iEntry = _entries.begin() ;
+         iEntry != _entries.end() ;
+         ++iEntry )
+    {
+      if( iEntry->tradingPhase == TradingPhase_CLOSED )
+      {
+        sessionEnd = iEntry->from ;
+        return true ;
+      }
+    }
+    return false ;
+  }
+
+  TradingPhase TradingSchedule::toTradingPhase( const std::string &name )
+  {
+    if( name == "call" )
+    {
+      return TradingPhase_CALL_AUCTION ;
+    }
+    else if( name == "continuous" )
+    {
+      return TradingPhase_CONTINUOUS ;
+    }
+    else if( name == "closed" )
+    {
+      return TradingPhase_CLOSED ;
+    }
+    throw UT::ConfigError( "Unknown trading phase " + name
+                           + ", use call, continuous or closed" ) ;
+  }
+
+  const char *TradingSchedule::toString( TradingPhase tradingPhase )
+  {
+    switch( tradingPhase )
+    {
+      case TradingPhase_CALL_AUCTION :
+        return "call" ;
+      case TradingPhase_CONTINUOUS :
+        return "continuous" ;
+      case TradingPhase_CLOSED :
+        return "closed" ;
+    }
+    return "unknown" ;
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef ESM_TRADING_SCHEDULE_H
+#define ESM_TRADING_SCHEDULE_H
+
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "structures.h"
+
+namespace ESM
+{
+  /**
+   * \class TradingSchedule
+   *
+   * The trading phases of a day, each from a local time until the next
+   * one, e.g.
+   *
+   *   09:00 call, 09:15 continuous, 15:20 call, 15:30 closed
+   *
+   * for an opening auction, continuous trading and a closing auction.
+   * Before the first entry the day is still in the phase of the last one.
+   * An empty schedule trades continuously all day.
+   *
+   */
+  class TradingSchedule
+  {
+    public :
+      TradingSchedule() {}
+
+      /**
+       * @brief Parse a schedule. Throws UT::ConfigError if an entry is not
+       * "HH:MM phase" or the times are not ascending.
+       *
+       * @param Comma separated entries. Phases are call, continuous &
+       *        closed.
+       */
+      explicit TradingSchedule( const std::string &schedule ) ;
+
+      /**
+       * @brief The phase at a time of day.
+       */
+      TradingPhase getPhaseAt(
+          const boost::posix_time::time_duration &timeOfDay ) const ;
+
+      bool empty() const { return _entries.empty() ; }
+
+      /**
+       * @brief The time of day the market first closes, when DAY orders
+       * expire.
+       *
+       * @param Set to the time of the first closed entry.
+       *
+       * @return False if the schedule never closes.
+       */
+      bool getSessionEnd( boost::posix_time::time_duration &sessionEnd ) const ;
+
+      /**
+       * @brief Convert between a phase and its name in the schedule.
+       */
+      static TradingPhase toTradingPhase( const std::string &name ) ;
+      static const char *toString( TradingPhase tradingPhase ) ;
+
+    private :
+      struct Entry
+      {
+        boost::posix_time::time_duration from ;
+        TradingPhase tradingPhase ;
+      };
+      std::vector< Entry > _entries ;
+  };
+}
+
+#endif // ESM_TRADING_SCHEDULE_H
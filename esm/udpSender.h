@@ -5,8 +5,10 @@
 #include <cstring>
 #include <iostream>
 #include <boost/asio.hpp>
+#include <boost/thread/mutex.hpp>
 
-#include "structures.h"
+#include "marketDataPublisher.h"
+#include "marketDataWire.h"
 
 using boost::asio::ip::udp;
 
@@ -17,8 +19,13 @@ namespace ESM
    *
    * \brief Sends market data for the matching engine on UDP
    *
+   * The datagram is encoded in place by the codec generated from
+   * configs/marketDataWire.xml: little endian and packed, whatever the
+   * host, with the version of the schema in the header. Each market
+   * picture thread encodes in its own buffer; only the send is serialised.
+   *
    */
-  class UdpSender
+  class UdpSender : public MarketDataPublisher
   {
     public :
       /**
@@ -44,16 +51,23 @@ namespace ESM
        */
       void send( const MarketPicture &message )
       {
-        try
-        {
-          _socket->send_to(
-            boost::asio::buffer( &message, message.getMsgLen() + 8 ),
-            *_iterator ) ;
-        }
-        catch (std::exception& e)
-        {
-          std::cerr << "Exception: " << e.what() << "\n";
-        }
+        char buffer[ Wire::MarketPicture::MaxLength ] ;
+        Wire::MarketPicture wire ;
+        wire.wrapForEncode( buffer ).encode( message ) ;
+        sendBuffer( buffer, wire.getEncodedLength() ) ;
+      }
+
+      /**
+       * \brief send bars on UDP
+       *
+       * @param message
+       */
+      void sendBars( const Bars &message )
+      {
+        char buffer[ Wire::Bars::MaxLength ] ;
+        Wire::Bars wire ;
+        wire.wrapForEncode( buffer ).encode( message ) ;
+        sendBuffer( buffer, wire.getEncodedLength() ) ;
       }
 
       ~UdpSender()
@@ -66,6 +80,21 @@ namespace ESM
       udp::resolver::iterator _iterator ;
 
       boost::asio::io_service _ioService;
+
+      boost::mutex _mutexSocket ;
+
+      void sendBuffer( const char *buffer, size_t length )
+      {
+        try
+        {
+          boost::mutex::scoped_lock lock( _mutexSocket ) ;
+          _socket->send_to( boost::asio::buffer( buffer, length ), *_iterator ) ;
+        }
+        catch (std::exception& e)
+        {
+          std::cerr << "Exception: " << e.what() << "\n";
+        }
+      }
   };
 
 }